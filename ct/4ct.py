@@ -35,6 +35,15 @@
 #                 - Bad: Using this method You can encounter maps for which the method loops indefinitely
 #                 - Good: Now that I know, at least I won't spend more time on this aspect. The other good thing is that this case is very rare, and the program can color almost all maps
 # - 10/Mar/2020 - Coronavirus collateral effects ... back to programming = refactoring
+# - 19/Oct/2026 - Infinite loops of random switches are detected (Zobrist hash of the coloring) and the program escalates: switches to unseen colorings, other choices, shuffles
+# - 19/Oct/2026 - Portfolio mode (-P): all the choices and K seeded shuffles at the same time in a pool of processes, the first good coloring wins
+# - 19/Oct/2026 - Batch mode (-b): color a stream of maps (planar_code, .planar, FGC1 containers) in a pool of processes, one json line per map in input order. cProfile only with --profile
+# - 19/Oct/2026 - The rebuild keeps a Kempe cycle index of the colored graph: F4 and F5 no longer walk the cycles to know if two edges are on the same one
+# - 19/Oct/2026 - The reduction keeps an index of the faces by edge: bridge check of a candidate edge without joining the faces, f2 and the faces to update without searching all faces
+# - 19/Oct/2026 - Maps given as faces (-r2, -p, -b) are checked from the faces (check_planar_representation(), Euler) instead of networkx planarity on the graph
+# - 19/Oct/2026 - Incremental recoloring (IncrementalColoring, option --edits): faces split or merged one at a time, the coloring is repaired locally with half Kempe swaps, rebuilt only if that fails
+# - 19/Oct/2026 - The unexpected conditions of the reduction and of the rebuild raise ValueError instead of exit(-1): a batch map keeps the error in its result, a single map logs it and exits as before
+# - 19/Oct/2026 - Portfolio: the counters are reset at the beginning of each strategy (the workers of the pool are reused), so the winner reports only its own
 #
 # TODOs:
 # - Moved to: https://github.com/stefanutti/maps-coloring-python/issues
@@ -106,11 +115,14 @@ sys.path.append(os.path.join(os.path.dirname(os.path.realpath(__file__)), os.par
 
 import argparse
 import collections
+import itertools
 import time
 import datetime
 import logging
 import logging.config
 import json
+import multiprocessing
+import random
 
 # TODO: Really don't know why random.shuffle works using "import random" and "random.shuffle"
 from random import shuffle
@@ -118,13 +130,14 @@ from random import shuffle
 import networkx as nx
 
 from ct_graph_utils import check_graph_planarity_3_regularity_no_loops
+from ct_graph_utils import check_planar_representation
+from ct_graph_utils import check_planar_representation_3_regularity_no_loops
 from ct_graph_utils import kempe_chain_color_swap
 from ct_graph_utils import graph_dual
 from ct_graph_utils import print_graph
 from ct_graph_utils import is_well_colored
 from ct_graph_utils import get_edge_color
 from ct_graph_utils import is_multiedge
-from ct_graph_utils import check_if_vertex_is_in_face
 from ct_graph_utils import create_graph_from_planar_representation
 from ct_graph_utils import export_graph
 from ct_graph_utils import are_edges_on_the_same_kempe_cycle
@@ -132,10 +145,19 @@ from ct_graph_utils import apply_half_kempe_loop_color_switching
 from ct_graph_utils import remove_vertex_from_face
 from ct_graph_utils import rotate
 from ct_graph_utils import join_faces
-from ct_graph_utils import is_the_graph_one_edge_connected
+from ct_graph_utils import index_faces_by_edge
+from ct_graph_utils import add_face_to_the_index
+from ct_graph_utils import remove_face_from_the_index
+from ct_graph_utils import would_the_graph_be_one_edge_connected
 from ct_graph_utils import get_the_other_colors
 from ct_graph_utils import log_faces
 from ct_graph_utils import faces_by_vertices
+from ct_graph_utils import graph_zobrist_hash
+from ct_graph_utils import apply_kempe_switch_to_an_unseen_coloring
+from ct_graph_utils import read_maps
+from ct_graph_utils import KempeCycleIndex
+from ct_graph_utils import graph_kempe_cycle_index
+from ct_graph_utils import color_the_edge_with_a_kempe_chain_swap
 
 # Import helper functions for Sage-like API
 from ct_graph_utils import graph_edges_incident
@@ -143,6 +165,7 @@ from ct_graph_utils import graph_edges_incident_no_labels
 from ct_graph_utils import graph_edges
 from ct_graph_utils import graph_add_edge
 from ct_graph_utils import graph_delete_edge
+from ct_graph_utils import graph_delete_vertex
 from ct_graph_utils import graph_set_edge_label
 from ct_graph_utils import graph_random_edge
 from ct_graph_utils import graph_edge_iterator
@@ -153,11 +176,26 @@ from ct_graph_utils import create_networkx_graph
 
 from ct.converters.ct_create_random_maps_from_2v import PlanarGraphGenerator
 
+import numpy
 from numpy.random import randint
 
 import cProfile
 import pstats
 
+# All the orders for the selection of the faces to reduce (option -c)
+ALL_CHOICES = [2345, 2354, 2435, 2453, 2534, 2543]
+
+# Escalation for infinite loops: switches for a single F5 before giving up on the current choices, and how many shuffles to try after all the choices
+MAX_KEMPE_SWITCHES_PER_STEP = 1000
+NUMBER_OF_SHUFFLES_ON_LOOPS = 3
+
+# Batch mode: maps sent to a process at a time, and chunks read from the input before waiting for their results (it bounds the memory used for long streams)
+BATCH_CHUNK_SIZE = 16
+BATCH_CHUNKS_PER_WINDOW = 64
+
+# Incremental recoloring of edited maps: random Kempe switches for a single edit before giving up and rebuilding the coloring from scratch
+MAX_KEMPE_SWITCHES_PER_EDIT = 100
+
 
 ######
 ######
@@ -197,6 +235,16 @@ import pstats
 ######
 ######
 
+class InfiniteKempeLoop(Exception):
+    """
+    The restore of an F5 keeps switching Kempe cycles without an end: the map has to be reduced and rebuilt in another way.
+    """
+
+    def __init__(self, the_colored_graph):
+        super().__init__("Infinite loop of Kempe switches")
+        self.the_colored_graph = the_colored_graph
+
+
 def initialize_statistics():
     """
     Initialize statistics.
@@ -220,6 +268,16 @@ def initialize_statistics():
     stats['TOTAL_RANDOM_KEMPE_SWITCHES'] = 0
     stats['MAX_RANDOM_KEMPE_SWITCHES'] = 0
 
+    stats['LOOPS_DETECTED'] = 0
+    stats['ESCALATION_ALTERNATIVE_SWITCHES'] = 0
+    stats['ESCALATION_ROTATE_CHOICES'] = 0
+    stats['ESCALATION_SHUFFLE'] = 0
+
+    stats['EDITS_RECOLORED_LOCALLY'] = 0
+    stats['EDITS_FULL_REBUILDS'] = 0
+    stats['EDITS_REJECTED'] = 0
+    stats['EDITS_RANDOM_KEMPE_SWITCHES'] = 0
+
     stats['time_GRAPH_CREATION_BEGIN'] = 0
     stats['time_GRAPH_CREATION_END'] = 0
 
@@ -350,8 +408,7 @@ def ariadne_case_f3(the_colored_graph, ariadne_step):
 
     # Checkpoint
     if previous_edge_color_at_v1 == previous_edge_color_at_v2:
-        logger.error("Unexpected condition (for F3 faces two edges have a vertex in common, and so colors MUST be different at this point). Mario you'd better go back to paper")
-        exit(-1)
+        raise ValueError("Unexpected condition (for F3 faces two edges have a vertex in common, and so colors MUST be different at this point). Mario you'd better go back to paper")
 
     # Choose a different color
     new_edge_color = get_the_other_colors([previous_edge_color_at_v1, previous_edge_color_at_v2])[0]
@@ -440,8 +497,7 @@ def ariadne_case_f4(the_colored_graph, ariadne_step):
         if is_multiedge(the_colored_graph, vertex_to_join_near_v1_on_the_face, vertex_to_join_near_v2_on_the_face):
             graph_delete_edge(the_colored_graph, vertex_to_join_near_v1_on_the_face, vertex_to_join_near_v2_on_the_face, edge_color_of_top_edge)
             graph_add_edge(the_colored_graph, vertex_to_join_near_v1_on_the_face, vertex_to_join_near_v2_on_the_face, previous_edge_color_at_v1)
-            logger.error("HERE?")  # This is only to verify if this condition may happen ... and my reasoning was wrong :-(
-            exit(-1)
+            raise ValueError("Unexpected condition (the top edge of the F4 is a multiedge)")  # This is only to verify if this condition may happen ... and my reasoning was wrong :-(
         else:
             graph_set_edge_label(the_colored_graph, vertex_to_join_near_v1_on_the_face, vertex_to_join_near_v2_on_the_face, previous_edge_color_at_v1)
 
@@ -499,8 +555,7 @@ def ariadne_case_f4(the_colored_graph, ariadne_step):
             if is_multiedge(the_colored_graph, vertex_to_join_near_v1_on_the_face, vertex_to_join_near_v2_on_the_face):
                 graph_delete_edge(the_colored_graph, vertex_to_join_near_v1_on_the_face, vertex_to_join_near_v2_on_the_face, edge_color_of_top_edge)
                 graph_add_edge(the_colored_graph, vertex_to_join_near_v1_on_the_face, vertex_to_join_near_v2_on_the_face, previous_edge_color_at_v1)
-                logger.error("HERE?")  # This is only to verify if this condition is real
-                exit(-1)
+                raise ValueError("Unexpected condition (the top edge of the F4 is a multiedge)")  # This is only to verify if this condition is real
             else:
                 graph_set_edge_label(the_colored_graph, vertex_to_join_near_v1_on_the_face, vertex_to_join_near_v2_on_the_face, previous_edge_color_at_v1)
 
@@ -562,8 +617,12 @@ def ariadne_case_f5(the_colored_graph, ariadne_step):
     #   - First try a swap starting from an edge on the face
     #   - Then try a swap starting from a random edge of the kempe loop on v1
     #   - Then try a swap starting from a random edge of the entire graph
+    #
+    # Loop detection: the colorings already tried for this step are kept as Zobrist hashes. When one comes back, only switches to unseen colorings are used
     end_of_f5_restore = False
     i_attempt = 0
+    seen_colorings = set()
+    use_unseen_switches = False
     while end_of_f5_restore is False:
 
         # For F5 to compute the new colors is difficult (and needs to be proved if always works in all cases)
@@ -651,32 +710,44 @@ def ariadne_case_f5(the_colored_graph, ariadne_step):
             stats['TOTAL_RANDOM_KEMPE_SWITCHES'] += 1
             i_attempt += 1
 
-            random_edge_to_fix_the_impasse = graph_random_edge(the_colored_graph, labels=True)
-            color_of_the_random_edge = get_edge_color(the_colored_graph, random_edge_to_fix_the_impasse)
-            another_random_color = get_the_other_colors([color_of_the_random_edge])[randint(0, 1)]
+            # Have I already been here (same step, same coloring)?
+            coloring_hash = graph_zobrist_hash(the_colored_graph)
+            if coloring_hash in seen_colorings:
+                stats['LOOPS_DETECTED'] += 1
+                if logger.isEnabledFor(logging.DEBUG): logger.debug("Loop detected: coloring %x already seen (attempt %s)", coloring_hash, i_attempt)
 
-            if logger.isEnabledFor(logging.DEBUG): logger.debug("Selected Edge: %s (swap_c1: %s, swap_c2: %s)", random_edge_to_fix_the_impasse, color_of_the_random_edge, another_random_color)
+                # First escalation: from now on, only switches that give colorings not seen yet
+                if use_unseen_switches is False:
+                    use_unseen_switches = True
+                    stats['ESCALATION_ALTERNATIVE_SWITCHES'] += 1
+            seen_colorings.add(coloring_hash)
 
-            # No need to swap if the selected face belongs to an F2. Hence if it is not, try a random Kempe switch
-            # TODO: In case of multiedge as the random edge chosen, select the colors carefully
-            if is_multiedge(the_colored_graph, random_edge_to_fix_the_impasse[0], random_edge_to_fix_the_impasse[1]) is False:
+            if use_unseen_switches is True:
 
-                # Apply an entire cycle color switching
-                if logger.isEnabledFor(logging.DEBUG): logger.debug("Before kempe_chain_color_swap - is_well_colored?: %s and (c1: %s, c2: %s)", is_well_colored(the_colored_graph), color_of_the_random_edge, another_random_color)
-                kempe_chain_color_swap(the_colored_graph, random_edge_to_fix_the_impasse, color_of_the_random_edge, another_random_color)
-                if logger.isEnabledFor(logging.DEBUG): logger.debug("After kempe_chain_color_swap - is_well_colored?: %s and (c1: %s, c2: %s)", is_well_colored(the_colored_graph), color_of_the_random_edge, another_random_color)
+                # All the switches lead to colorings already seen: this step cannot be solved this way
+                if apply_kempe_switch_to_an_unseen_coloring(the_colored_graph, seen_colorings) is False:
+                    raise InfiniteKempeLoop(the_colored_graph)
             else:
-                if logger.isEnabledFor(logging.DEBUG): logger.debug("The selected random edge it is a multiedge")
+                random_edge_to_fix_the_impasse = graph_random_edge(the_colored_graph, labels=True)
+                color_of_the_random_edge = get_edge_color(the_colored_graph, random_edge_to_fix_the_impasse)
+                another_random_color = get_the_other_colors([color_of_the_random_edge])[randint(0, 1)]
+
+                if logger.isEnabledFor(logging.DEBUG): logger.debug("Selected Edge: %s (swap_c1: %s, swap_c2: %s, cycle of %s edges)", random_edge_to_fix_the_impasse, color_of_the_random_edge, another_random_color, graph_kempe_cycle_index(the_colored_graph).cycle_length(random_edge_to_fix_the_impasse, color_of_the_random_edge, another_random_color))
 
-            # Only for debug: which map is causing this impasse?
-            if i_attempt == 1000:
-                export_graph(the_colored_graph, "debug/debug.really_bad_case_infinite_loop")
-                logger.error("ERROR: Infinite loop. Chech the debug.really_bad_case.* files")
-                logger.error("Try to shuffle the faces at the beginning: sage 4ct.py -p debug/debug.previous_run.planar -c <USE the same sequence you used the previous run> -s")
+                # No need to swap if the selected face belongs to an F2. Hence if it is not, try a random Kempe switch
+                # TODO: In case of multiedge as the random edge chosen, select the colors carefully
+                if is_multiedge(the_colored_graph, random_edge_to_fix_the_impasse[0], random_edge_to_fix_the_impasse[1]) is False:
+
+                    # Apply an entire cycle color switching
+                    if logger.isEnabledFor(logging.DEBUG): logger.debug("Before kempe_chain_color_swap - is_well_colored?: %s and (c1: %s, c2: %s)", is_well_colored(the_colored_graph), color_of_the_random_edge, another_random_color)
+                    kempe_chain_color_swap(the_colored_graph, random_edge_to_fix_the_impasse, color_of_the_random_edge, another_random_color)
+                    if logger.isEnabledFor(logging.DEBUG): logger.debug("After kempe_chain_color_swap - is_well_colored?: %s and (c1: %s, c2: %s)", is_well_colored(the_colored_graph), color_of_the_random_edge, another_random_color)
+                else:
+                    if logger.isEnabledFor(logging.DEBUG): logger.debug("The selected random edge it is a multiedge")
 
-                # This is used as a sentinel to use the runs.bash script
-                open("debug/error.txt", 'a').close()
-                exit(-1)
+            # Too many switches (even without loops detected): give up with this reduction (see reduce_and_rebuild_faces())
+            if i_attempt == MAX_KEMPE_SWITCHES_PER_STEP:
+                raise InfiniteKempeLoop(the_colored_graph)
 
             # TODO: if is_well_colored(the_colored_graph) is False:
             #     print_graph(the_colored_graph)
@@ -691,13 +762,14 @@ def ariadne_case_f5(the_colored_graph, ariadne_step):
     if logger.isEnabledFor(logging.DEBUG): logger.debug("END: restore an F5: %s", stats['TOTAL_RANDOM_KEMPE_SWITCHES'])
 
 
-def select_edge_to_remove(g_faces, choices, i_global_counter):
+def select_edge_to_remove(g_faces, faces_by_edge, choices, i_global_counter):
     """
     Select an edge, that if removed doesn't have to leave the graph as 1-edge-connected.
 
     Parameters
     ----------
         g_faces: The entire graph from which the edge has to be selected
+        faces_by_edge: The index of the faces of g_faces by edge (see index_faces_by_edge())
         choices: 2 + the permutations of 3 4 5
         i_global_counter: for debugging
 
@@ -739,8 +811,7 @@ def select_edge_to_remove(g_faces, choices, i_global_counter):
     elif choices == 2543:
         f1 = next((f for f in g_faces if len(f) == 2), next((f for f in g_faces if len(f) == 5), next((f for f in g_faces if len(f) == 4), next((f for f in g_faces if len(f) == 3), g_faces[0]))))
     else:
-        logger.error("Value for choices (%s) not expected", choices)
-        exit(-1)
+        raise ValueError("Value for choices (%s) not expected" % choices)
 
     len_of_the_face_to_reduce = len(f1)
 
@@ -772,25 +843,19 @@ def select_edge_to_remove(g_faces, choices, i_global_counter):
         # - Can this be used only if the graph was created by me from the "base" graph?
         #   commented: if ((edge_to_remove[0] not in [0, 1, 2, 3]) and (edge_to_remove[1] not in [0, 1, 2, 3]) and (edge_to_remove not in g_faces[-1]) and (rotated_edge_to_remove not in g_faces[-1])):
 
-        # If F2, the rotated edge appears twice in the list of faces
-        if len_of_the_face_to_reduce == 2:
-
-            # For F2 faces, edges will appear twice in all the edges lists of all faces
-            temp_f2 = [face for face in g_faces if rotated_edge_to_remove in face]
-            temp_f2.remove(f1)
-            f2 = temp_f2[0]
-            f1_plus_f2_temp = join_faces(f1, f2, edge_to_remove)
-        else:
-            f2 = next(face for face in g_faces if rotated_edge_to_remove in face)
-            f1_plus_f2_temp = join_faces(f1, f2, edge_to_remove)
+        # f2 is the face on the other side of the edge (the index gives it without searching all faces)
+        # If F2, the rotated edge appears twice in the list of faces: one is in f1 itself
+        f2 = next(face for face in faces_by_edge[rotated_edge_to_remove] if face is not f1)
 
         # The resulting graph is 1-edge-connected if the new face has an edge that does not divide two countries, but separates a portion of the same land
-        if is_the_graph_one_edge_connected(f1_plus_f2_temp) is True:
+        # It happens if f1 and f2 share also another edge: f1 and f2 are joined only for the edge that will be removed
+        if would_the_graph_be_one_edge_connected(faces_by_edge, f1, f2) is True:
 
             # Skip to the next edge, this is not good
             i_edge += 1
         else:
             is_the_edge_to_remove_found = True
+            f1_plus_f2_temp = join_faces(f1, f2, edge_to_remove)
 
             if logger.isEnabledFor(logging.DEBUG):
                 logger.debug("Edge to remove found :-) %s", edge_to_remove)
@@ -884,7 +949,8 @@ def create_from_random2(number_of_faces, shuffle_the_planar_representation):
     # the_graph.allow_multiple_edges(True)
     # the_graph.relabel()
 
-    check_graph_planarity_3_regularity_no_loops(the_graph)
+    # The faces are already an embedding: checked from the faces, without a planarity algorithm on the graph
+    check_planar_representation_3_regularity_no_loops(g_faces)
 
     # I need this (export + import) to be able to reproduce this test exactly in the same condition in a second run
     # The export function saves the graph using a different order for the edges (even if the graph are exactly the same graph)
@@ -1067,10 +1133,10 @@ def create_from_planar(planar_filename, shuffle_the_planar_representation, line_
     if shuffle_the_planar_representation:
         shuffle(g_faces)
 
-    # I need the graph here only to check_graph_at_beginning
-    the_graph = create_graph_from_planar_representation(g_faces)
+    # The faces are already an embedding: checked from the faces, without a planarity algorithm on the graph
+    check_planar_representation_3_regularity_no_loops(g_faces)
 
-    check_graph_planarity_3_regularity_no_loops(the_graph)
+    the_graph = create_graph_from_planar_representation(g_faces)
 
     logger.info("END: Load the planar embedding of a graph (output of the gfaces() function): %s (line: %s)", planar_filename, line_number + 1)
 
@@ -1115,7 +1181,7 @@ def create_from_planar(planar_filename, shuffle_the_planar_representation, line_
 ######
 ######
 
-def reduce_faces(g_faces, choices):
+def reduce_faces(g_faces, choices, save_f_distribution=True):
     """
     Method similar to the Kempe reduction "patching" method.\n
     For each loop remove an edge from a face <= F5, until the graph will have only three faces (an island with two lands)
@@ -1124,6 +1190,7 @@ def reduce_faces(g_faces, choices):
     ----------
         g_faces: The planar representation of the graph
         choices: The selection method for the edges
+        save_f_distribution: Append the distribution of Fs to debug/debug.f_distribution.json.dump (not done by the portfolio workers)
 
     Returns
     -------
@@ -1146,7 +1213,7 @@ def reduce_faces(g_faces, choices):
     i_global_counter = 0
 
     # Open the file to append the rows with the changing distribution during the reduction phase
-    f_distribution = open("debug/debug.f_distribution.json.dump", "a")
+    f_distribution = open("debug/debug.f_distribution.json.dump" if save_f_distribution else os.devnull, "a")
 
     # If the graph is already reduced (2 vertices and 3 edges = 3 faces, included the ocean)
     if len(g_faces) == 3:
@@ -1155,6 +1222,10 @@ def reduce_faces(g_faces, choices):
         is_the_end_of_the_reduction_process = True
         if logger.isEnabledFor(logging.DEBUG): logger.debug("The graph is already reduced")
 
+    # Index of the faces by edge: the face on the other side of an edge, in O(1) instead of a search on all faces
+    # It is kept up to date every time a face is removed, added or changed
+    faces_by_edge = index_faces_by_edge(g_faces)
+
     while is_the_end_of_the_reduction_process is False:
 
         logger.info("BEGIN %s: Main loop", i_global_counter)
@@ -1167,18 +1238,17 @@ def reduce_faces(g_faces, choices):
         f1 = []
         f2 = []
         edge_to_remove = ()
-        f1_plus_f2_temp = []  # It is used to speed up computation. At the beginning is used to see it the graph is_the_graph_one_edge_connected() and then reused
+        f1_plus_f2_temp = []  # It is used to speed up computation. f1 and f2 joined by select_edge_to_remove() only for the selected edge
 
         # Select an edge from the graph
         # This is one of the most important function to work on, to apply different strategies
-        edge_to_remove, f1, f2, f1_plus_f2_temp = select_edge_to_remove(g_faces, choices, i_global_counter)
+        edge_to_remove, f1, f2, f1_plus_f2_temp = select_edge_to_remove(g_faces, faces_by_edge, choices, i_global_counter)
 
         # Check if math is right :-) An edge to remove must exist
         if edge_to_remove == ():
-            logger.error("Unexpected condition (a suitable edge has not been found). Mario you'd better go back to paper")
             logger.info("TODO: For now I considered only the first selected face < F6. I may search the right edge in other faces < F6")
             logger.info("TODO: Should be easier to prove that among all faces < F6, an edge exists that if removed does not make the graph 1-edge-connected")
-            exit(-1)
+            raise ValueError("Unexpected condition (a suitable edge has not been found). Mario you'd better go back to paper")
 
         # What kind of face am I reducing (I need only f1, f2 is only for debugging ... for now)
         len_of_the_face_to_reduce_f1 = len(f1)
@@ -1208,6 +1278,9 @@ def reduce_faces(g_faces, choices):
             g_faces.remove(f1)
             g_faces.remove(f2)
             g_faces.insert(-1, f1_plus_f2_temp)
+            remove_face_from_the_index(faces_by_edge, f1)
+            remove_face_from_the_index(faces_by_edge, f2)
+            add_face_to_the_index(faces_by_edge, f1_plus_f2_temp)
 
             # Update the statistics for the distribution of Fs
             if len(f1_plus_f2_temp) in stats['F#'].keys():
@@ -1218,13 +1291,16 @@ def reduce_faces(g_faces, choices):
             # I already prepared f1 and f2, but when these two faces are joined also the other face that has the two vertices has to be updated
             # A vertex is shared by three faces (two of these are f1 and f2). For this F2 case, the two vertices belong to only a third face
             # NOTE: For F3, F4, F5 ... v1 and v2 may have two different faces (other than f1 and f2)
-            third_face_to_update = next(face for face in g_faces if check_if_vertex_is_in_face(face, v1))
+            # f2 has (v1, vertex_to_join_near_v1), the third face has the same edge in the other direction
+            third_face_to_update = faces_by_edge[(vertex_to_join_near_v1, v1)][0]
 
             # Update the statistics for the distribution of Fs
             stats['F#'][len(third_face_to_update)] -= 1
 
+            remove_face_from_the_index(faces_by_edge, third_face_to_update)
             remove_vertex_from_face(third_face_to_update, v1)
             remove_vertex_from_face(third_face_to_update, v2)  # For this F2 case, the two vertices belong to only a third face
+            add_face_to_the_index(faces_by_edge, third_face_to_update)
 
             # Update the statistics for the distribution of Fs
             if len(third_face_to_update) in stats['F#'].keys():
@@ -1269,6 +1345,9 @@ def reduce_faces(g_faces, choices):
             g_faces.remove(f1)
             g_faces.remove(f2)
             g_faces.insert(-1, f1_plus_f2_temp)
+            remove_face_from_the_index(faces_by_edge, f1)
+            remove_face_from_the_index(faces_by_edge, f2)
+            add_face_to_the_index(faces_by_edge, f1_plus_f2_temp)
 
             # Update the statistics for the distribution of Fs
             if len(f1_plus_f2_temp) in stats['F#'].keys():
@@ -1279,8 +1358,9 @@ def reduce_faces(g_faces, choices):
             # I already prepared f1 and f2, but when these two faces are joined also the other faces that has the two vertices have to be updated
             # A vertex is shared by three faces (two of these are f1 and f2)
             # NOTE: For F3, F4, F5 ... v1 and v2, most of the times will have f3 and f4 different ... but they can also be the same face
-            third_face_to_update = next(face for face in g_faces if check_if_vertex_is_in_face(face, v1))
-            fourth_face_to_update = next(face for face in g_faces if check_if_vertex_is_in_face(face, v2))
+            # f1 has (vertex_to_join_near_v1_on_the_face, v1) and (v2, vertex_to_join_near_v2_on_the_face), the other faces have the same edges in the other direction
+            third_face_to_update = faces_by_edge[(v1, vertex_to_join_near_v1_on_the_face)][0]
+            fourth_face_to_update = faces_by_edge[(vertex_to_join_near_v2_on_the_face, v2)][0]
             if logger.isEnabledFor(logging.DEBUG): logger.debug("third_face_to_update: %s", third_face_to_update)
             if logger.isEnabledFor(logging.DEBUG): logger.debug("fourth_face_to_update: %s", fourth_face_to_update)
 
@@ -1291,8 +1371,14 @@ def reduce_faces(g_faces, choices):
                 stats['F#'][len(third_face_to_update)] -= 1
                 stats['F#'][len(fourth_face_to_update)] -= 1
 
+            remove_face_from_the_index(faces_by_edge, third_face_to_update)
+            if fourth_face_to_update is not third_face_to_update:
+                remove_face_from_the_index(faces_by_edge, fourth_face_to_update)
             remove_vertex_from_face(third_face_to_update, v1)
             remove_vertex_from_face(fourth_face_to_update, v2)
+            add_face_to_the_index(faces_by_edge, third_face_to_update)
+            if fourth_face_to_update is not third_face_to_update:
+                add_face_to_the_index(faces_by_edge, fourth_face_to_update)
 
             # Update the statistics for the distribution of Fs
             if third_face_to_update == fourth_face_to_update:
@@ -1392,13 +1478,15 @@ def rebuild_faces(g_faces, ariadne_s_thread):
     # WARNING: the color of the edges of a multiedge graph cannot be changed, so during the process it is necessary to delete and re-insert edges
     the_colored_graph = create_networkx_graph()  # Creates nx.MultiGraph
 
+    # The Kempe cycles are indexed while the edges are restored: F4 and F5 ask if two edges are on the same cycle without walking it
+    the_colored_graph.graph['kempe_cycle_index'] = KempeCycleIndex(the_colored_graph)
+
     # Only 2 vertices have to be in the graph
     all_vertices = [element for face in g_faces for edge in face for element in edge]
     all_vertices = sorted(set(all_vertices))
 
     if len(all_vertices) != 2:
-        logger.error("Unexpected condition (vertices left are not 2). Mario you'd better go back to paper")
-        exit(-1)
+        raise ValueError("Unexpected condition (vertices left are not 2). Mario you'd better go back to paper")
 
     # Aliases
     v1 = all_vertices[0]
@@ -1463,13 +1551,199 @@ def rebuild_faces(g_faces, ariadne_s_thread):
     return the_colored_graph
 
 
-def init_f_distribution(g_faces):
+def give_up_on_infinite_loop(the_colored_graph, number_of_shuffles):
+    """
+    All strategies ended in infinite loops: save the graph for debugging and exit.
+
+    Parameters
+    ----------
+        the_colored_graph: The graph of the last strategy, as it was when it gave up
+        number_of_shuffles: How many shuffles have been tried (for the message)
+    """
+
+    # Only for debug: which map is causing this impasse?
+    export_graph(the_colored_graph, "debug/debug.really_bad_case_infinite_loop")
+    logger.error("ERROR: Infinite loop. Chech the debug.really_bad_case.* files")
+    logger.error("All choices and %s shuffles have been tried: sage 4ct.py -p debug/debug.previous_run.planar -s", number_of_shuffles)
+
+    # This is used as a sentinel to use the runs.bash script
+    open("debug/error.txt", 'a').close()
+    exit(-1)
+
+
+def color_with_a_portfolio_strategy(strategy):
+    """
+    Portfolio worker: reduce and rebuild its own copy of the faces with a single strategy (no escalation).\n
+    The worker is a forked process, so portfolio_g_faces is a copy-on-write copy of that of the parent.
+    A worker of the pool runs several strategies one after the other: the counters are reset at the beginning of each one (only F-Initial#, the one of the parent, is kept), so the stats returned are those of this strategy alone.
+
+    Parameters
+    ----------
+        strategy: (name, choices, seed). With a seed, the faces are shuffled with it. The seed is also used for the random switches
+
+    Returns
+    -------
+        (name, the_colored_graph, is_colored, seconds, stats). If the strategy looped, is_colored is False and the graph is as it was when it gave up
+    """
+
+    name, choices, seed = strategy
+    time_begin = time.time()
+
+    # Nothing left from the strategies run before by this worker
+    f_initial = stats['F-Initial#']
+    initialize_statistics()
+    stats['F-Initial#'] = f_initial
+    stats['F#'] = f_initial.copy()
+
+    random.seed(seed)
+    numpy.random.seed(seed)
+
+    g_faces = [list(face) for face in portfolio_g_faces]
+    if seed is not None:
+        random.Random(seed).shuffle(g_faces)
+
+    try:
+        ariadne_s_thread = reduce_faces(g_faces, choices, save_f_distribution=False)
+        the_colored_graph = rebuild_faces(g_faces, ariadne_s_thread)
+        is_colored = is_well_colored(the_colored_graph)
+    except InfiniteKempeLoop as infinite_loop:
+        the_colored_graph = infinite_loop.the_colored_graph
+        is_colored = False
+
+    return name, the_colored_graph, is_colored, time.time() - time_begin, stats
+
+
+def init_portfolio_worker():
+    """
+    The workers only log warnings and errors: the steps of all the strategies together would be unreadable.
+    """
+
+    logger.setLevel(logging.WARNING)
+
+
+def reduce_and_rebuild_faces_portfolio(g_faces, choices, number_of_shuffles, number_of_processes):
+    """
+    Color the map with a portfolio of strategies at the same time: all the orders of choices, plus number_of_shuffles shuffles (seeds 1, 2, ...) with the given choices.\n
+    The first good coloring wins and the other strategies are terminated.
+    The stats of the winner are copied, and the time of every strategy that finished is in stats['PORTFOLIO_SECONDS'].
+
+    Parameters
+    ----------
+        g_faces: The planar representation of the graph
+        choices: The choices used for the shuffles
+        number_of_shuffles: How many shuffled strategies
+        number_of_processes: Size of the pool
+
+    Returns
+    -------
+        the_colored_graph: The colored graph
+    """
+
+    global portfolio_g_faces
+
+    logger.info("BEGIN: Portfolio (%s choices + %s shuffles, %s processes)", len(ALL_CHOICES), number_of_shuffles, number_of_processes)
+
+    # Forked workers see this as it is now
+    portfolio_g_faces = g_faces
+
+    strategies = [(str(strategy_choices), strategy_choices, None) for strategy_choices in ALL_CHOICES]
+    strategies += [("%s-shuffle-%s" % (choices, seed), choices, seed) for seed in range(1, number_of_shuffles + 1)]
+
+    the_colored_graph = None
+    the_looping_graph = None
+    stats['PORTFOLIO_SECONDS'] = {}
+    stats['time_ELABORATION_BEGIN'] = time.ctime()
+    time_begin = time.time()
+
+    # Leaving the "with" terminates the pool, and so the strategies still running
+    with multiprocessing.get_context("fork").Pool(number_of_processes, initializer=init_portfolio_worker) as pool:
+        for name, strategy_graph, is_colored, seconds, strategy_stats in pool.imap_unordered(color_with_a_portfolio_strategy, strategies):
+            stats['PORTFOLIO_SECONDS'][name] = round(seconds, 3)
+            if is_colored is False:
+                the_looping_graph = strategy_graph
+                logger.warning("Portfolio: strategy %s looped (%.3f s)", name, seconds)
+                continue
+
+            # The counters of the winner (its copy of the stats)
+            the_colored_graph = strategy_graph
+            for stat in strategy_stats:
+                if not stat.startswith("time_") and not stat.startswith("PORTFOLIO_"):
+                    stats[stat] = strategy_stats[stat]
+            stats['PORTFOLIO_WINNER'] = name
+            portfolio_wins[name] += 1
+            logger.info("Portfolio: strategy %s wins (%.3f s, %.3f s since the beginning)", name, seconds, time.time() - time_begin)
+            break
+
+    stats['time_ELABORATION_END'] = time.ctime()
+    stats['time_ELABORATION'] = int(time.time() - time_begin)
+
+    if the_colored_graph is None:
+        give_up_on_infinite_loop(the_looping_graph, number_of_shuffles)
+
+    logger.info("END: Portfolio")
+
+    return the_colored_graph
+
+
+def reduce_and_rebuild_faces(g_faces, choices, save_f_distribution=True):
+    """
+    Reduce and rebuild the map, escalating when the rebuild gets stuck in an infinite loop of Kempe switches.\n
+    The F5 restore itself first tries switches to colorings not seen yet. If it gives up (InfiniteKempeLoop), the map is reduced again:
+    - with the other orders of choices (the list of all choices rotated to start from the given one)
+    - then with the faces shuffled, NUMBER_OF_SHUFFLES_ON_LOOPS times
+    Each escalation is counted in the stats. If all of them loop, the last InfiniteKempeLoop is raised.
+
+    Parameters
+    ----------
+        g_faces: The planar representation of the graph
+        choices: The selection method for the edges
+        save_f_distribution: Append the distribution of Fs to debug/debug.f_distribution.json.dump (not done in batch mode)
+
+    Returns
+    -------
+        the_colored_graph: The colored graph
+    """
+
+    # reduce_faces() changes the faces, so keep a copy for the next attempts
+    original_g_faces = [list(face) for face in g_faces]
+
+    strategies = [(strategy_choices, False) for strategy_choices in rotate(ALL_CHOICES, ALL_CHOICES.index(choices))]
+    strategies += [(choices, True)] * NUMBER_OF_SHUFFLES_ON_LOOPS
+
+    for i_strategy, (strategy_choices, strategy_shuffle) in enumerate(strategies):
+
+        if i_strategy > 0:
+            g_faces = [list(face) for face in original_g_faces]
+            if strategy_shuffle:
+                shuffle(g_faces)
+            stats['F#'] = stats['F-Initial#'].copy()
+
+        try:
+            ariadne_s_thread = reduce_faces(g_faces, strategy_choices, save_f_distribution)
+            return rebuild_faces(g_faces, ariadne_s_thread)
+        except InfiniteKempeLoop:
+
+            # Nothing else to try
+            if i_strategy + 1 == len(strategies):
+                raise
+
+            next_choices, next_shuffle = strategies[i_strategy + 1]
+            if next_shuffle:
+                stats['ESCALATION_SHUFFLE'] += 1
+                logger.warning("Infinite loop (choices: %s). Restart with the faces shuffled (choices: %s)", strategy_choices, next_choices)
+            else:
+                stats['ESCALATION_ROTATE_CHOICES'] += 1
+                logger.warning("Infinite loop (choices: %s). Restart with choices: %s", strategy_choices, next_choices)
+
+
+def init_f_distribution(g_faces, save_f_distribution=True):
     """
     Count the number of faces by number of edges. Example: 4 faces F2, 5 faces F3 and so on
 
     Parameters
     ----------
         g_faces: The planar representation of the graph
+        save_f_distribution: Start debug/debug.f_distribution.json.dump with it (not done in batch mode)
     """
 
     for face in g_faces:
@@ -1483,14 +1757,427 @@ def init_f_distribution(g_faces):
     stats['F#'] = dict(sorted(stats['F#'].items()))
     
     # Create and if exist remove the f_distribution_file
-    with open("debug/debug.f_distribution.json.dump", "w") as f_distribution:
-        json.dump(stats['F#'], f_distribution)
-        f_distribution.write("\n")
+    if save_f_distribution:
+        with open("debug/debug.f_distribution.json.dump", "w") as f_distribution:
+            json.dump(stats['F#'], f_distribution)
+            f_distribution.write("\n")
 
     # Save the initial face distribution
     stats['F-Initial#'] = stats['F#'].copy()
 
 
+def color_a_map_of_the_batch(numbered_map):
+    """
+    Batch worker: color one map of the batch.\n
+    The state of a map (stats, graph, faces) is created again for each map, so nothing is left from the previous one.
+    A map that cannot be colored is not a reason to stop the batch: the error is in the result.
+
+    Parameters
+    ----------
+        numbered_map: (i_map, g_faces, choices, shuffle_the_planar_representation)
+
+    Returns
+    -------
+        result: The dict written as a json line: map, colored, seconds, edges ([v1, v2, color]), stats (without the times) and error if any
+    """
+
+    i_map, g_faces, choices, shuffle_the_planar_representation = numbered_map
+    time_begin = time.time()
+
+    initialize_statistics()
+    result = {'map': i_map, 'colored': False}
+
+    try:
+        # Planar cubic map without loops, checked from the faces (json lines can have any faces)
+        error = check_planar_representation(g_faces)
+        if error is not None:
+            raise ValueError(error)
+
+        if shuffle_the_planar_representation:
+            shuffle(g_faces)
+
+        init_f_distribution(g_faces, save_f_distribution=False)
+        the_colored_graph = reduce_and_rebuild_faces(g_faces, choices, save_f_distribution=False)
+
+        result['colored'] = is_well_colored(the_colored_graph)
+        result['edges'] = [[v1, v2, color] for v1, v2, color in graph_edges(the_colored_graph)]
+    except InfiniteKempeLoop:
+        result['error'] = "Infinite loop: all choices and %s shuffles have been tried" % NUMBER_OF_SHUFFLES_ON_LOOPS
+    except ValueError as error:
+        # The checks of the reduction and of the rebuild raise ValueError on unexpected conditions
+        result['error'] = str(error)
+
+    result['seconds'] = round(time.time() - time_begin, 6)
+    result['stats'] = {stat: value for stat, value in stats.items() if not stat.startswith("time_")}
+
+    return result
+
+
+def color_the_batch(batch_filename, batch_output_filename, choices, shuffle_the_planar_representation, number_of_processes):
+    """
+    Batch mode: color all the maps of a stream (see read_maps(): planar_code, .planar, FGC1 containers), in a pool of processes.\n
+    The results are written in the order of the input, one json line per map (see color_a_map_of_the_batch()).
+    The input is read a window at a time, so that streams of millions of maps are not loaded in memory.
+    At the end maps/s and the p50/p99 latencies (seconds to color a single map) are logged.
+
+    Parameters
+    ----------
+        batch_filename: The file with the maps, or - for stdin
+        batch_output_filename: The json lines file to write
+        choices: The selection method for the edges
+        shuffle_the_planar_representation: Shuffle the planar representation of each map
+        number_of_processes: Size of the pool. With 1 the maps are colored in this process
+    """
+
+    logger.info("BEGIN: Batch %s -> %s (%s processes)", batch_filename, batch_output_filename, number_of_processes)
+
+    stream = sys.stdin.buffer if batch_filename == "-" else open(batch_filename, "rb")
+    reading_errors = []
+
+    def read_the_maps():
+        # A broken input ends the batch, but only after the maps before it
+        try:
+            for i_map, g_faces in enumerate(read_maps(stream)):
+                yield i_map, g_faces, choices, shuffle_the_planar_representation
+        except ValueError as error:
+            reading_errors.append(error)
+
+    maps = read_the_maps()
+    window_size = number_of_processes * BATCH_CHUNK_SIZE * BATCH_CHUNKS_PER_WINDOW
+
+    latencies = []
+    number_of_colored_maps = 0
+    time_begin = time.time()
+
+    # The logs of millions of maps would be unreadable (and slow): only warnings and errors while coloring. Forked workers inherit the level
+    logging_level = logger.level
+    logger.setLevel(logging.WARNING)
+
+    pool = multiprocessing.get_context("fork").Pool(number_of_processes) if number_of_processes > 1 else None
+    try:
+        with open(batch_output_filename, "w") as batch_output:
+            for window in iter(lambda: list(itertools.islice(maps, window_size)), []):
+                results = pool.imap(color_a_map_of_the_batch, window, BATCH_CHUNK_SIZE) if pool is not None else map(color_a_map_of_the_batch, window)
+                for result in results:
+                    if result['colored'] is True:
+                        number_of_colored_maps += 1
+                    else:
+                        logger.error("Batch: map %s not colored: %s", result['map'], result.get('error', "is_well_colored: False"))
+                    latencies.append(result['seconds'])
+                    batch_output.write(json.dumps(result))
+                    batch_output.write("\n")
+    finally:
+        if pool is not None:
+            pool.terminate()
+        if stream is not sys.stdin.buffer:
+            stream.close()
+        logger.setLevel(logging_level)
+
+    seconds = time.time() - time_begin
+    logger.info("Batch: %s maps, %s colored, %s not colored", len(latencies), number_of_colored_maps, len(latencies) - number_of_colored_maps)
+    if len(latencies) > 0:
+        p50, p99 = numpy.percentile(latencies, [50, 99])
+        logger.info("Batch: %.3f s, %.1f maps/s", seconds, len(latencies) / seconds)
+        logger.info("Batch: latency p50 = %.3f ms, p99 = %.3f ms, max = %.3f ms", p50 * 1000, p99 * 1000, max(latencies) * 1000)
+
+    if len(reading_errors) > 0:
+        logger.error("ERROR: Batch: cannot read the map %s: %s", len(latencies), reading_errors[0])
+        exit(-1)
+
+    logger.info("END: Batch")
+
+
+class IncrementalColoring:
+    """
+    Keep a map colored while it changes a little at a time: a new border splits a face in two, or a border is removed and two faces are merged.
+
+    apply_edit() changes the faces and writes down the edit, recolor() repairs the coloring around each edit and keeps the coloring of the rest of the map:
+    - split: the two edges cut by the new border are restored with the half Kempe cycle color switching, as in the rebuild (apply_half_kempe_loop_color_switching())
+    - merge: the two edges that take the place of the removed vertices are colored swapping half of a Kempe cycle (color_the_edge_with_a_kempe_chain_swap())
+    When the edges are not on the right Kempe cycles, random Kempe switches of the chains at the vertices around the edit are tried (as in the F5 restore, but local), up to MAX_KEMPE_SWITCHES_PER_EDIT.
+    Only then the coloring is rebuilt from scratch with reduce_and_rebuild_faces().
+    """
+
+    def __init__(self, g_faces, choices, the_colored_graph=None):
+        """
+        Parameters
+        ----------
+            g_faces: The planar representation of the map (it is copied)
+            choices: The selection method for the edges, for the full rebuilds
+            the_colored_graph: The coloring of the map, if already available. Otherwise the map is colored here
+        """
+
+        # The faces by id, so that a face is removed in O(1), and the index of the faces by edge
+        self.faces = {id(face): face for face in [list(face) for face in g_faces]}
+        self.faces_by_edge = index_faces_by_edge(self.faces.values())
+        self.choices = choices
+        self.next_vertex = max(vertex for face in self.faces.values() for edge in face for vertex in edge) + 1
+
+        # Edits applied to the faces but not yet to the coloring: ("split" or "merge", vertices around the edit)
+        self.edits_to_recolor = []
+
+        if the_colored_graph is None:
+            the_colored_graph = self.rebuild()
+        elif graph_kempe_cycle_index(the_colored_graph) is None:
+            the_colored_graph.graph['kempe_cycle_index'] = KempeCycleIndex(the_colored_graph)
+        self.the_colored_graph = the_colored_graph
+
+    def g_faces(self):
+        """
+        Return the planar representation of the map, with all the edits applied.
+        """
+        return list(self.faces.values())
+
+    def rebuild(self):
+        """
+        Color the map from scratch (reduce_and_rebuild_faces() works on a copy of the faces).
+        """
+        stats['F#'] = {}
+        init_f_distribution(self.faces.values(), save_f_distribution=False)
+        return reduce_and_rebuild_faces([list(face) for face in self.faces.values()], self.choices, save_f_distribution=False)
+
+    def replace_faces(self, old_faces, new_faces):
+        for face in old_faces:
+            remove_face_from_the_index(self.faces_by_edge, face)
+            del self.faces[id(face)]
+        for face in new_faces:
+            add_face_to_the_index(self.faces_by_edge, face)
+            self.faces[id(face)] = face
+
+    def apply_edit(self, edit):
+        """
+        Apply an edit to the faces. The coloring is repaired by recolor().
+
+        Parameters
+        ----------
+            edit: One of:
+                {"split": [(a1, b1), (a2, b2)]}: A new border across the face that has the edges (a1, b1) and (a2, b2), from the middle of one to the middle of the other. Its two vertices are new
+                {"merge": (v1, v2)}: The border (v1, v2) is removed, with its two vertices
+
+        Returns
+        -------
+            vertices: The two vertices of the new border, or of the removed one
+
+        Raises ValueError if the edit cannot be applied. In this case the map does not change
+        """
+
+        if "split" in edit:
+            (a1, b1), (a2, b2) = edit["split"]
+            return self.split_face((a1, b1), (a2, b2))
+        elif "merge" in edit:
+            v1, v2 = edit["merge"]
+            return self.merge_faces(v1, v2)
+        else:
+            raise ValueError("Unknown edit: %s" % (edit,))
+
+    def split_face(self, e1, e2):
+
+        face = next((face for face in self.faces_by_edge.get(e1, []) if e2 in face), None)
+        if face is None or e1 == e2:
+            raise ValueError("No face has the two edges %s and %s" % (e1, e2))
+
+        # With multiple edges, the edge to cut would not be known in the colored graph
+        for v1, v2 in (e1, e2):
+            if len(self.faces_by_edge[(v1, v2)]) != 1 or len(self.faces_by_edge[(v2, v1)]) != 1:
+                raise ValueError("The edge %s is a multiple edge" % ((v1, v2),))
+
+        # The new border (v1, v2). The face goes on from e1 to e2 on one side (first_face) and from e2 to e1 on the other side (second_face)
+        a1, b1 = e1
+        a2, b2 = e2
+        v1 = self.next_vertex
+        v2 = self.next_vertex + 1
+        self.next_vertex += 2
+
+        i_e1 = face.index(e1)
+        face_from_e1 = face[i_e1:] + face[:i_e1]
+        i_e2 = face_from_e1.index(e2)
+        first_face = [(v1, b1)] + face_from_e1[1:i_e2] + [(a2, v2), (v2, v1)]
+        second_face = [(v2, b2)] + face_from_e1[i_e2 + 1:] + [(a1, v1), (v1, v2)]
+
+        # The faces on the other side of e1 and e2 get the new vertices too (it may be the same face)
+        faces_to_update = [self.faces_by_edge[(b1, a1)][0], self.faces_by_edge[(b2, a2)][0]]
+        self.replace_faces([face], [first_face, second_face])
+        for face_to_update, (a, b), v in zip(faces_to_update, (e1, e2), (v1, v2)):
+            remove_face_from_the_index(self.faces_by_edge, face_to_update)
+            i_edge = face_to_update.index((b, a))
+            face_to_update[i_edge:i_edge + 1] = [(b, v), (v, a)]
+            add_face_to_the_index(self.faces_by_edge, face_to_update)
+
+        # Same as an ariadne step of the rebuild: [x, v1, v2, vertex_to_join_near_v1_on_the_face, vertex_to_join_near_v2_on_the_face, vertex_to_join_near_v1_not_on_the_face, vertex_to_join_near_v2_not_on_the_face]
+        self.edits_to_recolor.append(("split", [len(first_face), v1, v2, b1, a2, a1, b2]))
+        if logger.isEnabledFor(logging.DEBUG): logger.debug("Split: new border %s, faces of %s and %s edges", (v1, v2), len(first_face), len(second_face))
+
+        return v1, v2
+
+    def merge_faces(self, v1, v2):
+
+        if len(self.faces_by_edge.get((v1, v2), [])) != 1 or len(self.faces_by_edge.get((v2, v1), [])) != 1:
+            raise ValueError("The border %s does not exist or it is a multiple edge" % ((v1, v2),))
+        f1 = self.faces_by_edge[(v1, v2)][0]
+        f2 = self.faces_by_edge[(v2, v1)][0]
+        if would_the_graph_be_one_edge_connected(self.faces_by_edge, f1, f2):
+            raise ValueError("Removing the border %s would leave a border with the same face on both sides" % ((v1, v2),))
+
+        # The four neighbors, as in reduce_faces()
+        vertex_to_join_near_v1_on_the_face = next(edge for edge in f1 if edge[1] == v1)[0]
+        vertex_to_join_near_v2_on_the_face = next(edge for edge in f1 if edge[0] == v2)[1]
+        vertex_to_join_near_v1_not_on_the_face = next(edge for edge in f2 if edge[0] == v1)[1]
+        vertex_to_join_near_v2_not_on_the_face = next(edge for edge in f2 if edge[1] == v2)[0]
+        if vertex_to_join_near_v1_on_the_face == vertex_to_join_near_v1_not_on_the_face or vertex_to_join_near_v2_on_the_face == vertex_to_join_near_v2_not_on_the_face:
+            raise ValueError("Removing the border %s would create a loop" % ((v1, v2),))
+
+        # The faces that have v1 and v2, other than f1 and f2 (it may be the same face)
+        third_face_to_update = self.faces_by_edge[(v1, vertex_to_join_near_v1_on_the_face)][0]
+        fourth_face_to_update = self.faces_by_edge[(vertex_to_join_near_v2_on_the_face, v2)][0]
+
+        self.replace_faces([f1, f2], [join_faces(f1, f2, (v1, v2))])
+        self.replace_faces([third_face_to_update], [])
+        if fourth_face_to_update is not third_face_to_update:
+            self.replace_faces([fourth_face_to_update], [])
+        remove_vertex_from_face(third_face_to_update, v1)
+        remove_vertex_from_face(fourth_face_to_update, v2)
+        self.replace_faces([], [third_face_to_update])
+        if fourth_face_to_update is not third_face_to_update:
+            self.replace_faces([], [fourth_face_to_update])
+
+        self.edits_to_recolor.append(("merge", [v1, v2, vertex_to_join_near_v1_on_the_face, vertex_to_join_near_v1_not_on_the_face, vertex_to_join_near_v2_on_the_face, vertex_to_join_near_v2_not_on_the_face]))
+        if logger.isEnabledFor(logging.DEBUG): logger.debug("Merge: removed border %s", (v1, v2))
+
+        return v1, v2
+
+    def recolor(self):
+        """
+        Repair the coloring after the edits applied since the last call, one edit at a time.
+
+        If an edit cannot be repaired locally, the coloring is rebuilt from scratch for all the edits left (InfiniteKempeLoop if also the rebuild gives up).
+
+        Returns
+        -------
+            True if all the edits have been recolored locally, False if the coloring has been rebuilt
+        """
+
+        edits_to_recolor = self.edits_to_recolor
+        self.edits_to_recolor = []
+
+        for kind, vertices in edits_to_recolor:
+            if kind == "split":
+                is_recolored = self.recolor_a_split(vertices)
+            else:
+                is_recolored = self.recolor_a_merge(vertices)
+
+            if is_recolored is False:
+                stats['EDITS_FULL_REBUILDS'] += 1
+                logger.info("The %s of %s cannot be recolored locally: rebuild the coloring", kind, vertices[1:3] if kind == "split" else vertices[0:2])
+                self.the_colored_graph = self.rebuild()
+                return False
+
+            stats['EDITS_RECOLORED_LOCALLY'] += 1
+
+        return True
+
+    def recolor_a_split(self, ariadne_step):
+
+        the_colored_graph = self.the_colored_graph
+        edge_at_v1 = (ariadne_step[5], ariadne_step[3])
+        edge_at_v2 = (ariadne_step[6], ariadne_step[4])
+
+        for i_attempt in range(MAX_KEMPE_SWITCHES_PER_EDIT + 1):
+            c1 = get_edge_color(the_colored_graph, edge_at_v1)
+            c2 = get_edge_color(the_colored_graph, edge_at_v2)
+
+            # As in the F4 and F5 restore: if the edges are on the same Kempe cycle, its half from v1 ends at v2 on the side of the new border
+            # With c1 == c2, a (c1, c3) cycle with c3 != c1
+            for swap_c2 in ([c2] if c1 != c2 else get_the_other_colors([c1])):
+                if are_edges_on_the_same_kempe_cycle(the_colored_graph, edge_at_v1, edge_at_v2, c1, swap_c2):
+                    apply_half_kempe_loop_color_switching(the_colored_graph, ariadne_step, c1, c2, c1, swap_c2)
+                    return True
+
+            if i_attempt < MAX_KEMPE_SWITCHES_PER_EDIT:
+                self.random_kempe_switch(ariadne_step[3:7])
+
+        return False
+
+    def recolor_a_merge(self, vertices):
+
+        the_colored_graph = self.the_colored_graph
+        v1, v2, vertex_to_join_near_v1_on_the_face, vertex_to_join_near_v1_not_on_the_face, vertex_to_join_near_v2_on_the_face, vertex_to_join_near_v2_not_on_the_face = vertices
+
+        graph_delete_vertex(the_colored_graph, v1)
+        graph_delete_vertex(the_colored_graph, v2)
+        edges_to_color = [(vertex_to_join_near_v1_on_the_face, vertex_to_join_near_v1_not_on_the_face), (vertex_to_join_near_v2_on_the_face, vertex_to_join_near_v2_not_on_the_face)]
+
+        for i_attempt in range(MAX_KEMPE_SWITCHES_PER_EDIT + 1):
+            edges_to_color = [(u, v) for u, v in edges_to_color if color_the_edge_with_a_kempe_chain_swap(the_colored_graph, u, v) is False]
+            if len(edges_to_color) == 0:
+                return True
+
+            if i_attempt < MAX_KEMPE_SWITCHES_PER_EDIT:
+                self.random_kempe_switch(vertices[2:6])
+
+        return False
+
+    def random_kempe_switch(self, vertices):
+        """
+        Switch the colors of the Kempe chain of a random edge at one of the vertices around the edit, as in the F5 restore but local (multiple edges are skipped).
+        """
+        stats['EDITS_RANDOM_KEMPE_SWITCHES'] += 1
+        random_edge = random.choice([edge for vertex in vertices for edge in graph_edges_incident(self.the_colored_graph, vertex)])
+        if is_multiedge(self.the_colored_graph, random_edge[0], random_edge[1]) is False:
+            kempe_chain_color_swap(self.the_colored_graph, random_edge, random_edge[2], get_the_other_colors([random_edge[2]])[randint(0, 1)])
+
+
+def recolor_the_edits(g_faces, the_colored_graph, edits_filename, choices):
+    """
+    Apply the edits of a file to the colored map, recoloring after each one (see IncrementalColoring).
+
+    The file has one edit per line, as json: {"split": [[a1, b1], [a2, b2]]} or {"merge": [v1, v2]}. An edit that cannot be applied is skipped.
+
+    Parameters
+    ----------
+        g_faces: The planar representation of the map
+        the_colored_graph: Its coloring
+        edits_filename: The file with the edits
+        choices: The selection method for the edges, if the coloring has to be rebuilt
+
+    Returns
+    -------
+        the_colored_graph: The coloring of the map after all the edits
+    """
+
+    logger.info("BEGIN: Apply the edits of %s", edits_filename)
+
+    incremental_coloring = IncrementalColoring(g_faces, choices, the_colored_graph)
+    latencies = []
+    with open(edits_filename, "r") as fp:
+        for i_line, line in enumerate(fp):
+            if not line.strip():
+                continue
+
+            time_begin = time.time()
+            try:
+                incremental_coloring.apply_edit(json.loads(line))
+            except ValueError as error:
+                stats['EDITS_REJECTED'] += 1
+                logger.error("Edit at line %s not applied: %s", i_line + 1, error)
+                continue
+            incremental_coloring.recolor()
+            latencies.append(time.time() - time_begin)
+
+    the_colored_graph = incremental_coloring.the_colored_graph
+    logger.info("Edits: %s applied, %s recolored locally, %s full rebuilds, %s rejected", len(latencies), stats['EDITS_RECOLORED_LOCALLY'], stats['EDITS_FULL_REBUILDS'], stats['EDITS_REJECTED'])
+    if len(latencies) > 0:
+        p50, p99 = numpy.percentile(latencies, [50, 99])
+        logger.info("Edits: latency p50 = %.3f ms, p99 = %.3f ms, max = %.3f ms", p50 * 1000, p99 * 1000, max(latencies) * 1000)
+
+    if is_well_colored(the_colored_graph) is False:
+        logger.error("Unexpected condition (the edited map is not well colored). Mario you'd better go back to paper")
+        exit(-1)
+
+    logger.info("END: Apply the edits of %s", edits_filename)
+
+    return the_colored_graph
+
+
 ######
 ######
 ######
@@ -1541,12 +2228,54 @@ def main():
     group_input.add_argument("-r2", "--random2", help="Random graph: subdivision of faces (directly planar)", type=int)
     group_input.add_argument("-e", "--edgelist", help="Load a .edgelist file (networkx)")
     group_input.add_argument("-p", "--planar", help="Load a planar embedding (json) of the graph G.faces() - Automatically saved at each run")
+    group_input.add_argument("-b", "--batch", help="Color all the maps of a stream: planar_code (plantri, fullgen), FGC1 container (fullgen) or .planar (json lines). - for stdin")
     parser.add_argument("-o", "--output", help="Save a .edgelist file (networkx), plus a .dot file (networkx). Specify the file without extension", required=False)
     parser.add_argument("-c", "--choices", help="Sequence of the Fs to choose (2345, 2354, 2435, 2453, 2534, 2543)", type=int, default=2345, choices=[2345, 2354, 2435, 2453, 2534, 2543], required=False)
     parser.add_argument("-s", "--shuffle", help="Shuffle the list at the beginning. Most of the times it solves the infinite loop condition", action='store_true')
     parser.add_argument("-n", "--num_executions", help="The entire process will be executed N times", type=int, default=1, required=False)
+    parser.add_argument("-P", "--portfolio", help="Portfolio: color with all the choices and K shuffles (of the -c choices) at the same time, the first good coloring wins", type=int, metavar="K", required=False)
+    parser.add_argument("-j", "--jobs", help="Number of processes for the portfolio and the batch (default: number of CPUs)", type=int, default=os.cpu_count(), required=False)
+    parser.add_argument("--batch_output", help="Batch: the json lines file with the colorings and the stats of each map (default: the batch file + .colorings.jsonl)", required=False)
+    parser.add_argument("--edits", help="Apply the edits of a file (json lines: {\"split\": [[a1, b1], [a2, b2]]} or {\"merge\": [v1, v2]}) to the colored map, recoloring locally after each one", required=False)
+    parser.add_argument("--profile", help="Profile the run with cProfile and print the 30 most expensive functions", action='store_true')
     args = parser.parse_args()
 
+    if args.batch is not None and args.portfolio is not None:
+        parser.error("-P/--portfolio is not available in batch mode")
+    if args.batch is not None and args.edits is not None:
+        parser.error("--edits is not available in batch mode")
+
+    # The profiler slows down the run: only on request
+    try:
+        if args.profile:
+            profiler = cProfile.Profile()
+            profiler.runcall(execute, args)
+            profiles_stats = pstats.Stats(profiler).sort_stats("cumulative")
+            profiles_stats.print_stats(30)
+        else:
+            execute(args)
+    except ValueError as error:
+        # Unexpected conditions in the reduction and in the rebuild (the batch keeps them in the result of the map instead)
+        logger.error("%s", error)
+        exit(-1)
+
+
+def execute(args):
+    """
+    Color the maps requested with the options.
+
+    Parameters
+    ----------
+        args: The parsed options (see main())
+    """
+
+    if args.batch is not None:
+        batch_output_filename = args.batch_output
+        if batch_output_filename is None:
+            batch_output_filename = ("stdin" if args.batch == "-" else args.batch) + ".colorings.jsonl"
+        color_the_batch(args.batch, batch_output_filename, args.choices, args.shuffle, args.jobs)
+        return
+
     # If using planar input, cap num_executions to the number of lines in the file
     num_executions = args.num_executions
     if args.planar is not None:
@@ -1625,8 +2354,17 @@ def main():
         # 4CT: For each loop remove an edge from a face <= F5, until the graph will have only three faces (an island with two lands)
         ######
 
-        ariadne_s_thread = reduce_faces(g_faces, args.choices)
-        the_colored_graph = rebuild_faces(g_faces, ariadne_s_thread)
+        # The reduction changes the faces: the edits need the original ones
+        if args.edits is not None:
+            g_faces_to_edit = [list(face) for face in g_faces]
+
+        if args.portfolio is not None:
+            the_colored_graph = reduce_and_rebuild_faces_portfolio(g_faces, args.choices, args.portfolio, args.jobs)
+        else:
+            try:
+                the_colored_graph = reduce_and_rebuild_faces(g_faces, args.choices)
+            except InfiniteKempeLoop as infinite_loop:
+                give_up_on_infinite_loop(infinite_loop.the_colored_graph, NUMBER_OF_SHUFFLES_ON_LOOPS)
 
         ######
         # 4CT: Restore the edges one at a time and apply the half Kempe-cycle color switching method
@@ -1689,6 +2427,10 @@ def main():
         logger.debug("----------------------------------------")
         logger.info("")
 
+        # Edit the map and recolor it (the output graph is the edited one)
+        if args.edits is not None:
+            the_colored_graph = recolor_the_edits(g_faces_to_edit, the_colored_graph, args.edits, args.choices)
+
         # Save the output graph
         if args.output is not None:
             export_graph(the_colored_graph, args.output)
@@ -1696,6 +2438,11 @@ def main():
         # Print statistics
         print_stats()
 
+    # How many times each strategy of the portfolio won
+    if args.portfolio is not None:
+        for strategy, wins in portfolio_wins.most_common():
+            logger.info("Portfolio wins: %s = %s", strategy, wins)
+
 
 ######
 ######
@@ -1739,16 +2486,11 @@ if __name__ == '__main__':
 
     # Statistics
     stats = {}
+    portfolio_wins = collections.Counter()
 
     # Set logging facilities
     logger = logging.getLogger()
     logging.config.fileConfig('logging.conf', disable_existing_loggers=False)
 
     # Go
-    profiler = cProfile.Profile()
-    profiler.enable()
     main()
-    profiler.disable()
-
-    profiles_stats = pstats.Stats(profiler).sort_stats("cumulative")
-    profiles_stats.print_stats(30)
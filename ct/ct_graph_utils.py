@@ -7,6 +7,13 @@
 #
 # History:
 # - 10/Set/2019 - Creation data
+# - 19/Oct/2026 - Zobrist hash of the edge coloring, kept up to date by the edge helpers (used to detect infinite loops of Kempe switches)
+# - 19/Oct/2026 - Readers of streams of maps (planar_code, .planar, FGC1 containers) for the batch mode
+# - 19/Oct/2026 - Kempe cycle index (KempeCycleIndex): same cycle queries and swaps without walking the cycles
+# - 19/Oct/2026 - Index of the faces by edge and would_the_graph_be_one_edge_connected() (no join of the faces to check a candidate edge)
+# - 19/Oct/2026 - check_planar_representation(): linear check of a planar cubic map from its faces (Euler, no planarity algorithm). Linear create_graph_from_planar_representation()
+# - 19/Oct/2026 - color_the_edge_with_a_kempe_chain_swap() and graph_delete_vertex(), for the incremental recoloring of edited maps
+# - 19/Oct/2026 - kempe_chain_color_swap(), are_edges_on_the_same_kempe_cycle() and join_faces() raise ValueError on unexpected conditions instead of exit(-1)
 #
 # TODOs:
 # - Fix docstring for each function
@@ -18,8 +25,10 @@
 __author__ = "Mario Stefanutti <mario.stefanutti@gmail.com>"
 __credits__ = "Mario Stefanutti <mario.stefanutti@gmail.com>, someone_who_would_like_to_help@nowhere.com"
 
+import json
 import logging
 import random
+import struct
 
 import networkx as nx
 
@@ -28,6 +37,239 @@ logger = logging.getLogger(__name__)
 # Valid colors
 VALID_COLORS = ['red', 'green', 'blue']
 
+# Zobrist keys: a random 64 bit number for each colored edge (v1, v2, color) with v1 <= v2
+# The generator is not the one of the random module, so that using the keys does not change the random switches
+zobrist_keys = {}
+zobrist_random = random.Random(20161105)
+
+
+###
+# Zobrist hash of the edge coloring
+###
+
+def zobrist_key(u, v, color):
+    """
+    Return the Zobrist key of a colored edge. (u, v) and (v, u) have the same key.
+    """
+    edge_key = (u, v, color) if u <= v else (v, u, color)
+    key = zobrist_keys.get(edge_key)
+    if key is None:
+        key = zobrist_random.getrandbits(64)
+        zobrist_keys[edge_key] = key
+    return key
+
+
+def graph_zobrist_hash(graph):
+    """
+    Return the Zobrist hash of the edge coloring: the XOR of the keys of all edges.\n
+    graph_add_edge(), graph_delete_edge() and graph_set_edge_label() update it in O(1), hence also every swap done by kempe_chain_color_swap().
+    Two equal colorings have the same hash, so a repeated hash means (almost certainly) a coloring already seen.
+    """
+    return graph.graph.get('zobrist', 0)
+
+
+###
+# Kempe cycle index
+###
+
+# For each color, the two pairs of colors (Kempe cycles) of its edges, with the other color of the pair
+KEMPE_PAIRS_OF_A_COLOR = {color: [(tuple(sorted((color, other_color))), other_color) for other_color in VALID_COLORS if other_color != color] for color in VALID_COLORS}
+
+
+class KempeCycleIndex:
+    """
+    Index of the Kempe cycles of a colored graph: for each pair of colors, the edges are linked one to the other in alternating cycles (and paths, where an edge is missing).\n
+    Each cycle or path has a label, so "are these edges on the same cycle?" and "how long is this cycle?" do not walk the cycle.
+
+    graph_add_edge(), graph_delete_edge() and graph_set_edge_label() only write down the changes (edge_changed()), because in the middle of a restore or of a swap the coloring is not a proper coloring.
+    The changes are applied before the next query: the edges removed first (a cycle becomes a path, or a path is split in two) and then the edges added (linked to the edges at their two ends).
+    When a path is split, the shorter part gets a new label, and when two paths are joined the shorter one takes the label of the other, so the work is that of the shorter part.
+
+    To be used, it has to be stored in graph.graph['kempe_cycle_index'] (see rebuild_faces()).
+    """
+
+    def __init__(self, graph):
+        self.graph = graph
+
+        # For each pair of colors: edge -> [edge linked at the end v1, edge linked at the end v2], edge -> label, label -> edges, labels of the cycles (the others are paths)
+        self.links = {pair: {} for pairs in KEMPE_PAIRS_OF_A_COLOR.values() for pair, _ in pairs}
+        self.labels = {pair: {} for pair in self.links}
+        self.members = {pair: {} for pair in self.links}
+        self.cycles = {pair: set() for pair in self.links}
+        self.next_label = 0
+
+        # For each vertex, its edges in the index by color
+        self.edges_at_vertex = {}
+
+        # Edges (v1, v2, color) with v1 <= v2, added (+1) or removed (-1) since the last query
+        self.changes = {}
+        for u, v, color in graph_edges(graph):
+            self.edge_changed(u, v, color, 1)
+
+    def edge_changed(self, u, v, color, change):
+        """
+        Write down that an edge has been added (change = 1) or removed (change = -1). Removing and adding it again is no change at all.
+        """
+        edge = (u, v, color) if u <= v else (v, u, color)
+        change += self.changes.get(edge, 0)
+        if change == 0:
+            del self.changes[edge]
+        else:
+            self.changes[edge] = change
+
+    def update(self):
+        """
+        Apply the changes written down since the last query.
+        """
+        if len(self.changes) == 0:
+            return
+
+        changes = self.changes
+        self.changes = {}
+        edges_at_vertex = self.edges_at_vertex
+        for edge, change in changes.items():
+            if change < 0:
+                for pair, _ in KEMPE_PAIRS_OF_A_COLOR[edge[2]]:
+                    self.remove_edge(pair, edge)
+                for vertex in edge[:2]:
+                    if edges_at_vertex[vertex].get(edge[2]) == edge:
+                        del edges_at_vertex[vertex][edge[2]]
+        for edge, change in changes.items():
+            if change > 0:
+                for pair, other_color in KEMPE_PAIRS_OF_A_COLOR[edge[2]]:
+                    self.add_edge(pair, other_color, edge)
+                for vertex in edge[:2]:
+                    edges_at_vertex.setdefault(vertex, {})[edge[2]] = edge
+
+    def new_label(self, pair, edges):
+        label = self.next_label
+        self.next_label += 1
+        self.members[pair][label] = edges
+        labels = self.labels[pair]
+        for edge in edges:
+            labels[edge] = label
+        return label
+
+    def add_edge(self, pair, other_color, edge):
+        links = self.links[pair]
+        labels = self.labels[pair]
+
+        edge_links = [None, None]
+        links[edge] = edge_links
+        self.new_label(pair, {edge})
+
+        # Link it to the edges of the other color at its two ends (those already in the index)
+        for i_end, vertex in enumerate(edge[:2]):
+            linked_edge = self.edges_at_vertex.get(vertex, {}).get(other_color)
+            if linked_edge is None:
+                continue
+            linked_edge_links = links[linked_edge]
+            i_linked_end = 0 if linked_edge[0] == vertex else 1
+            if linked_edge_links[i_linked_end] is not None:
+                raise ValueError("Kempe cycle index: %s is already linked at %s" % (linked_edge, vertex))
+            linked_edge_links[i_linked_end] = edge
+            edge_links[i_end] = linked_edge
+            self.join(pair, labels[edge], labels[linked_edge])
+
+    def join(self, pair, label_1, label_2):
+        if label_1 == label_2:
+            self.cycles[pair].add(label_1)
+            return
+
+        members = self.members[pair]
+        if len(members[label_1]) < len(members[label_2]):
+            label_1, label_2 = label_2, label_1
+        labels = self.labels[pair]
+        for edge in members[label_2]:
+            labels[edge] = label_1
+        members[label_1] |= members.pop(label_2)
+
+    def remove_edge(self, pair, edge):
+        links = self.links[pair]
+        edge_links = links.pop(edge)
+        label = self.labels[pair].pop(edge)
+        members = self.members[pair][label]
+        members.discard(edge)
+
+        for linked_edge in edge_links:
+            if linked_edge is not None:
+                linked_edge_links = links[linked_edge]
+                for i_end in (0, 1):
+                    if linked_edge_links[i_end] == edge:
+                        linked_edge_links[i_end] = None
+
+        # Nothing left, or a cycle that becomes a path: same label
+        if len(members) == 0:
+            del self.members[pair][label]
+            self.cycles[pair].discard(label)
+        elif label in self.cycles[pair]:
+            self.cycles[pair].discard(label)
+        elif edge_links[0] is not None and edge_links[1] is not None:
+            self.split(pair, label, edge_links[0], edge_links[1])
+
+    def split(self, pair, label, edge_1, edge_2):
+        """
+        Split the path of the given label in the two parts that start at edge_1 and edge_2, walking on both at the same time until the shorter one ends.
+        """
+        links = self.links[pair]
+        parts = [[edge_1], [edge_2]]
+        previous_edges = [None, None]
+        while True:
+            for i_part in (0, 1):
+                current_edge = parts[i_part][-1]
+                current_links = links[current_edge]
+                next_edge = current_links[0] if current_links[1] == previous_edges[i_part] else current_links[1]
+                if next_edge is None:
+                    shorter_part = set(parts[i_part])
+                    self.members[pair][label] -= shorter_part
+                    self.new_label(pair, shorter_part)
+                    return
+                previous_edges[i_part] = current_edge
+                parts[i_part].append(next_edge)
+
+    def label_of(self, pair, edge, color):
+        """
+        Return the label of the cycle of the edge of the given color between edge[0] and edge[1] (None if there is no such edge).
+        """
+        u, v = edge[0], edge[1]
+        return self.labels[pair].get((u, v, color) if u <= v else (v, u, color))
+
+    def are_edges_on_the_same_cycle(self, e1, e2, c1, c2):
+        """
+        Check if e1 (of color c1) and e2 (of color c1 or c2) are on the same (c1, c2) Kempe cycle. None if e1 is not in the index.
+        """
+        self.update()
+        pair = tuple(sorted((c1, c2)))
+        label = self.label_of(pair, e1, c1)
+        if label is None:
+            return None
+        return label in (self.label_of(pair, e2, c1), self.label_of(pair, e2, c2))
+
+    def cycle_length(self, edge, c1, c2):
+        """
+        Return the number of edges of the (c1, c2) Kempe cycle (or path) of the edge of color c1. None if the edge is not in the index.
+        """
+        self.update()
+        pair = tuple(sorted((c1, c2)))
+        label = self.label_of(pair, edge, c1)
+        return None if label is None else len(self.members[pair][label])
+
+    def cycle_edges(self, edge, c1, c2):
+        """
+        Return the edges (v1, v2, color) of the (c1, c2) Kempe cycle (or path) of the edge of color c1. None if the edge is not in the index.
+        """
+        self.update()
+        pair = tuple(sorted((c1, c2)))
+        label = self.label_of(pair, edge, c1)
+        return None if label is None else list(self.members[pair][label])
+
+
+def graph_kempe_cycle_index(graph):
+    """
+    Return the Kempe cycle index of the graph, if it has one (see KempeCycleIndex).
+    """
+    return graph.graph.get('kempe_cycle_index')
+
 
 ###
 # Helper functions to provide Sage-like API on top of NetworkX
@@ -116,6 +358,10 @@ def graph_add_edge(graph, u, v, label=None):
     Sage API: graph.add_edge(u, v, label)
     """
     graph.add_edge(u, v, color=label)
+    graph.graph['zobrist'] = graph.graph.get('zobrist', 0) ^ zobrist_key(u, v, label)
+    kempe_cycle_index = graph.graph.get('kempe_cycle_index')
+    if kempe_cycle_index is not None:
+        kempe_cycle_index.edge_changed(u, v, label, 1)
 
 
 def graph_delete_edge(graph, u, v, label=None):
@@ -129,16 +375,35 @@ def graph_delete_edge(graph, u, v, label=None):
         if graph.has_edge(u, v):
             keys = list(graph[u][v].keys())
             if keys:
+                label = graph[u][v][keys[0]].get('color')
+                graph.graph['zobrist'] = graph.graph.get('zobrist', 0) ^ zobrist_key(u, v, label)
                 graph.remove_edge(u, v, keys[0])
+                kempe_cycle_index = graph.graph.get('kempe_cycle_index')
+                if kempe_cycle_index is not None:
+                    kempe_cycle_index.edge_changed(u, v, label, -1)
     else:
         # Find and remove the edge with matching label
         if graph.has_edge(u, v):
             for key in list(graph[u][v].keys()):
                 if graph[u][v][key].get('color') == label:
+                    graph.graph['zobrist'] = graph.graph.get('zobrist', 0) ^ zobrist_key(u, v, label)
                     graph.remove_edge(u, v, key)
+                    kempe_cycle_index = graph.graph.get('kempe_cycle_index')
+                    if kempe_cycle_index is not None:
+                        kempe_cycle_index.edge_changed(u, v, label, -1)
                     break
 
 
+def graph_delete_vertex(graph, vertex):
+    """
+    Delete a vertex and its edges. The edges are deleted one at a time (graph_delete_edge()), so the Zobrist hash and the Kempe cycle index are kept up to date.
+    Sage API: graph.delete_vertex(vertex)
+    """
+    for u, v, label in graph_edges_incident(graph, vertex):
+        graph_delete_edge(graph, u, v, label)
+    graph.remove_node(vertex)
+
+
 def graph_set_edge_label(graph, u, v, new_label):
     """
     Set the label of an edge.
@@ -147,7 +412,13 @@ def graph_set_edge_label(graph, u, v, new_label):
     """
     edge_data = graph[u][v]
     first_key = next(iter(edge_data))
+    old_label = edge_data[first_key].get('color')
+    graph.graph['zobrist'] = graph.graph.get('zobrist', 0) ^ zobrist_key(u, v, old_label) ^ zobrist_key(u, v, new_label)
     edge_data[first_key]['color'] = new_label
+    kempe_cycle_index = graph.graph.get('kempe_cycle_index')
+    if kempe_cycle_index is not None:
+        kempe_cycle_index.edge_changed(u, v, old_label, -1)
+        kempe_cycle_index.edge_changed(u, v, new_label, 1)
 
 
 def graph_edge_boundary(graph, v1_list, v2_list):
@@ -268,7 +539,8 @@ def check_graph_planarity_3_regularity_no_loops(graph):
 def kempe_chain_color_swap(graph, starting_edge, c1, c2):
     """
     Execute a Kempe chain color swapping.\n
-    Works for chains and cycles and consider also multiedges cases.
+    Works for chains and cycles and consider also multiedges cases. With a Kempe cycle index (graph_kempe_cycle_index()), its edges are taken from the index.\n
+    The Zobrist hash of the coloring (graph_zobrist_hash()) is updated edge by edge, by the helpers used for each swap.
 
     Parameters
     ----------
@@ -280,6 +552,20 @@ def kempe_chain_color_swap(graph, starting_edge, c1, c2):
 
     if logger.isEnabledFor(logging.DEBUG): logger.debug("BEGIN: kempe_chain_color_swap: %s, %s, %s", starting_edge, c1, c2)
 
+    # With the index, the edges of the chain are already known: no need to walk it
+    kempe_cycle_index = graph_kempe_cycle_index(graph)
+    if kempe_cycle_index is not None:
+        chain_edges = kempe_cycle_index.cycle_edges(starting_edge, c1, c2)
+        if chain_edges is not None:
+            for v1, v2, color in chain_edges:
+                new_color = c2 if color == c1 else c1
+                if is_multiedge(graph, v1, v2):
+                    graph_delete_edge(graph, v1, v2, color)
+                    graph_add_edge(graph, v1, v2, new_color)
+                else:
+                    graph_set_edge_label(graph, v1, v2, new_color)
+            return
+
     # Start the loop at starting_edge
     current_edge = starting_edge
     previous_color = c2
@@ -335,8 +621,7 @@ def kempe_chain_color_swap(graph, starting_edge, c1, c2):
             elif try_next_e2_color == next_color:
                 current_edge = edges_to_check[1]
             else:
-                logger.error("Unexpected condition (next color must always exists). Mario you'd better go back to paper")
-                exit(-1)
+                raise ValueError("Unexpected condition (next color must always exists). Mario you'd better go back to paper")
 
             # Update current and next color
             current_color = next_color
@@ -627,21 +912,331 @@ def create_graph_from_planar_representation(faces):
     """
 
     # Create the graph from the list of faces
-    flattened_egdes = [edge for face in faces for edge in face]
-
-    # TODO: This cycle remove duplicates. Two adjacent faces, list at least one edge twice
-    for edge in flattened_egdes:
-        reverse_edge = (edge[1], edge[0])
-        if reverse_edge in flattened_egdes:
-            flattened_egdes.remove(reverse_edge)
-
+    # Two adjacent faces list the same edge twice, once for each direction: an edge is added the first time it is seen, and its reverse is skipped when it comes
+    # The counters (instead of removing the reverse edges from the list) keep it linear, also with multiple edges
+    reverse_edges_to_skip = {}
     new_graph = create_networkx_graph()  # Creates nx.MultiGraph
-    for edge_to_add in flattened_egdes:
-        new_graph.add_edge(edge_to_add[0], edge_to_add[1])
+    for face in faces:
+        for v1, v2 in face:
+            if reverse_edges_to_skip.get((v1, v2), 0) > 0:
+                reverse_edges_to_skip[(v1, v2)] -= 1
+            else:
+                new_graph.add_edge(v1, v2)
+                reverse_edges_to_skip[(v2, v1)] = reverse_edges_to_skip.get((v2, v1), 0) + 1
 
     return new_graph
 
 
+def check_planar_representation(faces):
+    """
+    Check, from the faces alone, that the planar representation is a planar cubic map without loops (a linear pass, no planarity algorithm).
+
+    - Each face is a closed walk: (v1, v2), (v2, v3), ..., (vk, v1)
+    - Each edge (v1, v2) has its reverse (v2, v1) in another face (as many times as (v1, v2), with multiple edges)
+    - Each vertex has degree 3 and, if it has three different neighbors, its three corners make one turn around it
+    - V - E + F = 2 for each connected component: the faces are those of an embedding on the sphere
+
+    Parameters
+    ----------
+        faces: The planar representation
+
+    Returns
+    -------
+        error: The description of the first problem found, None if the planar representation is good
+    """
+
+    if logger.isEnabledFor(logging.DEBUG): logger.debug("BEGIN: check_planar_representation")
+
+    # Edges, with the face where they are (the first, with multiple edges) and how many times
+    # For each vertex: neighbor before the vertex -> neighbor after the vertex, for each corner of a face
+    face_of_the_edge = {}
+    edge_count = {}
+    next_around = {}
+    for i_face, face in enumerate(faces):
+        if len(face) == 0:
+            return "Face %s is empty" % i_face
+        for i_edge, (v1, v2) in enumerate(face):
+            if v1 == v2:
+                return "The graph has loops: %s" % ((v1, v2),)
+            v3 = face[(i_edge + 1) % len(face)]
+            if v3[0] != v2:
+                return "Face %s is not a closed walk: %s is followed by %s" % (i_face, (v1, v2), v3)
+            face_of_the_edge.setdefault((v1, v2), i_face)
+            edge_count[(v1, v2)] = edge_count.get((v1, v2), 0) + 1
+            next_around.setdefault(v2, {})[v1] = v3[1]
+
+    # Each edge with its reverse, and the union-find of the connected components
+    component = {}
+
+    def find(vertex):
+        root = vertex
+        while component[root] != root:
+            root = component[root]
+        while component[vertex] != root:
+            component[vertex], vertex = root, component[vertex]
+        return root
+
+    degree = {}
+    for (v1, v2), count in edge_count.items():
+        if edge_count.get((v2, v1), 0) != count:
+            return "The edge %s is in %s faces but its reverse is in %s" % ((v1, v2), count, edge_count.get((v2, v1), 0))
+        if count == 1 and face_of_the_edge[(v2, v1)] == face_of_the_edge[(v1, v2)]:
+            return "The edge %s has the same face on both sides (the graph is 1-edge-connected)" % ((v1, v2),)
+        degree[v1] = degree.get(v1, 0) + count
+        component.setdefault(v1, v1)
+        component.setdefault(v2, v2)
+        root_1 = find(v1)
+        root_2 = find(v2)
+        if root_1 != root_2:
+            component[root_2] = root_1
+
+    for vertex, vertex_degree in degree.items():
+        if vertex_degree != 3:
+            return "The graph is not 3-regular: the vertex %s has degree %s" % (vertex, vertex_degree)
+
+        # With multiple edges the neighbors do not tell which corner is which, so only simple vertices are checked
+        around = next_around[vertex]
+        if len(around) == 3:
+            neighbor = next(iter(around))
+            if around.get(around.get(around[neighbor])) != neighbor or around[neighbor] == neighbor:
+                return "The corners around the vertex %s do not make one turn" % vertex
+
+    # Euler: V - E + F = 2 for each connected component
+    euler = {}
+    for vertex in degree:
+        root = find(vertex)
+        euler[root] = euler.get(root, 0) + 1
+    for (v1, v2), count in edge_count.items():
+        if v1 < v2:
+            euler[find(v1)] -= count
+    for face in faces:
+        euler[find(face[0][0])] += 1
+    for root, characteristic in euler.items():
+        if characteristic != 2:
+            return "The component of the vertex %s has V - E + F = %s (it is not planar)" % (root, characteristic)
+
+    if logger.isEnabledFor(logging.DEBUG): logger.debug("END: check_planar_representation")
+
+    return None
+
+
+def check_planar_representation_3_regularity_no_loops(faces):
+    """
+    Check if I can work with this planar representation: has to be a planar cubic map without loops.
+
+    Same as check_graph_planarity_3_regularity_no_loops(), but from the faces (see check_planar_representation()): no networkx graph and no planarity algorithm.
+
+    Parameters
+    ----------
+        faces: The planar representation to check
+    """
+
+    error = check_planar_representation(faces)
+    if error is not None:
+        logger.error("ERROR: %s", error)
+        exit(-1)
+    else:
+        logger.info("OK. The planar representation is a planar cubic map without loops")
+
+    # Additional info (a cubic graph has 2E/3 vertices)
+    number_of_edges = sum(len(face) for face in faces) // 2
+    logger.info("The graph has %s vertices and %s edges", number_of_edges * 2 // 3, number_of_edges)
+
+    return
+
+
+###
+# Readers of streams of maps: planar_code (plantri, fullgen), .planar (json, one map per line), FGC1 containers (fullgen)
+###
+
+def faces_from_rotation_system(rotation):
+    """
+    Create the planar representation of a map from its rotation system.\n
+    A face goes on from the edge (u, v) with the edge (v, w), where w is the neighbour that follows u around v.
+    Every edge is in two faces, once for each direction.
+
+    Parameters
+    ----------
+        rotation: For each vertex (0, 1, ...), the list of its neighbours in cyclic order. Loops and multiple edges are not supported
+
+    Returns
+    -------
+        faces: The planar representation of the map
+    """
+
+    # Where each neighbour is around each vertex
+    positions = [{neighbour: i_neighbour for i_neighbour, neighbour in enumerate(neighbours)} for neighbours in rotation]
+    for vertex, neighbours in enumerate(rotation):
+        if vertex in positions[vertex] or len(positions[vertex]) != len(neighbours):
+            raise ValueError("Loops and multiple edges are not supported (vertex %s)" % vertex)
+
+    faces = []
+    visited = set()
+    for vertex, neighbours in enumerate(rotation):
+        for neighbour in neighbours:
+            u, v = vertex, neighbour
+            face = []
+            while (u, v) not in visited:
+                visited.add((u, v))
+                face.append((u, v))
+                around_v = rotation[v]
+                u, v = v, around_v[(positions[v][u] + 1) % len(around_v)]
+            if len(face) > 0:
+                faces.append(face)
+
+    return faces
+
+
+def read_exactly(stream, size):
+    """
+    Read size bytes from a binary stream. A stream that ends before is a truncated file.
+    """
+
+    data = stream.read(size)
+    if len(data) != size:
+        raise ValueError("Truncated input (%s bytes instead of %s)" % (len(data), size))
+
+    return data
+
+
+def read_planar_code_header(stream):
+    """
+    Read a header like ">>planar_code<<" or ">>planar_code le<<" and return it (without >> and <<).
+    """
+
+    header = read_exactly(stream, 2)
+    while not header.endswith(b"<<"):
+        header += read_exactly(stream, 1)
+        if len(header) > 64:
+            raise ValueError("Header without <<")
+
+    return header[2:-2].decode("ascii")
+
+
+def read_planar_code(stream, header="planar_code", length=None):
+    """
+    Read the maps of a planar_code stream, after its header.\n
+    Each map is the number of vertices n (one byte, or 0 and then two bytes), then for each vertex its neighbours (1..n) in clockwise order followed by 0.
+    The entries have the size of n (one or two bytes). The two bytes entries are little endian ("planar_code le"), big endian ("planar_code be"), or in the order of the machine ("planar_code").
+
+    Parameters
+    ----------
+        stream: The binary stream
+        header: The header already read
+        length: The bytes to read (a part of a container). Default is until the end of the stream
+
+    Returns
+    -------
+        A generator of the planar representations of the maps, in the order of the stream
+    """
+
+    byte_order = {"planar_code": "=", "planar_code le": "<", "planar_code be": ">"}.get(header)
+    if byte_order is None:
+        raise ValueError("Not a planar_code header: %s" % header)
+    two_bytes = struct.Struct(byte_order + "H")
+
+    consumed = 0
+    while length is None or consumed < length:
+        first = stream.read(1)
+        if len(first) == 0:
+            if length is not None:
+                raise ValueError("Truncated input (%s bytes instead of %s)" % (consumed, length))
+            return
+        consumed += 1
+
+        number_of_vertices = first[0]
+        entry_size = 1
+        if number_of_vertices == 0:
+            number_of_vertices = two_bytes.unpack(read_exactly(stream, 2))[0]
+            entry_size = 2
+            consumed += 2
+
+        rotation = [[] for _ in range(number_of_vertices)]
+        for neighbours in rotation:
+            while True:
+                entry = read_exactly(stream, entry_size)
+                consumed += entry_size
+                neighbour = entry[0] if entry_size == 1 else two_bytes.unpack(entry)[0]
+                if neighbour == 0:
+                    break
+                if neighbour > number_of_vertices:
+                    raise ValueError("Vertex %s in a map of %s vertices" % (neighbour, number_of_vertices))
+                neighbours.append(neighbour - 1)
+
+        yield faces_from_rotation_system(rotation)
+
+    if consumed != length:
+        raise ValueError("The last map goes beyond the end of the part (%s bytes instead of %s)" % (consumed, length))
+
+
+def read_container(stream):
+    """
+    Read the maps of an FGC1 container (fullgen "container" option), after its magic number.\n
+    The index is the number of parts k (4 bytes), then k times: number of vertices (4 bytes), position (8 bytes) and length (8 bytes), little endian.
+    Each part is a complete file with its own header. The parts in planar_code are read in the order of their positions, the others are skipped.
+    The stream is never seeked back, so it can also be a pipe.
+
+    Parameters
+    ----------
+        stream: The binary stream
+
+    Returns
+    -------
+        A generator of the planar representations of the maps
+    """
+
+    number_of_parts = struct.unpack("<I", read_exactly(stream, 4))[0]
+    parts = [struct.unpack("<IQQ", read_exactly(stream, 20)) for _ in range(number_of_parts)]
+    position = 4 + 4 + 20 * number_of_parts
+
+    for number_of_vertices, part_position, part_length in sorted(parts, key=lambda part: part[1]):
+        if part_position < position:
+            raise ValueError("Overlapping parts in the container (vertices: %s)" % number_of_vertices)
+        while position < part_position:
+            position += len(read_exactly(stream, min(part_position - position, 1 << 20)))
+
+        header = read_planar_code_header(stream)
+        part_read = len(header) + 4
+        if header.startswith("planar_code"):
+            yield from read_planar_code(stream, header, part_length - part_read)
+        else:
+            logger.warning("Container: part with %s vertices skipped (%s)", number_of_vertices, header)
+            while part_read < part_length:
+                part_read += len(read_exactly(stream, min(part_length - part_read, 1 << 20)))
+        position = part_position + part_length
+
+
+def read_maps(stream):
+    """
+    Read the maps of a binary stream, whatever its format:
+    - planar_code, with its header (plantri, fullgen)
+    - FGC1 container (fullgen)
+    - .planar, the json of the planar representation, one map per line
+
+    Parameters
+    ----------
+        stream: The binary stream (a file open with "rb", or sys.stdin.buffer)
+
+    Returns
+    -------
+        A generator of the planar representations of the maps, in the order of the stream
+    """
+
+    beginning = stream.peek(4)[:4]
+
+    if beginning == b"FGC1":
+        stream.read(4)
+        yield from read_container(stream)
+    elif beginning.startswith(b">>"):
+        yield from read_planar_code(stream, read_planar_code_header(stream))
+    else:
+        for line in stream:
+            line = line.strip()
+            if len(line) > 0:
+                # Cast back to tuples, like create_from_planar() does
+                yield [[tuple(edge) for edge in face] for face in json.loads(line)]
+
+
 def export_graph(graph_to_export, name_of_file_without_extension):
     """
     Export graph
@@ -734,6 +1329,14 @@ def are_edges_on_the_same_kempe_cycle(graph, e1, e2, c1, c2):
 
     if logger.isEnabledFor(logging.DEBUG): logger.debug("BEGIN: are_edges_on_the_same_kempe_cycle: %s, %s, %s, %s", e1, e2, c1, c2)
 
+    # With the index there is no need to walk the cycle
+    kempe_cycle_index = graph_kempe_cycle_index(graph)
+    if kempe_cycle_index is not None:
+        are_edges_on_the_same_kempe_cycle_flag = kempe_cycle_index.are_edges_on_the_same_cycle(e1, e2, c1, c2)
+        if are_edges_on_the_same_kempe_cycle_flag is not None:
+            if logger.isEnabledFor(logging.DEBUG): logger.debug("END: are_edges_on_the_same_kempe_cycle_flag: %s (index)", are_edges_on_the_same_kempe_cycle_flag)
+            return are_edges_on_the_same_kempe_cycle_flag
+
     # Flag to return
     are_edges_on_the_same_kempe_cycle_flag = False
 
@@ -770,8 +1373,7 @@ def are_edges_on_the_same_kempe_cycle(graph, e1, e2, c1, c2):
         elif next_e2_color == next_color:
             current_edge = edges_to_check[1]
         else:
-            logger.error("Unexpected condition (next color should exist). Mario you'd better go back to paper")
-            exit(-1)
+            raise ValueError("Unexpected condition (next color should exist). Mario you'd better go back to paper")
 
         # Update current and next color
         current_color = next_color
@@ -837,6 +1439,81 @@ def apply_half_kempe_loop_color_switching(graph, ariadne_step, color_at_v1, colo
     graph_add_edge(graph, v1, v2, get_the_other_colors([color_at_v1, swap_c2])[0])
 
 
+def color_the_edge_with_a_kempe_chain_swap(graph, u, v):
+    """
+    Add the edge (u, v) with a color, when the other edges at u and v are already colored.
+
+    If a color is missing at both u and v, that's it. Otherwise u misses c1 (that v has) and v misses c2 (that u has): v is the end of a (c1, c2) Kempe chain, a path.
+    If the other end of the path is not u, swapping the path (half of the Kempe cycle that the new edge will close, as in apply_half_kempe_loop_color_switching()) frees c1 at v.
+    If it is u, the swap would only exchange the colors missing at u and v: another pair of colors is tried (u or v may miss two colors).
+
+    Parameters
+    ----------
+        graph: The graph (with a Kempe cycle index, see graph_kempe_cycle_index(): the Kempe chains are paths)
+        u: First vertex of the edge
+        v: Second vertex of the edge
+
+    Returns
+    -------
+        True if the edge has been added, False if all the Kempe chains end at u (the graph has not been changed)
+    """
+
+    missing_at_u = get_the_other_colors([color for _, _, color in graph_edges_incident(graph, u)] if graph.has_node(u) else [])
+    missing_at_v = get_the_other_colors([color for _, _, color in graph_edges_incident(graph, v)] if graph.has_node(v) else [])
+
+    for color in missing_at_u:
+        if color in missing_at_v:
+            graph_add_edge(graph, u, v, color)
+            return True
+
+    for c1 in missing_at_u:
+        for c2 in missing_at_v:
+            edge_at_v = next((v, neighbor) for _, neighbor, color in graph_edges_incident(graph, v) if color == c1)
+            edge_at_u = next((u, neighbor) for _, neighbor, color in graph_edges_incident(graph, u) if color == c2)
+            if are_edges_on_the_same_kempe_cycle(graph, edge_at_v, edge_at_u, c1, c2) is False:
+                if logger.isEnabledFor(logging.DEBUG): logger.debug("Half Kempe chain color swap from %s (c1: %s, c2: %s) to color %s", edge_at_v, c1, c2, (u, v))
+                kempe_chain_color_swap(graph, edge_at_v, c1, c2)
+                graph_add_edge(graph, u, v, c1)
+                return True
+
+    return False
+
+
+def apply_kempe_switch_to_an_unseen_coloring(graph, seen_colorings):
+    """
+    Apply a Kempe cycle color switching that gives a coloring not seen yet.\n
+    The switches (every edge with each of its two other colors) are tried in random order. A switch done twice gives back the same coloring, so a switch that gives a coloring already seen is undone.
+
+    Parameters
+    ----------
+        graph: The graph (it has to be cubic, so that all Kempe chains are cycles)
+        seen_colorings: The Zobrist hashes (graph_zobrist_hash()) of the colorings to avoid
+
+    Returns
+    -------
+        True if a switch has been applied, False if all switches give colorings already seen
+    """
+
+    switches_to_try = [(u, v, c, other_color) for (u, v, c) in graph_edges(graph) for other_color in get_the_other_colors([c])]
+    random.shuffle(switches_to_try)
+
+    for (u, v, c, other_color) in switches_to_try:
+
+        # Multiedges are skipped, as for the random switches
+        if is_multiedge(graph, u, v):
+            continue
+
+        kempe_chain_color_swap(graph, (u, v), c, other_color)
+        if graph_zobrist_hash(graph) not in seen_colorings:
+            if logger.isEnabledFor(logging.DEBUG): logger.debug("Switch to an unseen coloring: %s (swap_c1: %s, swap_c2: %s)", (u, v), c, other_color)
+            return True
+
+        # Undo
+        kempe_chain_color_swap(graph, (u, v), other_color, c)
+
+    return False
+
+
 def remove_vertex_from_face(face, vertex):
     """
     Remove a vertex from a face
@@ -934,8 +1611,7 @@ def join_faces(f1, f2, edge_to_remove_on_f1):
 
     # You can only use this function if at least one face has length > 2
     if len(f1) == 2 and len(f2) == 2:
-        logger.error("Unexpected condition (f2 + f2 would generate a single edge face). Mario you'd better go back to paper")
-        exit(-1)
+        raise ValueError("Unexpected condition (f2 + f2 would generate a single edge face). Mario you'd better go back to paper")
 
     # The edge (v1, v2) on f1 is (v2, v1) on the f2 face
     edge_to_remove_on_f2 = rotate(edge_to_remove_on_f1, 1)
@@ -984,8 +1660,7 @@ def join_faces(f1, f2, edge_to_remove_on_f1):
     if logger.isEnabledFor(logging.DEBUG): logger.debug("f1_plus_f2: %s", f1_plus_f2)
 
     if len(f1_plus_f2) == 2 and (f1_plus_f2[0][0] != f1_plus_f2[1][1] or f1_plus_f2[0][1] != f1_plus_f2[1][0]):
-        logger.error("Unexpected condition (f2 faces have to be: [(v1, v2), (v2, v1)]. Mario you'd better go back to paper")
-        exit(-1)
+        raise ValueError("Unexpected condition (f2 faces have to be: [(v1, v2), (v2, v1)]. Mario you'd better go back to paper")
 
     if logger.isEnabledFor(logging.DEBUG): logger.debug("END: join_faces")
 
@@ -1034,6 +1709,92 @@ def is_the_graph_one_edge_connected(face):
     return is_the_graph_one_edge_connected
 
 
+def index_faces_by_edge(g_faces):
+    """
+    Index the faces by their edges: (v1, v2) -> the faces that have the edge (v1, v2).\n
+    An edge separates two faces, one for each direction: the face on the other side of (v1, v2) is indexed under (v2, v1).\n
+    With multiple edges the same (v1, v2) can be in two faces (the F2 and its neighbor), this is why the values are lists.\n
+    While the faces change, the index has to be kept up to date with remove_face_from_the_index() and add_face_to_the_index().
+
+    Parameters
+    ----------
+        g_faces: The graph as a list of faces
+
+    Returns
+    -------
+        faces_by_edge: The index {(v1, v2): [face, ...]}
+    """
+
+    faces_by_edge = {}
+    for face in g_faces:
+        add_face_to_the_index(faces_by_edge, face)
+
+    return faces_by_edge
+
+
+def add_face_to_the_index(faces_by_edge, face):
+    """
+    Add all the edges of a face to the index of the faces by edge (see index_faces_by_edge())
+
+    Parameters
+    ----------
+        faces_by_edge: The index
+        face: The face to add (the list itself is indexed, not a copy)
+    """
+
+    for edge in face:
+        if edge in faces_by_edge:
+            faces_by_edge[edge].append(face)
+        else:
+            faces_by_edge[edge] = [face]
+
+
+def remove_face_from_the_index(faces_by_edge, face):
+    """
+    Remove all the edges of a face from the index of the faces by edge (see index_faces_by_edge())\n
+    It has to be called before the face changes: the edges to remove are the ones that the face has now.
+
+    Parameters
+    ----------
+        faces_by_edge: The index
+        face: The face to remove (faces are compared by identity, two different faces may have the same representation)
+    """
+
+    for edge in face:
+        faces_of_the_edge = faces_by_edge[edge]
+        i_face = next(i_face for i_face, face_of_the_edge in enumerate(faces_of_the_edge) if face_of_the_edge is face)
+        del faces_of_the_edge[i_face]
+        if len(faces_of_the_edge) == 0:
+            del faces_by_edge[edge]
+
+
+def would_the_graph_be_one_edge_connected(faces_by_edge, f1, f2):
+    """
+    Check if removing an edge between f1 and f2 would make the graph 1-edge-connected, without joining the two faces.\n
+    While reducing, the graph has no edges with the same face on both sides. The joined face would have one (see is_the_graph_one_edge_connected()) only if f1 and f2 share another edge, other than the one to remove.\n
+    So it is enough to count the edges of f1 that have f2 on the other side: O(len(f1)) with the index, instead of O(len(f1 + f2)^2) of join_faces() + is_the_graph_one_edge_connected().
+
+    Parameters
+    ----------
+        faces_by_edge: The index of the faces by edge (see index_faces_by_edge())
+        f1: The face of the edge to remove
+        f2: The face on the other side of the edge to remove
+
+    Returns
+    -------
+        would_the_graph_be_one_edge_connected: True of False
+    """
+
+    edges_shared_with_f2 = 0
+    for v1, v2 in f1:
+        if any(face is f2 for face in faces_by_edge.get((v2, v1), ())):
+            edges_shared_with_f2 += 1
+
+    if logger.isEnabledFor(logging.DEBUG): logger.debug("Edges shared by f1 and f2: %s", edges_shared_with_f2)
+
+    return edges_shared_with_f2 > 1
+
+
 def get_the_other_colors(colors):
     """
     Get the other colors
@@ -1,188 +1,418 @@
-/* PLUGIN file to use with plantri.c 
+/* PLUGIN file to use with plantri.c
 
-   To use this, compile plantri.c using 
+   To use this, compile plantri.c using
        cc -o plantri_deg -O4 '-DPLUGIN="degseq.c"' plantri.c
 
    This plug-in adds a count of the generated graphs by
    degree sequence.  Also report counts by minimum degree,
    maximum degree, and bipartiteness (i.e. even degrees).
+
+   A degree sequence is kept as the number of vertices of each
+   degree, DSQ_LANES counts to a 64-bit word, and looked up in an
+   open-addressing hash table.  The counts by minimum and maximum
+   degree and the bipartite count are updated for each graph.
+
+   The summaries of several runs (for example the parts res/mod of
+   one job) can be added together by the same code compiled alone:
+       cc -o degseq_merge -O4 -DDSQ_MERGE degseq.c
+       degseq_merge part0.err part1.err ...
+   reads the summaries from the files (or stdin), skips all other
+   lines, and prints the summary of the whole job in the same format.
+   Use -DMAXN=# if plantri_deg was compiled with a larger MAXN.
 */
 
+#ifdef DSQ_MERGE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef MAXN
+#define MAXN 64
+#endif
+typedef unsigned long long bigint;
+#define PRINTBIG(file,big) fprintf(file,"%llu",(big))
+static FILE *msgfile;
+#else
 #define FILTER degseq_counter
 #define SUMMARY summary
-
-#define MAXNFT MAXN
-typedef struct countrec
+#endif
+
+#if MAXN > 255
+#define DSQ_LANEBITS 16
+#else
+#define DSQ_LANEBITS 8
+#endif
+#define DSQ_LANES (64/DSQ_LANEBITS)
+#define DSQ_LANEMASK ((1ULL << DSQ_LANEBITS) - 1)
+#define DSQ_MAXDEG (6*MAXN)
+#define DSQ_MAXWORDS (DSQ_MAXDEG/DSQ_LANES + 1)
+
+typedef struct
 {
-    struct countrec *left,*right;
-    bigint count;
-    unsigned char seq[MAXN+1];
-} countnode;
+    unsigned long long *key;   /* dsq_words words per slot */
+    bigint *count;             /* 0 for an empty slot */
+    size_t size;               /* number of slots, a power of 2 */
+    size_t used;               /* number of full slots */
+    bigint minmax[6][DSQ_MAXDEG+1];
+    bigint bipcount;
+} dsq_table;
 
-static countnode *count_root = NULL;
-static unsigned long seqcount = 0;
+static dsq_table dsq_count;
+static int dsq_words;          /* words per key */
+static int dsq_maxdeg;         /* largest degree that can occur */
 
-static bigint minmax[6][MAXN+1],bipcount;
+#ifndef DSQ_MERGE
+static void degseq_init(void);
 
 #define PLUGIN_INIT \
   {if (maxnv > 72) \
-    fprintf(stderr,"Warning, this plugin does not work well for n > 72\n");}
+    fprintf(stderr,"Warning, this plugin does not work well for n > 72\n"); \
+   degseq_init();}
 
 /*********************************************************************/
 
 static void
-print_counts(FILE *f, countnode *root)
+degseq_init(void)
+
+/* Choose the key length.  Only -Q and the triangulations with -c1 or -c2
+   can have multiple edges, and then a degree can exceed maxnv. */
+{
+    if (Qswitch || (minconnec >= 0 && minconnec < 3
+                    && !pswitch && !qswitch && polygonsize < 0))
+        dsq_maxdeg = 6*maxnv;
+    else
+        dsq_maxdeg = maxnv;
+
+    if (dsq_maxdeg > DSQ_MAXDEG) dsq_maxdeg = DSQ_MAXDEG;
+    dsq_words = dsq_maxdeg / DSQ_LANES + 1;
+}
+#endif
+
+/*********************************************************************/
+
+static size_t
+dsq_hash(unsigned long long *key)
 {
     int i;
+    unsigned long long h;
 
-    if (root == NULL) return;
+    h = 0;
+    for (i = 0; i < dsq_words; ++i)
+    {
+        h = (h ^ key[i]) * 0x9E3779B97F4A7C15ULL;
+        h ^= h >> 29;
+    }
 
-    print_counts(f,root->left);
+    return (size_t)h;
+}
 
-    fprintf(f," ");
-    for (i = 0; i < maxnv; ++i)
-	fprintf(f,"%c",root->seq[i]<10?'0'+root->seq[i]:'A'-10+root->seq[i]);
-    fprintf(f,"  ");
-    PRINTBIG(f,root->count);
-    fprintf(f,"\n");
+/*********************************************************************/
 
-    minmax[root->seq[0]][root->seq[maxnv-1]] += root->count;
-    for (i = 0; i < maxnv; ++i)
-	if (root->seq[i] & 1) break;
-    if (i == maxnv) SUMBIGS(bipcount,root->count);
-    
-    print_counts(f,root->right);
+static void
+dsq_resize(dsq_table *t, size_t newsize)
+{
+    unsigned long long *oldkey;
+    bigint *oldcount;
+    size_t i,j,oldsize;
+    int k;
+
+    oldkey = t->key;
+    oldcount = t->count;
+    oldsize = t->size;
+
+    t->key = (unsigned long long*)
+                      malloc(newsize*dsq_words*sizeof(unsigned long long));
+    t->count = (bigint*)calloc(newsize,sizeof(bigint));
+    if (t->key == NULL || t->count == NULL)
+    {
+        fprintf(stderr,">E malloc failed in dsq_resize()\n");
+        exit(1);
+    }
+    t->size = newsize;
+
+    for (i = 0; i < oldsize; ++i)
+    if (oldcount[i] != 0)
+    {
+        j = dsq_hash(oldkey+i*dsq_words) & (newsize-1);
+        while (t->count[j] != 0) j = (j+1) & (newsize-1);
+        for (k = 0; k < dsq_words; ++k)
+            t->key[j*dsq_words+k] = oldkey[i*dsq_words+k];
+        t->count[j] = oldcount[i];
+    }
+
+    if (oldsize > 0)
+    {
+        free(oldkey);
+        free(oldcount);
+    }
 }
 
 /*********************************************************************/
 
 static void
-add_degseq(int num, unsigned char *seq)
+dsq_add(dsq_table *t, unsigned long long *key, bigint num)
 {
-    int i,cmp;
-    countnode *p,*ppar,*new_node;
+    size_t j;
+    int k;
+    unsigned long long *p;
 
-    p = count_root;
-    cmp = 0;
+    if (2*(t->used+1) > t->size)
+        dsq_resize(t,t->size == 0 ? 1024 : 2*t->size);
 
-    while (p != NULL)
+    j = dsq_hash(key) & (t->size-1);
+    while (t->count[j] != 0)
     {
-        cmp = strcmp(seq,p->seq);
-        if (cmp == 0)
+        p = t->key + j*dsq_words;
+        for (k = 0; k < dsq_words; ++k)
+            if (p[k] != key[k]) break;
+        if (k == dsq_words)
         {
-            p->count += num;
+            t->count[j] += num;
             return;
         }
-        else if (cmp < 0)
-        {
-            ppar = p;
-            p = p->left;
-        }
-        else
-        {
-            ppar = p;
-            p = p->right;
-        }
+        j = (j+1) & (t->size-1);
     }
 
-    if ((new_node = (countnode*)malloc(sizeof(countnode))) == NULL)
+    p = t->key + j*dsq_words;
+    for (k = 0; k < dsq_words; ++k) p[k] = key[k];
+    t->count[j] = num;
+    ++t->used;
+}
+
+/*********************************************************************/
+
+static unsigned long long *dsq_sortkeys;
+
+static int
+dsq_compare(const void *a, const void *b)
+
+/* Order two slots the way strcmp() orders the sorted sequences:
+   at the first degree with different counts, the sequence with
+   more vertices of that degree comes first. */
+{
+    unsigned long long *ka,*kb,x;
+    int k,sh;
+
+    ka = dsq_sortkeys + *(const size_t*)a * dsq_words;
+    kb = dsq_sortkeys + *(const size_t*)b * dsq_words;
+
+    for (k = 0; k < dsq_words; ++k)
+    if (ka[k] != kb[k])
     {
-        fprintf(stderr,">E malloc failed in add_degseq()\n");
-        exit(1);
+        x = ka[k] ^ kb[k];
+        for (sh = 0; ((x >> sh) & DSQ_LANEMASK) == 0; sh += DSQ_LANEBITS) {}
+        return ((ka[k] >> sh) & DSQ_LANEMASK) > ((kb[k] >> sh) & DSQ_LANEMASK)
+               ? -1 : 1;
     }
 
-    new_node->count = num;
-    strcpy(new_node->seq,seq);
-    new_node->left = new_node->right = NULL;
-    ++seqcount;
-
-    if (cmp == 0)
-        count_root = new_node;
-    else if (cmp < 0)
-        ppar->left = new_node;
-    else
-        ppar->right = new_node;
+    return 0;
 }
 
 /*********************************************************************/
 
 static void
-sortchar(unsigned char *x, int k)
+print_counts(FILE *f, dsq_table *t)
 {
-        register int i,j,h;
-        unsigned char iw;
+    size_t i,j,*order;
+    int d,k;
+    unsigned long long *p;
 
-        j = k / 3;
-        h = 1;
-        do
-            h = 3 * h + 1;
-        while (h < j);
+    if (t->used == 0) return;
 
-        do
-        {
-            for (i = h; i < k; ++i)
-            {
-                iw = x[i];
-                for (j = i; x[j-h] > iw; )
-                {
-                    x[j] = x[j-h];
-                    if ((j -= h) < h) break;
-                }
-                x[j] = iw;
-            }
-            h /= 3;
-        }
-        while (h > 0);
+    if ((order = (size_t*)malloc(t->used*sizeof(size_t))) == NULL)
+    {
+        fprintf(stderr,">E malloc failed in print_counts()\n");
+        exit(1);
+    }
+
+    for (i = j = 0; i < t->size; ++i)
+        if (t->count[i] != 0) order[j++] = i;
+
+    dsq_sortkeys = t->key;
+    qsort(order,t->used,sizeof(size_t),dsq_compare);
+
+    for (i = 0; i < t->used; ++i)
+    {
+        p = t->key + order[i]*dsq_words;
+        fprintf(f," ");
+        for (d = 1; d <= dsq_maxdeg; ++d)
+            for (k = (p[d/DSQ_LANES] >> (DSQ_LANEBITS*(d%DSQ_LANES)))
+                                                   & DSQ_LANEMASK; --k >= 0; )
+                fprintf(f,"%c",d<10?'0'+d:'A'-10+d);
+        fprintf(f,"  ");
+        PRINTBIG(f,t->count[order[i]]);
+        fprintf(f,"\n");
+    }
+
+    free(order);
 }
 
+#ifndef DSQ_MERGE
 /*********************************************************************/
 
 static int
 degseq_counter(int nbtot, int nbop, int doflip)
-/* Assumption: all degrees are in 1..73 */
 {
-    int i,j;
-    unsigned char degseq[MAXN+1];
+    int i,d,mind,maxd,alldeg;
+    unsigned long long key[DSQ_MAXWORDS];
+    dsq_table *t;
 
-    j = 0;
-    for (i = (missing_vertex >= 0 ? nv+1 : nv); --i >= 0;)
-        if (i != missing_vertex) degseq[j++] = degree[i];
-    degseq[nv] = '\0';
+    for (i = 0; i < dsq_words; ++i) key[i] = 0;
 
-    sortchar(degseq,nv);
+    mind = dsq_maxdeg;
+    maxd = alldeg = 0;
+    for (i = (missing_vertex >= 0 ? nv+1 : nv); --i >= 0;)
+    if (i != missing_vertex)
+    {
+        d = degree[i];
+        key[d/DSQ_LANES] += 1ULL << (DSQ_LANEBITS*(d%DSQ_LANES));
+        if (d < mind) mind = d;
+        if (d > maxd) maxd = d;
+        alldeg |= d;
+    }
 
-    add_degseq(doflip+1,degseq); 
+    t = &dsq_count;
+    dsq_add(t,key,doflip+1);
+    if (mind < 6) t->minmax[mind][maxd] += doflip+1;
+    if ((alldeg & 1) == 0) t->bipcount += doflip+1;
 
     return TRUE;
 }
 
+#endif
+
 /*********************************************************************/
 
 static void
 summary()
 {
     int i,j;
+    dsq_table *t;
 
-    for (i = 1; i < 6; ++i)
-    for (j = 1; j <= maxnv; ++j)
-	minmax[i][j] = 0;
-
-    bipcount = 0;
+    t = &dsq_count;
 
-    fprintf(msgfile,"%lu degree sequences:\n",seqcount);
-    print_counts(msgfile,count_root);    
+    fprintf(msgfile,"%lu degree sequences:\n",(unsigned long)t->used);
+    print_counts(msgfile,t);
 
     fprintf(msgfile,"Counts by minimum and maximum degree:\n");
     for (i = 1; i < 6; ++i)
-    for (j = 1; j <= maxnv; ++j)
-	if (minmax[i][j] > 0)
+    for (j = 1; j <= dsq_maxdeg; ++j)
+	if (t->minmax[i][j] > 0)
 	{
 	    fprintf(msgfile," %2d-%2d : ",i,j);
-	    PRINTBIG(msgfile,minmax[i][j]);
+	    PRINTBIG(msgfile,t->minmax[i][j]);
 	    fprintf(msgfile,"\n");
 	}
 
     fprintf(msgfile,"Bipartite : ");
-    PRINTBIG(msgfile,bipcount);
+    PRINTBIG(msgfile,t->bipcount);
     fprintf(msgfile,"\n");
 }
+
+#ifdef DSQ_MERGE
+/*********************************************************************/
+
+static int
+dsq_read(FILE *f, char *filename)
+
+/* Add the summaries found in f to dsq_count.  Return the number
+   of summaries found. */
+{
+    char line[MAXN+100],seq[MAXN+100];
+    unsigned long long key[DSQ_MAXWORDS];
+    bigint num;
+    int i,j,d,k,section,nsum;
+
+    section = nsum = 0;
+    while (fgets(line,sizeof(line),f) != NULL)
+    {
+        if (strchr(line,'\n') == NULL && !feof(f))
+        {
+            fprintf(stderr,">E degseq_merge: line too long in %s\n",filename);
+            exit(1);
+        }
+
+        if (strstr(line," degree sequences:") != NULL)
+        {
+            section = 1;
+            ++nsum;
+        }
+        else if (strncmp(line,"Counts by minimum and maximum degree:",37) == 0)
+            section = 2;
+        else if (section > 0 && sscanf(line,"Bipartite : %llu",&num) == 1)
+        {
+            dsq_count.bipcount += num;
+            section = 0;
+        }
+        else if (section == 1 && line[0] == ' '
+                 && sscanf(line," %s %llu",seq,&num) == 2)
+        {
+            for (k = 0; k < dsq_words; ++k) key[k] = 0;
+            for (k = 0; seq[k] != '\0'; ++k)
+            {
+                d = (seq[k] <= '9' ? seq[k] - '0' : seq[k] - 'A' + 10);
+                if (d < 1 || d > dsq_maxdeg)
+                {
+                    fprintf(stderr,">E degseq_merge: bad degree sequence"
+                                   " %s in %s\n",seq,filename);
+                    exit(1);
+                }
+                key[d/DSQ_LANES] += 1ULL << (DSQ_LANEBITS*(d%DSQ_LANES));
+            }
+            dsq_add(&dsq_count,key,num);
+        }
+        else if (section == 2 && sscanf(line," %d-%d : %llu",&i,&j,&num) == 3)
+        {
+            if (i < 1 || i >= 6 || j < 1 || j > dsq_maxdeg)
+            {
+                fprintf(stderr,">E degseq_merge: bad degree range"
+                               " %d-%d in %s\n",i,j,filename);
+                exit(1);
+            }
+            dsq_count.minmax[i][j] += num;
+        }
+        else
+            section = 0;
+    }
+
+    return nsum;
+}
+
+/*********************************************************************/
+
+int
+main(int argc, char *argv[])
+{
+    FILE *f;
+    int i,nsum;
+
+    msgfile = stdout;
+    dsq_maxdeg = DSQ_MAXDEG;
+    dsq_words = dsq_maxdeg / DSQ_LANES + 1;
+
+    nsum = 0;
+    if (argc == 1)
+        nsum += dsq_read(stdin,"stdin");
+    else
+        for (i = 1; i < argc; ++i)
+        {
+            if ((f = fopen(argv[i],"r")) == NULL)
+            {
+                fprintf(stderr,">E degseq_merge: can't open %s\n",argv[i]);
+                exit(1);
+            }
+            nsum += dsq_read(f,argv[i]);
+            fclose(f);
+        }
+
+    if (nsum == 0)
+    {
+        fprintf(stderr,">E degseq_merge: no degree sequence summary found\n");
+        exit(1);
+    }
+
+    summary();
+    fprintf(stderr,">Z %d summaries merged\n",nsum);
+
+    return 0;
+}
+#endif
@@ -12,6 +12,47 @@
    output auf stdout geloest. */
 /* 13.2.2016: Fehler bei Detektierung von Cs mit Fixkanten verbessert */
 /* 23.2.2016: Den Effekt desselben Fehlers bei anderen Gruppen entfernt. */
+/* 18.10.2026: Option "threads": die Arbeitseinheiten der drei Faelle werden
+   nach baue_patches() auf mehrere Prozesse verteilt. */
+/* 18.10.2026: Die Patchlisten werden nach baue_patches() in einen Block ohne
+   Zeiger verdichtet, der mit "patchfile" gespeichert und wieder gelesen
+   werden kann. */
+/* 18.10.2026: codeart 3 sortiert nicht mehr mit einem binaeren Suchbaum je
+   listenlaenge Codes, sondern sortiert die ganze Datei (Radixsort des
+   Puffers, Laeufe in Hilfsdateien, Mischen am Ende). */
+/* 18.10.2026: Mit -DFULLGEN_LIBRARY als Bibliothek mit Rueckruf-Funktion
+   zu benutzen, siehe fullgen.h. */
+/* 18.10.2026: S kann mit -DS=... beim Uebersetzen gesetzt werden
+   ("make fullgen_wide"). Passt S+12 nicht mehr in ein Byte, ist FLAECHENTYP
+   unsigned short; die ausgegebenen Codes sind davon getrennt (CODETYP).
+   KANTE.dummy ist int statt long (40 statt 48 Bytes je Kante), und die
+   maps werden nach der wirklich gebrauchten Knotenzahl alloziert. */
+/* 18.10.2026: Die Spiralen werden auf den Flaechen entwickelt, die
+   baue_spiralflaechen() einmal je map bestimmt (Markierung mit Epochen statt
+   dummy), und abgebrochen, sobald der Code nicht mehr kleiner werden kann.
+   Anzahl der Versuche und Zeit stehen in der Statistik. */
+/* 18.10.2026: Die Ausgabedateien bekommen grosse Puffer; die Dateien fuer
+   Fullerene ohne Spirale werden nicht mehr fuer jeden Graphen geoeffnet
+   und geschlossen, sondern bleiben offen. vegacode() ohne fprintf().
+   Option "container": alle Knotenzahlen in einer Datei mit Index. */
+/* 18.10.2026: Optionen "stats" (Zeiten der Phasen und Zaehler als JSON, auch
+   wo minitest() verwirft) und "progress". */
+/* 18.10.2026: minitest() loescht die Marken nicht mehr fuer jede map,
+   sondern zaehlt edgemark ueber alle Aufrufe weiter; die Kantenmarken
+   stehen in einem eigenen Feld statt in dummy. */
+/* 19.10.2026: Option "symmonly": mit "symm" werden maps, die keine der
+   gewaehlten Symmetrien haben koennen, in minitest() vor dem Ablaufen der
+   Pfade (Klassen von 5-Ecken) oder vor der Rekonstruktion (Zahl der
+   gleichen Pfade) verworfen; gezaehlt werden nur die gewaehlten. */
+/* 19.10.2026: Alle Variablen und Funktionen ausser fullgen_run(),
+   fullgen_set_callback() und fullgen_symmetry_name() sind static, damit
+   libfullgen.a keine weiteren Namen exportiert. Ein zweiter Aufruf von
+   fullgen_run() wird abgewiesen. */
+/* 19.10.2026: bauchbinde_reko(), brille_reko(), sandwich_reko() und die
+   _sp-Versionen loeschen dummy, noleft, noright und mininame nicht mehr
+   fuer die ganze map, sondern belegen einen Knoten beim ersten Zugriff in
+   der Epoche (REKO()); reko_bb_code() markiert die Knoten des Patches mit
+   einer Epoche statt mit einem geloeschten Feld. */
 
 #include<sys/types.h>
 #include<unistd.h>
@@ -21,20 +62,32 @@
 #include<limits.h>
 #include<sys/stat.h>
 #include<string.h>
+#include<sys/mman.h>
+#include<fcntl.h>
+
+#include "fullgen.h"
+#include<sys/wait.h>
+#include<sys/time.h>
 
 #ifndef NOTIMES
 #include<time.h>
 #include<sys/times.h>
 #endif //NOTIMES
 
+#ifndef S
 #define S        140           /* Maximale Anzahl der 6-Ecke */
+#endif
 #define N        ((4*S)+20)    /* Maximal moegliche Anzahl der Knoten */
 
 
 #define aussen   (N+2) /* so werden kanten nach aussen markiert */
 
-#define infty    LONG_MAX
+#define infty    INT_MAX
+#if (S+12 > UCHAR_MAX-2)
+#define FL_MAX   USHRT_MAX
+#else
 #define FL_MAX   UCHAR_MAX
+#endif
 #define KN_MAX   USHRT_MAX
 #define unbelegt FL_MAX
 #define leer     KN_MAX-1
@@ -108,7 +161,7 @@ static unsigned short word = (((unsigned short) 'b') << 8) | 'l';
 
 /* konstante Strings zur Kennzeichnung der Symmetriegruppen: */
 
-char symm_name[29][4] =
+static char symm_name[29][4] =
   {{' ',' ',' ','\0'},  {'C','1',' ','\0'},  {'C','2',' ','\0'},
    {'C','i',' ','\0'},  {'C','s',' ','\0'},  {'C','3',' ','\0'},
    {'D','2',' ','\0'},  {'S','4',' ','\0'},  {'C','2','v','\0'},
@@ -124,15 +177,17 @@ char symm_name[29][4] =
 
 typedef  char BOOL; /* von 0 verschieden entspricht True */
 
-typedef unsigned short KNOTENTYP;   
-typedef unsigned char FLAECHENTYP; /* Bereich 1..252 */ /* DO NOT CHANGE ! Changes in the coding
-				      and at several places where FL_MAX is used (as a sign !)
-				      are necessary */
+/* KNOTENTYP und KANTE stehen in fullgen.h */
+#if (FL_MAX == UCHAR_MAX)
+typedef unsigned char FLAECHENTYP; /* Bereich 1..FL_MAX-2 */
+#else
+typedef unsigned short FLAECHENTYP; /* fuer grosse S -- FL_MAX und FL_MAX-1 sind Marken */
+#endif
+typedef unsigned char CODETYP; /* ein Byte der ausgegebenen Codes */
+#define CODELAENGE (8*N+3) /* laengster Code 1 -- mit zwei Bytes je Eintrag */
 
 typedef KNOTENTYP GRAPH[N+1][3]; /* fuer schreibegraph und Isomorphietest */
 
-/* Element der Adjazenztabelle: */
-
 
 typedef struct BBiL {
 		  struct BBiL *next_item;
@@ -150,6 +205,11 @@ typedef struct iL {
 		  FLAECHENTYP code[5];
 		} ITEMLISTE; /* die Items -- d.h. Codes */
 
+typedef struct iallocL {
+		  struct iallocL *prev;
+		  ITEMLISTE *space;
+		} ALLOCLISTE; /* die allozierten 1000er itemfelder */
+
 
 typedef struct BBsL {
 		  int number_next;
@@ -179,20 +239,42 @@ typedef struct SL {
  		  } S_LISTE; /* die erste stufe der liste -- verzweigung nach Anzahl der 6-Ecke */
 
 
-typedef struct K {
-                   KNOTENTYP ursprung; /* bei welchem knoten startet die kante */
-                   KNOTENTYP name;  /* Identifikation des Knotens, mit
-                                       dem Verbindung besteht */
-		   long dummy;   /* fuer alle moeglichen zwecke */
-		   BOOL nostart;
-		   BOOL noleft; /* fuer die Rekonstruktion: Keine Flaeche links hiervon */
-		   BOOL noright; /* fuer die Rekonstruktion: Keine Flaeche rechts hiervon */
-		   BOOL mirror_nostart;
-		   KNOTENTYP mininame; /* jeweils fuer den minimalitaetstest */
-                   struct K *prev;  /* vorige Kante im Uhrzeigersinn */
-                   struct K *next;  /* naechste Kante im Uhrzeigersinn */
-		   struct K *invers; /* die inverse Kante (in der Liste von "name") */
-                  } KANTE;
+/* Nach baue_patches() werden die Listen von verdichte_patches() in einen
+   einzigen Speicherblock ohne Zeiger umgeschrieben: vorne ein PATCHKOPF,
+   dahinter die Felder, deren Laengen im Kopf stehen. Alle Verweise sind
+   Indizes, so dass der Block unveraendert in eine Datei geschrieben und
+   spaeter mit mmap() (nur lesend, von vielen Prozessen gemeinsam) wieder
+   benutzt werden kann. Die Items einer Liste liegen hintereinander in der
+   Reihenfolge, in der sie vorher in der Liste standen. */
+
+#define PATCHVERSION 1
+
+typedef struct { FLAECHENTYP code[5]; } PATCHITEM;
+typedef struct { FLAECHENTYP code[8]; } BBPATCHITEM;
+
+typedef struct {
+		  int number_next; /* wie bei SEQUENZLISTE */
+		  int kinder;      /* erster Eintrag in patchkinder[] -- dort steht der Index 
+				      des Nachfolgers oder -1 */
+		  int erstes, anzahl; /* die Items in patchitems[] */
+		} PATCHKNOTEN; /* ein Knoten der Sequenzliste */
+
+typedef struct { int erstes, anzahl; } BBFACH; /* die Items in bbpatchitems[] */
+
+typedef struct {
+		  char kennung[16];  /* "fullgen patches" */
+		  int version, n, s, endian;
+		  int sechsecke, ipr;
+		  int mit_bb, mit_map; /* fuer bauchbinde bzw. brille und sandwich gebaut */
+		  int total_maps, bb_total_items, bb_total_maps;
+		  int minbbl, maxbbl, minbrillenglas, maxbrillenglas, min_2_3_4;
+		  int anzahl_knoten, anzahl_kinder, anzahl_items, anzahl_bbfaecher, anzahl_bbitems;
+		  int wurzel[S+1];   /* Knoten fuer die jeweilige Anzahl der 6-Ecke */
+		  int bbanfang[S+1], bbanzahl[S+1]; /* die Faecher in bbfaecher[] */
+		  BOOL bblmark[N+1], brillenglasmark[N+1], zwei_3_4_mark[N+1];
+		  long long int groesse; /* des ganzen Blocks in Bytes */
+		} PATCHKOPF;
+
 
 typedef struct  {
                    int laenge;
@@ -202,9 +284,19 @@ typedef struct  {
 		 } SEQUENZ;
 
 
-typedef struct le { FLAECHENTYP code[12];
-		    struct le *smaller;
-		    struct le *larger; } LISTENTRY;
+/* Fuer codeart 3 werden die Spiralcodes jeder Knotenzahl in einem Puffer
+   fuer listenlaenge Codes gesammelt. Ist er voll, wird er sortiert und als
+   "Lauf" in eine Hilfsdatei geschrieben. Am Ende werden alle Laeufe
+   gemischt, so dass die ganze Datei sortiert ist. */
+
+typedef struct { CODETYP *codes; /* je 12 Bytes */
+		 int anzahl;         /* Codes im Puffer */
+		 int laeufe;         /* geschriebene Laeufe */
+	       } SORTIERLISTE;
+
+typedef struct { int arbeiter, nummer; } LAUF; /* bestimmt den Namen der Lauf-Datei */
+
+#define MAXMISCHEN 256 /* so viele Laeufe werden hoechstens gleichzeitig gemischt */
 
 
 /* "Ueberschrift" der Adjazenztabelle (Array of Pointers): */
@@ -224,73 +316,173 @@ typedef KANTE PLANMAP[N+1][3];
 /* Variablen-Deklarationen: */
 
 
-int output; /* soll auf stdout geschrieben werden */
-int knotenzahl;  /* Knotenzahl des Graphen;
+static int knotenzahl;  /* Knotenzahl des Graphen;
 		   ergibt sich aus Eingabe; wird im Verlauf
 		   der Konstruktion nicht geaendert */
 
-long long int non_iso_graphenzahl[N+1];
-long long int graphenzahl[N+1];
-
-S_LISTE mapliste;
-BBS_LISTE bbliste;
-
-KANTE *F_eck_kanten[60]; /* eine liste aller kanten, so dass links davon ein
-			    5-Eck liegt */
-int anzahl_5ek; /* die momentane Anzahl der eingetragenen kanten */
-
-int max_sechsecke,min_sechsecke;
+static long long int non_iso_graphenzahl[N+1];
+static long long int graphenzahl[N+1];
 
-FLAECHENTYP **lastcode[N]; /* wird bei codeart 3 gebraucht */
-FLAECHENTYP last_code[12]; /* wird bei codeart 2 gebraucht */
+static S_LISTE mapliste;
+static BBS_LISTE bbliste;
 
-int minbbl=N, maxbbl=0;
-int minbrillenglas=N, maxbrillenglas=0;
-int min_2_3_4=N;
-int no_penta_spiral=0, no_hexa_spiral=0;
+static PATCHKOPF *patchkopf=nil; /* die verdichteten Listen -- siehe PATCHKOPF */
+static PATCHKNOTEN *patchknoten;
+static int *patchkinder;
+static BBFACH *bbfaecher;
+static PATCHITEM *patchitems;
+static BBPATCHITEM *bbpatchitems;
+static char *patchdateiname=nil;   /* Option "patchfile" */
+static BOOL patches_gelesen=0;
 
-BOOL bblmark[N+1], brillenglasmark[N+1], zwei_3_4_mark[N+1];
-BOOL do_bauchbinde,do_brille,do_sandwich;
+static ALLOCLISTE *itemfelder=nil;     /* zum Freigeben der Felder von itemalloc() */
+static BBALLOCLISTE *bbitemfelder=nil; /* und bbitemalloc() */
 
-LISTENTRY codeliste[N+1];
-
-FILE *fil[N+1];
-int write_header_fil[N+1];
-int write_header_stdout=1;
-FILE *logfile;
-char logfilename[filenamenlaenge], no_penta_spiral_filename[filenamenlaenge], no_spiral_filename[filenamenlaenge];
-char no_hexa_spiral_filename[filenamenlaenge];
+static KANTE *F_eck_kanten[60]; /* eine liste aller kanten, so dass links davon ein
+			    5-Eck liegt */
+static int anzahl_5ek; /* die momentane Anzahl der eingetragenen kanten */
+
+/* Die Flaechen der map fuer die Spiralen -- siehe baue_spiralflaechen().
+   Kanten werden als Abstand zu sp_basis (map[0]) angegeben. */
+typedef struct { int groesse;
+		 int nachbar[12];  /* die Nachbarflaechen in Laufrichtung -- zweimal
+				      hintereinander, damit nicht modulo groesse
+				      gerechnet werden muss */
+		 int eintritt[12]; /* die Stelle, an der nachbar[i] betreten wird */
+	       } SPIRALFLAECHE;
+static SPIRALFLAECHE sp_flaeche[S+13];
+static int sp_flaechenzahl;
+static int sp_rechts[3*(2*S+21)], sp_position[3*(2*S+21)]; /* Flaeche und Stelle je Kante */
+static unsigned int sp_platziert[S+13], sp_epoche=0; /* eingefuegt, wenn == sp_epoche */
+static KANTE *sp_basis;
+static BOOL sp_aktuell=0; /* stimmen die Flaechen fuer die map in codiereplanar() ? */
+static long long int spiralversuche=0; /* Aufrufe von spirale() */
+#ifndef NOTIMES
+static clock_t spiralzeit=0; /* Zeit in spiralcode(), minspiralcode() und spiralstatistic() */
+#endif
 
-BOOL quiet=0;
-BOOL IPR=0, is_ipr=1;
-BOOL to_stdout=0;
-BOOL hexspi=0, spistat=0;
-BOOL spiralcheck=0;
-int codenumber, listenlaenge, mod=0, rest=0;
-int spiralnumbers[12*S+120+1];
+static int max_sechsecke,min_sechsecke;
+static int maxknoten=N; /* so viele Zeilen haben die maps in diesem Lauf -- 4*max_sechsecke+20 */
+
+static CODETYP last_code[12]; /* wird bei codeart 2 gebraucht */
+
+static int minbbl=N, maxbbl=0;
+static int minbrillenglas=N, maxbrillenglas=0;
+static int min_2_3_4=N;
+static int no_penta_spiral=0, no_hexa_spiral=0;
+
+static BOOL bblmark[N+1], brillenglasmark[N+1], zwei_3_4_mark[N+1];
+static BOOL do_bauchbinde,do_brille,do_sandwich;
+
+static SORTIERLISTE codeliste[N+1]; /* wird bei codeart 3 gebraucht */
+static CODETYP *sortierhilfe=nil;
+
+static FILE *fil[N+1];
+static int write_header_fil[N+1];
+static int write_header_stdout=1;
+static FILE *ohne_spirale[3]={nil,nil,nil}; /* No_spiral, No_pentagon_spiral und
+					 No_hexagon_spiral -- werden erst beim
+					 ersten Graphen geoeffnet */
+static char *ausgabepuffer[N+4]; /* Puffer der Ausgabedateien -- Nummern wie bei
+			     hilfsdateiname() */
+static size_t ausgabepuffergroesse=1<<20;
+static char *containername=nil; /* Option "container" */
+static FILE *logfile;
+static char logfilename[filenamenlaenge], no_penta_spiral_filename[filenamenlaenge], no_spiral_filename[filenamenlaenge];
+static char no_hexa_spiral_filename[filenamenlaenge];
+
+static BOOL quiet=0;
+static BOOL IPR=0, is_ipr=1;
+static BOOL to_stdout=0;
+static BOOL hexspi=0, spistat=0;
+static BOOL spiralcheck=0;
+static int codenumber, listenlaenge, mod=0, rest=0;
+static int spiralnumbers[12*S+120+1];
 
 /* weitere globale Variablen (TH) fuer die Statistik der Symmetriegruppen: */
 
-BOOL symstat=0;    /* 1 -> Symmetriestatistik erstellen */
-int symm_anz[29]={0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
+static BOOL symstat=0;    /* 1 -> Symmetriestatistik erstellen */
+static int symm_anz[29]={0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
     /*  symm_anz[i] enthaelt die Anzahl der gefundenen Fullerene, die die
         Symmetrien der Symmetriegruppe mit der Nummer i besitzen */
-char symm[29] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
-int symm_len = 0;
+static char symm[29] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
+static int symm_len = 0;
     /* Speicher fuer Nummern von Symmetriegruppen, die beruecksichtigt werden sollen
        und die Anzahl der Eintraege im Array (0 => alle Gruppen beruecksichtigen) */            
-char symmstring[29*4];     /* Dateikennung, falls Symmetriegruppen gewaehlt */
+static char symmstring[29*4];     /* Dateikennung, falls Symmetriegruppen gewaehlt */
+static char symm_ordnung[29] = {0,1,2,2,2,3,4,4,4,4,6,6,6,6,8,8,10,12,12,12,12,20,20,24,24,24,24,60,120};
+    /* Ordnung der Symmetriegruppe mit der Nummer i */
+static BOOL symm_vorab=0;
+    /* Option "symmonly": maps, die keine der gewaehlten Symmetrien haben koennen,
+       werden in minitest() frueh verworfen und auch nicht gezaehlt */
+static int symm_klassen[29];      /* fuer symm[i]: Bitmaske der moeglichen Groessen (0..12)
+			      einer Klasse gleicher 5-Ecke, siehe symm_vorbereiten() */
+static int symm_min_ordnung;      /* kleinste Ordnung der gewaehlten Gruppen */
+static BOOL symm_klassentest;     /* 0, wenn fuer eine Gruppe alle Groessen moeglich sind */
+
+/* fuer die Benutzung als Bibliothek (siehe fullgen.h): */
+
+static FULLGEN_CALLBACK rueckruf=nil;
+static void *rueckrufdaten=nil;
+static BOOL abbrechen=0; /* die Funktion hat den Abbruch verlangt */
+
+/* Variablen fuer die Option "threads": Nach baue_patches() werden "threads"
+   Prozesse abgespalten, die sich die Patchlisten (copy on write) teilen.
+   Die Arbeitseinheiten (dieselben wie bei "mod") werden in allen drei
+   Faellen fortlaufend durchnumeriert und ueber einen gemeinsamen Zaehler
+   vergeben: Wer eine Einheit fertig hat, holt sich die naechste freie. */
+
+typedef struct { long long int graphenzahl[N+1];
+		 long long int non_iso_graphenzahl[N+1];
+		 int symm_anz[29];
+		 int spiralnumbers[12*S+120+1];
+		 int no_penta_spiral, no_hexa_spiral;
+		 long long int spiralversuche;
+#ifndef NOTIMES
+		 clock_t spiralzeit;
+#endif
+		 long long int minitest_verworfen[4];
+		 int laeufe[N+1]; /* bei codeart 3 */ } ZAEHLER;
+
+static int threads=1;
+static long long int einheit_nummer=(-1); /* Nummer der zuletzt betrachteten Einheit */
+static long long int meine_einheit;       /* die naechste Einheit dieses Prozesses */
+static long long int *naechste_einheit;   /* gemeinsam: naechste noch nicht vergebene Einheit */
+static ZAEHLER *thread_zaehler;           /* gemeinsam: die Zaehler jedes Prozesses */
+static int thread_kennung;                /* pid des Hauptprozesses, fuer die Dateinamen */
+static int arbeiter_nummer=0;             /* Nummer dieses Prozesses */
+static int *thread_laeufe=nil;            /* Laeufe jedes Prozesses fuer jede Knotenzahl */
+
+/* Variablen fuer die Optionen "stats" und "progress": */
+
+typedef struct { char name[40];
+		 double wand, cpu; /* Sekunden */ } PHASE;
+
+static char *statsdateiname=nil;
+static PHASE phasen[8];
+static int phasenzahl=0;
+static double phase_wand, phase_cpu; /* Zeiten beim Ende der letzten Phase */
+static long long int minitest_verworfen[4]={0,0,0,0}; /* in minitest() verworfen: 0 ohne
+						 rekonstruierbaren 5-Eck-Pfad,
+						 1 an einem kleineren Pfad,
+						 2 bei der Rekonstruktion,
+						 3 wegen "symmonly" */
+static int minitest_stufe; /* wie weit minitest() gekommen ist -- Index dafuer */
+static int fortschritt=0; /* Sekunden zwischen zwei Fortschrittszeilen, 0: keine */
+static double naechster_fortschritt, fortschritt_start;
+static long long int geprueft=0; /* Aufrufe von teste_und_schreibe() */
+static int aktueller_fall=0;
 
 /* Prototypen: */
 
-void codiereplanar(PLANMAP map);
+static void codiereplanar(PLANMAP map, int symmetrie);
 void common_history();
 void schreibemap();
 void schreibehistory();
 
 /****************SCHREIBE_SYMMETRIESTATISTIK********TH*****/
 
-void schreibe_symmetriestatistik()
+static void schreibe_symmetriestatistik()
 { int i, j=0;
   fprintf(stderr,"Symmetries:\n");
   for (i=1; i<=28; i++) {
@@ -304,100 +496,121 @@ void schreibe_symmetriestatistik()
 }        
 
 
-/**********************CHECKSIZE_MARK_RETURN**************************************/
-
-/* bestimmt die groesse der flaeche links von edge -- ist da keine gibt's Probleme 
-   ausserdem setzt er fuer alle kanten, so dass diese flaeche links davon ist, dummy
-   auf mark. In nextedge wird die im Gegen-Uhrzeigersinn letzte unmarkierte Kante
-   (heisst: die letzte kante mit markierung < mark) zurueckgegeben -- und nil, wenn
-   sie nicht existiert. */
-
-int checksize_mark_return(KANTE* edge, int mark, KANTE **nextedge)
+/**********************BAUE_SPIRALFLAECHEN**************************************/
 
+static void baue_spiralflaechen(PLANMAP map)
+/* bestimmt einmal je map die Flaechen: fuer jede Kante die Flaeche, die
+   checksize_mark_return_right() (frueher -- run=run->invers->prev) von ihr
+   aus durchlaeuft, und ihre Stelle darin, und fuer jede Flaeche die
+   Nachbarflaechen in dieser Reihenfolge. */
 {
-KANTE *run; 
-int zaehler=1;
-
-*nextedge=nil;
-if (edge->dummy < mark) { *nextedge=edge->invers; edge->dummy=edge->invers->dummy=mark; }
-
-for (run=edge->invers->next; run != edge; run=run->invers->next) 
-        { if (run->dummy < mark) { *nextedge=run->invers; run->dummy=run->invers->dummy=mark; }
-	  zaehler++; }
-return(zaehler);
+int i, j, k, e, fl;
+KANTE *run, *kanten[6];
+
+sp_basis=map[0];
+for (i=1; i<=map[0][0].name; i++) for (j=0; j<3; j++) sp_rechts[3*i+j]= -1;
+
+for (i=1, fl=0; i<=map[0][0].name; i++) for (j=0; j<3; j++)
+  if (sp_rechts[3*i+j]<0)
+    { run=map[i]+j; k=0;
+      do { e=run-sp_basis; sp_rechts[e]=fl; sp_position[e]=k; kanten[k++]=run;
+	   run=run->invers->prev; } while (run != map[i]+j);
+      sp_flaeche[fl].groesse=k;
+      for (k--; k>=0; k--) sp_flaeche[fl].nachbar[k]=kanten[k]-sp_basis; /* vorlaeufig */
+      fl++; }
+sp_flaechenzahl=fl;
+
+for (fl=0; fl<sp_flaechenzahl; fl++)
+  for (k=0, j=sp_flaeche[fl].groesse; k<j; k++)
+    { e=(sp_basis+sp_flaeche[fl].nachbar[k])->invers-sp_basis;
+      sp_flaeche[fl].nachbar[k]=sp_flaeche[fl].nachbar[k+j]=sp_rechts[e];
+      sp_flaeche[fl].eintritt[k]=sp_flaeche[fl].eintritt[k+j]=sp_position[e]; }
+sp_aktuell=1;
 }
 
+/************************NAECHSTE_FLAECHE**********************************/
 
-
-/**********************CHECKSIZE_MARK_RETURN_RIGHT**************************************/
-
-/* bestimmt die groesse der flaeche rechts von edge -- sonst wie oben */
-
-int checksize_mark_return_right(KANTE* edge, int mark, KANTE **nextedge)
-
+static int naechste_flaeche(int fl, int *p, BOOL gegen)
+/* Die Flaeche fl wurde an der Stelle *p betreten. Gibt den letzten noch
+   nicht eingefuegten Nachbarn zurueck, wenn man fl von *p aus im
+   (gegen==0) oder gegen den Uhrzeigersinn ablaeuft, und setzt *p auf die
+   Stelle, an der er betreten wird. -1, wenn es keinen gibt. */
 {
-KANTE *run; 
-int zaehler=1;
-
-*nextedge=nil;
-if (edge->dummy < mark) { *nextedge=edge->invers; edge->dummy=edge->invers->dummy=mark; }
-
-for (run=edge->invers->prev; run != edge; run=run->invers->prev) 
-      {if (run->dummy < mark) { *nextedge=run->invers; run->dummy=run->invers->dummy=mark; }
-       zaehler++;}
-return(zaehler);
+SPIRALFLAECHE *f;
+int q, ende;
+
+f=sp_flaeche+fl;
+if (gegen) { q= *p+1; ende= *p+f->groesse; }
+else { q= *p+f->groesse-1; ende= *p; }
+for ( ; ; )
+  { if (sp_platziert[f->nachbar[q]]!=sp_epoche) { *p=f->eintritt[q]; return(f->nachbar[q]); }
+    if (q==ende) return(-1);
+    if (gegen) q++; else q--; }
 }
 
+/************************SPIRALE**********************************/
 
-
-
-/************************GET_SPIRAL_CODE**********************************/
-
-BOOL get_spiralcode ( KANTE *edge, int minmark, FLAECHENTYP cmpcode[12],
-		 int sixgons)
+static BOOL spirale ( KANTE *edge, BOOL gegen, FLAECHENTYP cmpcode[12], int sixgons)
 
 /* entwickelt den Spiralcode, bei dem die erste Flaeche links von edge
    liegt, die zweite rechts davon und die Entwicklung im Uhrzeigersinn
-   geht. Entwickelt wird solange der Code besser ist als cmpcode. Das
-   Resultat wird in cmpcode geschrieben, wenn es besser ist. Wenn ein 
-   Code gefunden wird, der besser ist, als cmpcode, wird 1 zurueckgegeben, 
-   sonst 0.  Die aufrufende Funktion muss sicherstellen, dass alle Kanten
-   kante->dummy <= minmark erfuellen.
-*/
+   (gegen==0) oder im GEGEN-Uhrzeigersinn geht. Entwickelt wird solange
+   der Code besser ist als cmpcode. Das Resultat wird in cmpcode
+   geschrieben, wenn es besser ist. Wenn ein Code gefunden wird, der besser
+   ist, als cmpcode, wird 1 zurueckgegeben, sonst 0.
+
+   Frueher wurden die Kanten der schon eingefuegten Flaechen markiert und
+   jede Flaeche abgelaufen; die naechste Flaeche lag hinter der letzten
+   unmarkierten Kante. Das ist der letzte noch nicht eingefuegte Nachbar in
+   der Laufrichtung, also der erste, wenn man von hinten sucht. Eingefuegte
+   Flaechen haben sp_platziert==sp_epoche, so muss nichts geloescht werden.
+   Die Flaechen muessen mit baue_spiralflaechen() bestimmt sein. */
 
 {
-int mark, i;
-KANTE *nextedge;
+int i, fl, p;
 BOOL kleiner=0;
 FLAECHENTYP code[12], zaehler;
 int fuenfecke=0, sechsecke=0; /* zaehler fuer die wirklich eingefuegten Flaechen */
 int stelle;
+KANTE *w;
 
-mark=minmark+1;  
+spiralversuche++;
+if (++sp_epoche==0) /* einmal nach 2^32 Versuchen */
+  { for (i=0; i<S+13; i++) sp_platziert[i]=0; sp_epoche=1; }
 
-if (checksize_mark_return(edge, mark, &nextedge)==5)
-                      {  code[0]=1; stelle=0; fuenfecke=1; } 
+fl=sp_rechts[edge->invers-sp_basis]; sp_platziert[fl]=sp_epoche;
+if (sp_flaeche[fl].groesse==5) { code[0]=1; stelle=0; fuenfecke=1; } 
 else { stelle= -1; sechsecke=1; }
-if (checksize_mark_return_right( edge, mark, &nextedge)==5)
-    { stelle++; code[stelle]=2; fuenfecke++; } else sechsecke++;
+fl=sp_rechts[edge-sp_basis]; p=sp_position[edge-sp_basis]; sp_platziert[fl]=sp_epoche;
+if (sp_flaeche[fl].groesse==5) { stelle++; code[stelle]=2; fuenfecke++; } else sechsecke++;
 
 for (i=0; (i<=stelle) && (!kleiner); i++)
   { if (code[i]>cmpcode[i]) return(0);
     if (code[i]<cmpcode[i]) kleiner=1; }
 
+if (gegen) /* die dritte Flaeche liegt links von edge->invers->prev */
+  { w=edge->invers->prev->invers; fl=sp_rechts[w-sp_basis]; p=sp_position[w-sp_basis]; }
+else fl=naechste_flaeche(fl,&p,0);
+
 zaehler=3;
 
-while (nextedge != nil)
-  { if (checksize_mark_return_right(nextedge, mark, &nextedge)==5)
-                       { fuenfecke++;
-			 stelle++; code[stelle]=zaehler; 
-		         if (!kleiner)
-			    { if (zaehler>cmpcode[stelle]) { return(0); }
-			      if (zaehler<cmpcode[stelle]) kleiner=1;
-			    }
-		       }
-    else sechsecke++;
+while (fl>=0)
+  { sp_platziert[fl]=sp_epoche;
+    if (sp_flaeche[fl].groesse==5)
+      { fuenfecke++;
+	stelle++; code[stelle]=zaehler; 
+	if (!kleiner)
+	  { if (zaehler>cmpcode[stelle]) { return(0); }
+	    if (zaehler<cmpcode[stelle]) kleiner=1;
+	  }
+      }
+    else
+      { sechsecke++;
+	/* das naechste 5-Eck kann nicht mehr die Nummer cmpcode[stelle+1] bekommen */
+	if (!kleiner && (stelle<11) && (zaehler>=cmpcode[stelle+1])) return(0);
+      }
     zaehler++;
+    fl=naechste_flaeche(fl,&p,gegen);
   }
 
 if ((fuenfecke<12) || (sechsecke < sixgons)) return(0);
@@ -407,89 +620,114 @@ return(1);
 }
 
 
+/************************GET_SPIRAL_CODE**********************************/
+
+static BOOL get_spiralcode ( KANTE *edge, FLAECHENTYP cmpcode[12], int sixgons)
+
+/* entwickelt den Spiralcode, bei dem die erste Flaeche links von edge
+   liegt, die zweite rechts davon und die Entwicklung im Uhrzeigersinn
+   geht -- siehe spirale() */
+
+{
+return(spirale(edge,0,cmpcode,sixgons));
+}
+
+
 /************************GET_SPIRAL_CODE_INV**********************************/
 
-BOOL get_spiralcode_inv ( KANTE *edge, int minmark, FLAECHENTYP cmpcode[12],
-		 int sixgons)
+static BOOL get_spiralcode_inv ( KANTE *edge, FLAECHENTYP cmpcode[12], int sixgons)
 
 /* entwickelt den Spiralcode, bei dem die erste Flaeche links von edge
    liegt, die zweite rechts davon und die Entwicklung im GEGEN-Uhrzeigersinn
    geht. Sonst wie oben */
 
 {
-int mark, i;
-KANTE *nextedge;
-BOOL kleiner=0;
-FLAECHENTYP code[12], zaehler;
-int fuenfecke=0, sechsecke=0; /* zaehler fuer die wirklich eingefuegten Flaechen */
-int stelle;
+return(spirale(edge,1,cmpcode,sixgons));
+}
 
-mark=minmark+1;  
 
-if (checksize_mark_return( edge, mark, &nextedge)==5)
-                      { code[0]=1; stelle=0; fuenfecke=1; } 
-else { stelle= -1; sechsecke=1; }
-if (checksize_mark_return_right( edge, mark, &nextedge)==5)
-    { stelle++; code[stelle]=2; fuenfecke++; } else sechsecke++;
+/************************PUFFERE_AUSGABE*****************************/
 
-nextedge=edge->invers->prev;
+static void puffere_ausgabe(FILE *f, int nummer)
+/* gibt f einen eigenen Puffer von ausgabepuffergroesse Bytes, so dass
+   die Codes in grossen Bloecken geschrieben werden. Die Nummern sind die
+   von hilfsdateiname(); wird f geschlossen und fuer dieselbe Nummer eine
+   neue Datei geoeffnet, wird der Puffer wieder benutzt. */
+{
+if (ausgabepuffer[nummer]==nil)
+  { ausgabepuffer[nummer]=malloc(ausgabepuffergroesse);
+    if (ausgabepuffer[nummer]==nil) return; /* dann eben der von stdio */ }
+setvbuf(f,ausgabepuffer[nummer],_IOFBF,ausgabepuffergroesse);
+}
 
-for (i=0; (i<=stelle) && (!kleiner); i++)
-  { if (code[i]>cmpcode[i]) return(0);
-    if (code[i]<cmpcode[i]) kleiner=1; }
+/************************OEFFNE_AUSGABE*****************************/
 
-zaehler=3;
+static FILE *oeffne_ausgabe(char *name, int nummer)
+/* oeffnet die Datei fuer die Codes mit nummer Knoten. Mit "container"
+   ist das eine Hilfsdatei, die sofort wieder geloescht wird und am Ende
+   von schreibe_container() gelesen wird. Gibt nil zurueck, wenn das
+   nicht geht. */
+{
+FILE *f;
+char hilfsname[filenamenlaenge+12];
+
+if (containername!=nil)
+  { sprintf(hilfsname,"%s_tmp_%d",containername,nummer);
+    f=fopen(hilfsname,"w+b");
+    if (f!=nil) remove(hilfsname); /* bleibt bis zum fclose benutzbar */ }
+else f=fopen(name,"wb");
+if (f!=nil) puffere_ausgabe(f,nummer);
+return(f);
+}
 
-while (nextedge != nil)
-  { 
-    if (checksize_mark_return( nextedge, mark, &nextedge)==5)
-                       { fuenfecke++;
-			 stelle++; code[stelle]=zaehler; 
-		         if (!kleiner)
-			    { if (zaehler>cmpcode[stelle]) { return(0); }
-			      if (zaehler<cmpcode[stelle]) kleiner=1;
-			    }
-		       }
-    else sechsecke++;
-    zaehler++;
-  }
+/************************SCHREIBE_ZAHL*****************************/
 
-if ((fuenfecke<12) || (sechsecke < sixgons)) return(0);
+static char *schreibe_zahl(char *p, int zahl, int breite)
+/* schreibt zahl>=0 wie printf("%*d",breite,zahl) nach p und gibt das
+   Ende zurueck */
+{
+char ziffern[12];
+int n=0;
 
-for (i=0; i<12; i++) cmpcode[i]=code[i];
-return(1);
+do { ziffern[n++]='0'+(zahl%10); zahl/=10; } while (zahl);
+for ( ; breite>n; breite--) *(p++)=' ';
+while (n) *(p++)=ziffern[--n];
+return(p);
 }
 
-
 /************************VEGACODE*****************************/
 
-void vegacode( FILE *fil, PLANMAP map )
-
+static void vegacode( FILE *fil, PLANMAP map )
+/* schreibt map als writegraph3d. Der Text wird ohne fprintf() in puffer
+   zusammengesetzt und mit einem fwrite() geschrieben. */
 {
 static int erster_aufruf=1;
-int i;
+static char puffer[(N+1)*40]; /* hoechstens 5+10+3*6 Zeichen je Knoten */
+int i, breite;
+char *p;
 
 if (erster_aufruf)
   { fprintf(fil,">>writegraph3d planar <<\n");
     erster_aufruf=0; }
 
-if (map[0][0].name >= 100)
-  {
-    for (i=1; i<=map[0][0].name; i++)
-      fprintf(fil,"%3d  0 0 0   %3d %3d %3d\n",i,map[i][0].name,map[i][1].name,map[i][2].name);
-  }
-else 
-  {
-    for (i=1; i<=map[0][0].name; i++)
-      fprintf(fil,"%2d  0 0 0   %2d %2d %2d\n",i,map[i][0].name,map[i][1].name,map[i][2].name);
+if (map[0][0].name >= 100) breite=3; else breite=2;
+
+p=puffer;
+for (i=1; i<=map[0][0].name; i++)
+  { p=schreibe_zahl(p,i,breite);
+    memcpy(p,"  0 0 0   ",10); p+=10;
+    p=schreibe_zahl(p,map[i][0].name,breite); *(p++)=' ';
+    p=schreibe_zahl(p,map[i][1].name,breite); *(p++)=' ';
+    p=schreibe_zahl(p,map[i][2].name,breite); *(p++)='\n';
   }
-fprintf(fil,"0\n");
+*(p++)='0'; *(p++)='\n';
 
+fwrite(puffer,1,p-puffer,fil);
 }
 
 /************************BELEGEDUMMIES************************/
 
-void belegedummies(KANTE *edge, int nummer)
+static void belegedummies(KANTE *edge, int nummer)
 /* belegt edge->dummy, edge->invers->pre->dummy, ... mit Nummer
    -- einmal rund um die Flaeche */
 
@@ -506,15 +744,17 @@ while (edge != merke) { edge->dummy=nummer;
 
 /************************DUALCODE*****************************/
 
-int dualcode( PLANMAP map )
+static int dualcode( PLANMAP map )
 
 {
 /* berechnet das Dual und schreibt es als planarcode auf stdout */
 
 int flaechenzahl, knotenzahl, codelaenge=1,i,j, nextnumber=2;
-FLAECHENTYP code[(S+13)*7]; /* In main wird schon abgefangen, wenn das nicht in
-			       unsigned char passt */
+CODETYP code[2*(S+13)*7+3]; /* bei mehr als UCHAR_MAX Flaechen zwei Bytes je
+				Eintrag -- wie in longcode() */
 KANTE *startedge[S+13];
+int nummer[2*(S+13)*7]; /* die Eintraege, bevor sie in code geschrieben werden */
+int anzahl=0;
 KANTE *run, *merke;
 static int write_header=1;
 
@@ -525,7 +765,7 @@ if (write_header)
     
 
 knotenzahl=map[0][0].name;
-code[0]=flaechenzahl= 2 + (map[0][0].name / 2);
+flaechenzahl= 2 + (map[0][0].name / 2);
 
 
 for (i=1; i<= knotenzahl; i++) for (j=0; j<3; j++) map[i][j].dummy=0;
@@ -536,35 +776,43 @@ startedge[1]=map[1];
 
 for (i=1; i<=flaechenzahl; i++)
   { merke=startedge[i]; 
-    if (merke->invers->dummy) { code[codelaenge]=merke->invers->dummy;
-				codelaenge++; }
-    else { code[codelaenge]= nextnumber; codelaenge++;
+    if (merke->invers->dummy) { nummer[anzahl]=merke->invers->dummy;
+				anzahl++; }
+    else { nummer[anzahl]= nextnumber; anzahl++;
 	   startedge[nextnumber]=merke->invers;
 	   belegedummies(merke->invers,nextnumber);
 	   nextnumber++; }
     for (run=merke->invers->prev; run != merke; run=run->invers->prev)
-      { if (run->invers->dummy) { code[codelaenge]=run->invers->dummy;
-				    codelaenge++; }
-        else { code[codelaenge]= nextnumber; codelaenge++;
+      { if (run->invers->dummy) { nummer[anzahl]=run->invers->dummy;
+				    anzahl++; }
+        else { nummer[anzahl]= nextnumber; anzahl++;
 	     startedge[nextnumber]=run->invers;
 	     belegedummies(run->invers,nextnumber);
 	     nextnumber++; }
       }
-    code[codelaenge]=0; codelaenge++;
+    nummer[anzahl]=0; anzahl++;
   }
 
-fwrite(code,sizeof(FLAECHENTYP),codelaenge,stdout);
+if (flaechenzahl <= UCHAR_MAX)
+  { code[0]=flaechenzahl; codelaenge=1;
+    for (i=0; i<anzahl; i++) code[codelaenge++]=nummer[i]; }
+else
+  { code[0]=0; code[1]=flaechenzahl&0xFF; code[2]=(flaechenzahl>>8)&0xFF; codelaenge=3;
+    for (i=0; i<anzahl; i++)
+      { code[codelaenge++]=nummer[i]&0xFF; code[codelaenge++]=(nummer[i]>>8)&0xFF; } }
+
+fwrite(code,sizeof(CODETYP),codelaenge,stdout);
 
 return(codelaenge);
 }
  
 /*************************SPARSE6CODE*****************************/
 
-int
-sparse6code( PLANMAP map, FLAECHENTYP *code)
+static int
+sparse6code( PLANMAP map, CODETYP *code)
 /* Make sparse6 code, including final '\n'. */
 {
-    FLAECHENTYP *p;
+    CODETYP *p;
     int nb,i,j,lastj,x,k,r,rr,topbit;
     int nv;
     KANTE *merke, *lauf;
@@ -666,13 +914,13 @@ sparse6code( PLANMAP map, FLAECHENTYP *code)
 
 #define TWOBYTES(x) {codeF[zaehler]=(x)&0xFF; codeF[zaehler+1]=((x)>>8)&0xFF;  zaehler += 2;}
 
-int longcode( PLANMAP map, FLAECHENTYP *codeF )
+static int longcode( PLANMAP map, CODETYP *codeF )
 {
 /* Codiert die Einbettung in codeF und gibt die laenge des codes zurueck */
 int i,zaehler;
 KANTE *merke, *lauf;
 
-if (map[0][0].name <= FL_MAX)
+if (map[0][0].name <= UCHAR_MAX)
 {
 zaehler=1;
 codeF[0]=map[0][0].name;
@@ -682,7 +930,7 @@ for(i=1;i<=map[0][0].name;i++)
 	           { codeF[zaehler]=lauf->name; zaehler++; }
       codeF[zaehler]=0; zaehler++; }
 }
-else /* zu viele knoten fuer FLAECHENTYP */
+else /* zu viele knoten fuer ein Byte */
 {
 zaehler=1;
 codeF[0]=0;
@@ -697,53 +945,83 @@ return(zaehler);
 
 
 
+/*************************SCHREIBE_OHNE_SPIRALE*****************************/
+
+static void schreibe_ohne_spirale(PLANMAP map, int welche)
+/* schreibt map im planar code in die Datei ohne_spirale[welche]:
+   0 No_spiral, 1 No_pentagon_spiral, 2 No_hexagon_spiral. Die Datei wird
+   beim ersten Graphen zum Anhaengen geoeffnet (mit Header) und bleibt bis
+   schliesse_ohne_spirale() offen. */
+{
+char *name;
+int zaehler;
+CODETYP codeF[CODELAENGE];
+
+if (ohne_spirale[welche]==nil)
+  { if (welche==0) name=no_spiral_filename;
+    else if (welche==1) name=no_penta_spiral_filename;
+    else name=no_hexa_spiral_filename;
+    ohne_spirale[welche]=fopen(name,"ab");
+    if (ohne_spirale[welche]==nil) { fprintf(stderr,"Can't open %s\n",name); exit(1); }
+    puffere_ausgabe(ohne_spirale[welche],N+1+welche);
+    fprintf(ohne_spirale[welche],">>planar_code %ce<<", my_endianness);
+  }
+
+zaehler=longcode(map,codeF);
+fwrite(codeF,sizeof(CODETYP),zaehler,ohne_spirale[welche]);
+}
+
+/*************************SCHLIESSE_OHNE_SPIRALE*****************************/
+
+static void schliesse_ohne_spirale(void)
+{
+int i;
+
+for (i=0; i<3; i++)
+  if (ohne_spirale[i]!=nil)
+    { if (fclose(ohne_spirale[i])) { fprintf(stderr,"Can not write the files without spirals. \n"); exit(133); }
+      ohne_spirale[i]=nil; }
+}
+
 /*************************SPIRALCODE*******************************/
 
-BOOL spiralcode(PLANMAP map, FLAECHENTYP code[12])
+static BOOL spiralcode(PLANMAP map, FLAECHENTYP code[12])
 
 /* berechnet irgendeinen Spiralcode von map und schreibt ihn in code.
    Gibt 1 zurueck, wenn der gefunden wurde und 0 sonst. versucht zuerst
    einen Code zu finden, der an einem 5-Eck startet. */
 
-{ int zaehler, i,j, mark, sixgons;
+{ int i,j, sixgons;
   BOOL gefunden=0, hexgefunden=0;
-  FLAECHENTYP codeF[2*(81+8*S)];
-  FILE *fil2;
   FLAECHENTYP dummycode[12];
   FLAECHENTYP *dummy;
-  static int write_nopentaheader=1, write_nohexaheader=1;
+#ifndef NOTIMES
+  clock_t start;
+#endif
 
 /*schreibemap(map);*/
 
+#ifndef NOTIMES
+start=clock();
+#endif
 sixgons= (map[0][0].name - 20)/2;
+if (!sp_aktuell) baue_spiralflaechen(map);
 
 for (i=1; i<=map[0][0].name; i++)
-  for (j=0; j<3; j++) { map[i][j].dummy=map[i][j].mininame=0; }
+  for (j=0; j<3; j++) map[i][j].mininame=0;
 for (i=0; i<12; i++) code[i]=FL_MAX;
 
 
 for (i=0; (i<60) && !gefunden; i++) 
-  { gefunden= get_spiralcode ( F_eck_kanten[i], i, code, sixgons);
+  { gefunden= get_spiralcode ( F_eck_kanten[i], code, sixgons);
     (F_eck_kanten[i])->mininame=1; }
 
-mark=61;
-
 for (i=0; (i<60) && !gefunden; i++) 
-  { gefunden= get_spiralcode_inv ( F_eck_kanten[i], mark, code, sixgons);
-    mark++; }
+  gefunden= get_spiralcode_inv ( F_eck_kanten[i], code, sixgons);
 
 
 if (!gefunden) { no_penta_spiral++;
-		 zaehler=longcode(map,codeF);
-		fil2=fopen(no_penta_spiral_filename,"ab");
-		if (fil2==NULL) { fprintf(stderr,"Can't open %s\n",no_penta_spiral_filename);
-		                  exit(1); }
-		if (write_nopentaheader)
-		  { write_nopentaheader=0;
-		  fprintf(fil2,">>planar_code %ce<<", my_endianness);
-		  }
-		fwrite(codeF,sizeof(FLAECHENTYP),zaehler,fil2);
-		fclose(fil2);
+		 schreibe_ohne_spirale(map,1);
 	       }
 
 
@@ -754,80 +1032,65 @@ if (!gefunden) dummy=code; else
 for (i=1; (i<=map[0][0].name) && !hexgefunden; i++) 
   for (j=0; j<3 && !hexgefunden; j++)
     if (!map[i][j].mininame) 
-      { hexgefunden= get_spiralcode ( map[i]+j, mark, dummy, sixgons); mark++;
+      { hexgefunden= get_spiralcode ( map[i]+j, dummy, sixgons);
         if (!hexgefunden) 
-	  { hexgefunden= get_spiralcode_inv ( map[i]+j, mark, dummy, sixgons); mark++; }
+	  hexgefunden= get_spiralcode_inv ( map[i]+j, dummy, sixgons);
       }
 }
 
 if (hexspi && !hexgefunden) { no_hexa_spiral++;
-		 zaehler=longcode(map,codeF);
-		fil2=fopen(no_hexa_spiral_filename,"ab");
-		if (fil2==NULL) { fprintf(stderr,"Can't open %s\n",no_hexa_spiral_filename);
-		                  exit(1); }
-		if (write_nohexaheader)
-		  { write_nohexaheader=0;
-		  fprintf(fil2,">>planar_code %ce<<", my_endianness);
-		  }
-		fwrite(codeF,sizeof(FLAECHENTYP),zaehler,fil2);
-		fclose(fil2);
+		 schreibe_ohne_spirale(map,2);
 	       }
 
 
-
+#ifndef NOTIMES
+spiralzeit+=clock()-start;
+#endif
 return(gefunden || hexgefunden);
 }
 
 
 /*************************MINSPIRALCODE*******************************/
 
-BOOL minspiralcode(PLANMAP map, FLAECHENTYP code[12])
+static BOOL minspiralcode(PLANMAP map, FLAECHENTYP code[12])
 
 /* berechnet den minimalen Spiralcode von map und schreibt ihn in code.
    Gibt 1 zurueck, wenn der gefunden wurde und 0 sonst. versucht zuerst
    einen Code zu finden, der an einem 5-Eck startet. */
 
-{ int i,j, zaehler, mark, sixgons;
+{ int i,j, sixgons;
   BOOL gefunden=0, hexgefunden=0;
-  FLAECHENTYP codeF[2*(81+8*S)];
-  FILE *fil2;
   FLAECHENTYP dummycode[12];
   FLAECHENTYP *dummy;
-  static int write_nopentaheader=1, write_nohexaheader=1;
+#ifndef NOTIMES
+  clock_t start;
+#endif
 
 
 /*schreibemap(map);*/
 
+#ifndef NOTIMES
+start=clock();
+#endif
 sixgons= (map[0][0].name - 20)/2;
+if (!sp_aktuell) baue_spiralflaechen(map);
 
 for (i=1; i<=map[0][0].name; i++)
-  for (j=0; j<3; j++) { map[i][j].dummy=map[i][j].mininame=0; }
+  for (j=0; j<3; j++) map[i][j].mininame=0;
 for (i=0; i<12; i++) code[i]=FL_MAX;
 
 
 
 for (i=0; (i<60); i++) 
-  { if (get_spiralcode ( F_eck_kanten[i], i, code, sixgons)) gefunden=1;
+  { if (get_spiralcode ( F_eck_kanten[i], code, sixgons)) gefunden=1;
     (F_eck_kanten[i])->mininame=1; }
 
-mark=61;
-
 for (i=0; (i<60); i++) 
-  { if (get_spiralcode_inv ( F_eck_kanten[i], mark, code, sixgons)) gefunden=1;
-    mark++; }
+  if (get_spiralcode_inv ( F_eck_kanten[i], code, sixgons)) gefunden=1;
 
 
 if (!gefunden) { no_penta_spiral++;
-		 zaehler=longcode(map,codeF);
-		fil2=fopen(no_penta_spiral_filename,"ab");
-		if (fil2==NULL) { fprintf(stderr,"Can't open %s\n",no_penta_spiral_filename);
-		                  exit(1); }
-		if (write_nopentaheader)
-		  { write_nopentaheader=0;
-		  fprintf(fil2,">>planar_code %ce<<", my_endianness);
-		  }
-		fwrite(codeF,sizeof(FLAECHENTYP),zaehler,fil2);
-		fclose(fil2);
+		 schreibe_ohne_spirale(map,1);
 	       }
 
 
@@ -838,25 +1101,18 @@ if (!gefunden) dummy=code; else
 for (i=1; (i<=map[0][0].name); i++) 
   for (j=0; j<3 ; j++)
     if (!map[i][j].mininame) 
-      { if (get_spiralcode ( map[i]+j, mark, dummy, sixgons)) hexgefunden=1; mark++; 
-	if (get_spiralcode_inv ( map[i]+j, mark, dummy, sixgons)) hexgefunden=1; mark++; 
+      { if (get_spiralcode ( map[i]+j, dummy, sixgons)) hexgefunden=1;
+	if (get_spiralcode_inv ( map[i]+j, dummy, sixgons)) hexgefunden=1;
       }
 }
 
 if (hexspi && !hexgefunden) { no_hexa_spiral++;
-		 zaehler=longcode(map,codeF);
-		fil2=fopen(no_hexa_spiral_filename,"ab");
-		if (fil2==NULL) { fprintf(stderr,"Can't open %s\n",no_hexa_spiral_filename);
-		                  exit(1); }
-		if (write_nohexaheader)
-		  { write_nohexaheader=0;
-		  fprintf(fil2,">>planar_code %ce<<", my_endianness);
-		  }
-		fwrite(codeF,sizeof(FLAECHENTYP),zaehler,fil2);
-		fclose(fil2);
+		 schreibe_ohne_spirale(map,2);
 	       }
 
-
+#ifndef NOTIMES
+spiralzeit+=clock()-start;
+#endif
 return(gefunden || hexgefunden);
 }
 
@@ -864,43 +1120,48 @@ return(gefunden || hexgefunden);
 
 /*************************SPIRALSTATISTIC*******************************/
 
-void spiralstatistic(PLANMAP map)
+static void spiralstatistic(PLANMAP map)
 
 /* berechnet die Statistik, wieviele Spiralen es gibt */
 
-{ int zaehler=0, i,j, mark, sixgons;
+{ int zaehler=0, i,j, sixgons;
   FLAECHENTYP code[12];
+#ifndef NOTIMES
+  clock_t start;
+#endif
 
 
 /*schreibemap(map);*/
 
+#ifndef NOTIMES
+start=clock();
+#endif
 sixgons= (map[0][0].name - 20)/2;
+if (!sp_aktuell) baue_spiralflaechen(map);
 
-for (i=1; i<=map[0][0].name; i++)
-  for (j=0; j<3; j++) { map[i][j].dummy=map[i][j].mininame=0; }
 for (i=0; i<12; i++) code[i]=FL_MAX;
 
-mark=1;
-
 for (i=1; (i<=map[0][0].name); i++) 
   for (j=0; j<3; j++)
       { code[0]=FL_MAX; 
-	if (get_spiralcode ( map[i]+j, mark, code, sixgons)) zaehler++; 
+	if (get_spiralcode ( map[i]+j, code, sixgons)) zaehler++; 
 	/*else fprintf(stderr,"no %d %d \n",i,map[i][j].name);*/
-	mark++;
 	code[0]=FL_MAX;
-	if (get_spiralcode_inv ( map[i]+j, mark, code, sixgons)) zaehler++; 
+	if (get_spiralcode_inv ( map[i]+j, code, sixgons)) zaehler++; 
 	/*else fprintf(stderr,"no inv %d %d \n",i,map[i][j].name); */
-        mark++;}
+      }
 
 spiralnumbers[zaehler]++;
+#ifndef NOTIMES
+spiralzeit+=clock()-start;
+#endif
 
 }
 
 
 /*********************CODECMP_KN*****************************************/
 
-int codecmp_kn(KNOTENTYP *p1, KNOTENTYP *p2, int max)
+static int codecmp_kn(KNOTENTYP *p1, KNOTENTYP *p2, int max)
 {
 max--;
 while ((*p1==*p2) && max) { p1++; p2++; max--; }
@@ -909,7 +1170,7 @@ return( (int)(*p1)-(int)(*p2) );
 
 /*********************CODECMP*****************************************/
 
-int codecmp(FLAECHENTYP *p1, FLAECHENTYP *p2, int max)
+static int codecmp(FLAECHENTYP *p1, FLAECHENTYP *p2, int max)
 {
 max--;
 while ((*p1==*p2) && max) { p1++; p2++; max--; }
@@ -917,79 +1178,232 @@ return( (int)(*p1)-(int)(*p2) );
 }
 
 
+/**************************LAUFDATEINAME********************************/
+
+static void laufdateiname(char *name, LAUF lauf, int knotenzahl)
+{
+sprintf(name,"Full_gen_tmp_%d_l%d_%d_%d",thread_kennung,lauf.arbeiter,knotenzahl,lauf.nummer);
+}
+
+/**************************SORTIERE_CODES********************************/
+
+static void sortiere_codes(CODETYP *codes, int anzahl)
+/* sortiert anzahl Codes der Laenge 12 lexikographisch -- Radixsort von der
+   letzten Stelle an. Stellen, an denen alle Codes gleich sind (bei den
+   minimalen Spiralen sehr haeufig), werden uebersprungen. */
+{
+int stelle, i, zaehler[256];
+CODETYP *quelle, *ziel, *merke;
+
+quelle=codes; ziel=sortierhilfe;
+for (stelle=11; stelle>=0; stelle--)
+  { for (i=0; i<256; i++) zaehler[i]=0;
+    for (i=0; i<anzahl; i++) zaehler[quelle[12*i+stelle]]++;
+    if (zaehler[quelle[stelle]]==anzahl) continue;
+    for (i=1; i<256; i++) zaehler[i]+=zaehler[i-1];
+    for (i=anzahl-1; i>=0; i--)
+      memcpy(ziel+12*(--zaehler[quelle[12*i+stelle]]),quelle+12*i,12);
+    merke=quelle; quelle=ziel; ziel=merke; }
+
+if (quelle!=codes) memcpy(codes,quelle,12*(size_t)anzahl);
+
+for (i=1; i<anzahl; i++)
+  if (memcmp(codes+12*(i-1),codes+12*i,12)==0)
+    { fprintf(stderr,"Dangerous error -- Two equal codes ! \n"); exit(2); }
+}
+
+/**************************SCHREIBE_LAUF********************************/
+
+static void schreibe_lauf(int knotenzahl)
+/* sortiert den Puffer und schreibt ihn als naechsten Lauf dieses Prozesses */
+{
+SORTIERLISTE *liste;
+LAUF lauf;
+char name[filenamenlaenge];
+FILE *f;
+
+liste=codeliste+knotenzahl;
+sortiere_codes(liste->codes,liste->anzahl);
+lauf.arbeiter=arbeiter_nummer; lauf.nummer=liste->laeufe;
+laufdateiname(name,lauf,knotenzahl);
+f=fopen(name,"wb");
+if (f==nil) { fprintf(stderr,"Can not open file %s. \n",name); exit(130); }
+if ((fwrite(liste->codes,12,liste->anzahl,f)!=(size_t)liste->anzahl) || fclose(f))
+  { fprintf(stderr,"Can not write file %s. \n",name); exit(130); }
+liste->laeufe++;
+liste->anzahl=0;
+}
+
 /**************************IN_LISTE********************************/
 
-void in_liste(FLAECHENTYP *code, LISTENTRY *el)
-/* schreibt code in die liste */
-{ int compare;
-  int n;
-
-
-if (el->code[0]==0)
-    { 
-      for (n=0; n<12; n++) (el->code)[n]= code[n];
-      el->smaller=(LISTENTRY *)malloc(sizeof(LISTENTRY));
-         (el->smaller->code)[0]=0;
-      el->larger=(LISTENTRY *)malloc(sizeof(LISTENTRY));
-         (el->larger->code)[0]=0;
-      if ((el->smaller==nil) || (el->larger==nil)) 
-	{ fprintf(stderr,"Cannot allocate memory in \"in_liste\" \n");
-						     exit(1); }
-    }
+static void in_liste(FLAECHENTYP *code, int knotenzahl)
+/* schreibt code in den Puffer fuer knotenzahl -- ein Byte je Eintrag,
+   das ist in main sichergestellt */
+{
+SORTIERLISTE *liste;
+CODETYP *ziel;
+int i;
 
-else { 
-       compare=codecmp(code,el->code,12);
-        if (compare<0) in_liste(code,el->smaller);
-                else if (compare>0) in_liste(code,el->larger);
-                   else { fprintf(stderr,"Dangerous error -- Two equal codes ! \n"); exit(2); }
-     }
+liste=codeliste+knotenzahl;
+if (liste->codes==nil)
+  { liste->codes=(CODETYP *)malloc(12*(size_t)listenlaenge);
+    if (sortierhilfe==nil) sortierhilfe=(CODETYP *)malloc(12*(size_t)listenlaenge);
+    if ((liste->codes==nil) || (sortierhilfe==nil))
+      { fprintf(stderr,"Cannot allocate memory in \"in_liste\" \n"); exit(1); }
+  }
+ziel=liste->codes+12*liste->anzahl;
+for (i=0; i<12; i++) ziel[i]=code[i];
+liste->anzahl++;
+if (liste->anzahl==listenlaenge) schreibe_lauf(knotenzahl);
 }
 
+/*********************SCHREIBE_KOMPRIMIERT***********************************/
 
-/*********************AUSGABE***********************************/
+static void schreibe_komprimiert(CODETYP *code, CODETYP *lastcode, FILE *f)
+/* schreibt, wie viele Eintraege mit lastcode uebereinstimmen, und den Rest */
+{
+CODETYP i;
 
-void ausgabe(LISTENTRY *liste,int knotenzahl,FLAECHENTYP **lastcode)
+for (i=0; (i<12) && (code[i]==lastcode[i]); i++);
+if (i==12) { fprintf(stderr,"Dangerous error -- Two equal codes ! \n"); exit(2); }
+fwrite(&i,sizeof(CODETYP),1,f);
+fwrite(code+i,sizeof(CODETYP),12-i,f);
+memcpy(lastcode,code,12);
+}
 
-{ 
-FLAECHENTYP i;
+/*********************MISCHEN***********************************/
 
-if ((liste->code)[0]==0) return;
-ausgabe(liste->smaller,knotenzahl,lastcode);
+static void mischen(LAUF *laeufe, int anzahl, int knotenzahl, FILE *ziel, BOOL komprimiert)
+/* mischt die Laeufe in ziel -- entweder als neuer Lauf oder in codeart 3 --
+   und loescht sie. Die Laeufe mit dem kleinsten Code stehen in einem Heap. */
+{
+FILE *quelle[MAXMISCHEN];
+CODETYP code[MAXMISCHEN][12], lastcode[12];
+int heap[MAXMISCHEN], i, j, k, groesse, merke;
+char name[filenamenlaenge];
+
+for (i=0; i<12; i++) lastcode[i]=UCHAR_MAX;
+
+for (i=groesse=0; i<anzahl; i++)
+  { laufdateiname(name,laeufe[i],knotenzahl);
+    quelle[i]=fopen(name,"rb");
+    if (quelle[i]==nil) { fprintf(stderr,"Can not open file %s. \n",name); exit(130); }
+    remove(name); /* bleibt bis zum fclose lesbar */
+    if (fread(code[i],12,1,quelle[i])==1)
+      { /* nach oben sieben */
+	for (j=groesse++; (j>0) && (memcmp(code[heap[(j-1)/2]],code[i],12)>0); j=(j-1)/2)
+	  heap[j]=heap[(j-1)/2];
+	heap[j]=i; }
+  }
 
-for (i=0; (liste->code)[i]==(*lastcode)[i]; i++);
-fwrite(&i,sizeof(FLAECHENTYP),1,fil[knotenzahl]);
-fwrite((liste->code)+i,sizeof(FLAECHENTYP),12-i,fil[knotenzahl]);
-*lastcode=liste->code;
+while (groesse>0)
+  { k=heap[0];
+    if (komprimiert) schreibe_komprimiert(code[k],lastcode,ziel);
+    else
+      { if (memcmp(code[k],lastcode,12)==0) 
+	  { fprintf(stderr,"Dangerous error -- Two equal codes ! \n"); exit(2); }
+	fwrite(code[k],12,1,ziel); memcpy(lastcode,code[k],12); }
+    if (fread(code[k],12,1,quelle[k])!=1) k=heap[--groesse];
+    /* k nach unten sieben */
+    for (j=0; 2*j+1<groesse; j=merke)
+      { merke=2*j+1;
+	if ((merke+1<groesse) && (memcmp(code[heap[merke+1]],code[heap[merke]],12)<0)) merke++;
+	if (memcmp(code[heap[merke]],code[k],12)>=0) break;
+	heap[j]=heap[merke]; }
+    heap[j]=k;
+  }
 
-ausgabe(liste->larger,knotenzahl,lastcode);
+for (i=0; i<anzahl; i++) fclose(quelle[i]);
 }
 
-/********************LISTELEER********************************/
+/*********************AUSGABE***********************************/
 
-void listeleer(LISTENTRY *liste)
+static void ausgabe(int knotenzahl)
+/* schreibt alle Codes fuer knotenzahl sortiert in fil[knotenzahl] */
 {
-if ((liste->code)[0]==0) return;
+SORTIERLISTE *liste;
+LAUF *laeufe, neu;
+int anzahl, i, j, w, zwischenlaeufe=0;
+CODETYP lastcode[12];
+char name[filenamenlaenge];
+FILE *f;
+
+liste=codeliste+knotenzahl;
+for (i=0; i<12; i++) lastcode[i]=UCHAR_MAX;
+
+anzahl=liste->laeufe;
+if (thread_laeufe!=nil) for (w=0; w<threads; w++) anzahl+=thread_laeufe[w*(N+1)+knotenzahl];
+
+if (anzahl==0) /* alles passt in den Puffer */
+  { if (liste->anzahl)
+      { sortiere_codes(liste->codes,liste->anzahl);
+	for (i=0; i<liste->anzahl; i++) schreibe_komprimiert(liste->codes+12*i,lastcode,fil[knotenzahl]); }
+  }
+else
+  { if (liste->anzahl) { schreibe_lauf(knotenzahl); anzahl++; }
+    laeufe=(LAUF *)malloc(anzahl*sizeof(LAUF));
+    if (laeufe==nil) { fprintf(stderr,"Can not get memory in \"ausgabe\". \n"); exit(130); }
+    for (i=anzahl=0; i<liste->laeufe; i++) { laeufe[anzahl].arbeiter=arbeiter_nummer; laeufe[anzahl++].nummer=i; }
+    if (thread_laeufe!=nil)
+      for (w=0; w<threads; w++)
+	for (i=0; i<thread_laeufe[w*(N+1)+knotenzahl]; i++) { laeufe[anzahl].arbeiter=w; laeufe[anzahl++].nummer=i; }
+    /* solange es zu viele sind, je MAXMISCHEN Laeufe zu einem neuen mischen */
+    while (anzahl>MAXMISCHEN)
+      { for (i=j=0; i<anzahl; i+=MAXMISCHEN, j++)
+	  { neu.arbeiter=threads+1; neu.nummer=zwischenlaeufe++;
+	    laufdateiname(name,neu,knotenzahl);
+	    f=fopen(name,"wb");
+	    if (f==nil) { fprintf(stderr,"Can not open file %s. \n",name); exit(130); }
+	    mischen(laeufe+i,(anzahl-i<MAXMISCHEN) ? anzahl-i : MAXMISCHEN,knotenzahl,f,0);
+	    if (fclose(f)) { fprintf(stderr,"Can not write file %s. \n",name); exit(130); }
+	    laeufe[j]=neu; }
+	anzahl=j; }
+    mischen(laeufe,anzahl,knotenzahl,fil[knotenzahl],1);
+    free(laeufe);
+  }
+
+free(liste->codes);
+liste->codes=nil; liste->anzahl=liste->laeufe=0;
+}
+
+
+/*************************FULLGEN_SET_CALLBACK*****************************/
 
-listeleer(liste->smaller); free(liste->smaller);
-listeleer(liste->larger); free(liste->larger);
+void fullgen_set_callback(FULLGEN_CALLBACK funktion, void *daten)
+/* traegt die Funktion ein, die codiereplanar() statt der Codierung aufruft
+   -- siehe fullgen.h */
+{
+rueckruf=funktion; rueckrufdaten=daten;
 }
 
+/*************************FULLGEN_SYMMETRY_NAME*****************************/
+
+const char *fullgen_symmetry_name(int symmetrie)
+{
+if ((symmetrie<1) || (symmetrie>28)) return(nil);
+return(symm_name[symmetrie]);
+}
 
 /*************************CODIEREPLANAR*****************************/
 
-void codiereplanar( PLANMAP map )
+static void codiereplanar( PLANMAP map, int symmetrie )
 {
 /* Codiert die Einbettung, schreibt sie in das entsprechende file oder
-   auf stdout und gibt die laenge des codes zurueck */
+   auf stdout und gibt die laenge des codes zurueck.
+   Ist eine Funktion mit fullgen_set_callback() eingetragen, wird nur sie
+   aufgerufen. */
 int zaehler,knotenzahl;
-FLAECHENTYP codeF[2*(81+8*S)];
-FLAECHENTYP  *codeFPZ, i;
- static FLAECHENTYP dummycode[12]={UCHAR_MAX,UCHAR_MAX,UCHAR_MAX,0,0,0,0,0,0,0,0,0}; 
-FILE *fil2;
+CODETYP codeF[CODELAENGE];
+FLAECHENTYP spirale[12];
+CODETYP i;
 BOOL test;
-static int write_nospiheader=1;
+
+if (rueckruf!=nil)
+  { if (!abbrechen && (*rueckruf)(map,symmetrie,rueckrufdaten)) abbrechen=1;
+    return; }
 
 knotenzahl=map[0][0].name;
+sp_aktuell=0; /* neue map -- die Flaechen werden bei Bedarf neu bestimmt */
 
 if (spistat) spiralstatistic(map);
 
@@ -997,35 +1411,17 @@ switch(codenumber)
   {
   case 0: {
            if (spiralcheck)
-	     { test=spiralcode(map,codeF); 
+	     { test=spiralcode(map,spirale); 
 	       if (!test)
-		 { zaehler=longcode(map,codeF);
-		   fil2=fopen(no_spiral_filename,"ab");
-		if (fil2==NULL) { fprintf(stderr,"Can't open %s\n",no_spiral_filename);
-		                  exit(1); }
-		if (write_nospiheader)
-		  { write_nospiheader=0;
-		  fprintf(fil2,">>planar_code %ce<<", my_endianness);
-		  }
-		   fwrite(codeF,sizeof(FLAECHENTYP),zaehler,fil2);
-		   fclose(fil2);
+		 { schreibe_ohne_spirale(map,0);
 		 }
 	     }
 	   break; }
   case 1: { 
            if (spiralcheck)
-	     { test=spiralcode(map,codeF); 
+	     { test=spiralcode(map,spirale); 
 	       if (!test)
-		 { zaehler=longcode(map,codeF);
-		   fil2=fopen(no_spiral_filename,"ab");
-		   if (fil2==NULL) { fprintf(stderr,"Can't open %s\n",no_spiral_filename);
-		   exit(1); }
-		   if (write_nospiheader)
-		     { write_nospiheader=0;
-		     fprintf(fil2,">>planar_code %ce<<", my_endianness);
-		     }
-		   fwrite(codeF,sizeof(FLAECHENTYP),zaehler,fil2);
-		   fclose(fil2);
+		 { schreibe_ohne_spirale(map,0);
 		 }
 	     }
             zaehler=longcode(map,codeF);
@@ -1041,67 +1437,30 @@ switch(codenumber)
 		           fprintf(fil[knotenzahl],">>planar_code %ce<<", my_endianness);
 			 }
 	      }
-	    fwrite(codeF,sizeof(FLAECHENTYP),zaehler,fil[knotenzahl]);
+	    fwrite(codeF,sizeof(CODETYP),zaehler,fil[knotenzahl]);
 	    break; }
-  case 2: { test=spiralcode(map,codeF);
-	    if (test) { for (i=0; codeF[i]==last_code[i]; i++);
-			fwrite(&i,sizeof(FLAECHENTYP),1,fil[knotenzahl]);
-	                fwrite(codeF+i,sizeof(FLAECHENTYP),12-i,fil[knotenzahl]);
+  case 2: { test=spiralcode(map,spirale);
+	    if (test) { for (i=0; i<12; i++) codeF[i]=spirale[i]; /* passt -- siehe main */
+			for (i=0; codeF[i]==last_code[i]; i++);
+			fwrite(&i,sizeof(CODETYP),1,fil[knotenzahl]);
+	                fwrite(codeF+i,sizeof(CODETYP),12-i,fil[knotenzahl]);
 		        for ( ; i<12; i++) last_code[i]=codeF[i];}
 	    else
-	      { zaehler=longcode(map,codeF);
-		fil2=fopen(no_spiral_filename,"ab");
-		if (fil2==NULL) { fprintf(stderr,"Can't open %s\n",no_spiral_filename);
-		exit(1); }
-		if (write_nospiheader)
-		  { write_nospiheader=0;
-		  fprintf(fil2,">>planar_code %ce<<", my_endianness);
-		  }
-		fwrite(codeF,sizeof(FLAECHENTYP),zaehler,fil2);
-		fclose(fil2);
+	      { schreibe_ohne_spirale(map,0);
 	      }
 	    break; }
   case 3: { 
-            test=minspiralcode(map,codeF);
-	    if (test) { in_liste(codeF,codeliste+knotenzahl);
-			if (graphenzahl[knotenzahl]%((long long int)listenlaenge)==0)
-			  {
-			    if (fil[knotenzahl]==stdout)
-			      codeFPZ = dummycode;
-			    else codeFPZ = *(lastcode[knotenzahl]);
-			  ausgabe(codeliste+(knotenzahl),knotenzahl,&codeFPZ);
-			  for (i=0; i<12; i++) (*(lastcode[knotenzahl]))[i]= codeFPZ[i];
-			  listeleer(codeliste+(knotenzahl));
-			  (codeliste[knotenzahl].code)[0]=0;
-			}
-		      }
+            test=minspiralcode(map,spirale);
+	    if (test) in_liste(spirale,knotenzahl);
 	    else
-	      { zaehler=longcode(map,codeF);
-		fil2=fopen(no_spiral_filename,"ab");
-		if (fil2==NULL) { fprintf(stderr,"Can't open %s\n",no_spiral_filename);
-		exit(1); }
-		if (write_nospiheader)
-		  { write_nospiheader=0;
-		  fprintf(fil2,">>planar_code %ce<<", my_endianness);
-		  }
-		fwrite(codeF,sizeof(FLAECHENTYP),zaehler,fil2);
-		fclose(fil2);
+	      { schreibe_ohne_spirale(map,0);
 	      }
 	    break; }
   case 4: {
             if (spiralcheck)
-	      { test=spiralcode(map,codeF); 
+	      { test=spiralcode(map,spirale); 
 		if (!test)
-		  { zaehler=longcode(map,codeF);
-		    fil2=fopen(no_spiral_filename,"ab");
-		   if (fil2==NULL) { fprintf(stderr,"Can't open %s\n",no_spiral_filename);
-		   exit(1); }
-		   if (write_nospiheader)
-		     { write_nospiheader=0;
-		     fprintf(fil2,">>planar_code %ce<<", my_endianness);
-		     }
-		    fwrite(codeF,sizeof(FLAECHENTYP),zaehler,fil2);
-		    fclose(fil2);
+		  { schreibe_ohne_spirale(map,0);
 		  }
 	      }
 	    break; }
@@ -1118,76 +1477,40 @@ switch(codenumber)
 		         { write_header_fil[knotenzahl]=0;
 		           fprintf(fil[knotenzahl],">>planar_code %ce<<", my_endianness);
 			 }
-	    fwrite(codeF,sizeof(FLAECHENTYP),zaehler,fil[knotenzahl]);
-            test=spiralcode(map,codeF); 
+	    fwrite(codeF,sizeof(CODETYP),zaehler,fil[knotenzahl]);
+            test=spiralcode(map,spirale); 
 	    if (!test)
-	      { zaehler=longcode(map,codeF);
-		fil2=fopen(no_spiral_filename,"ab");
-		if (fil2==NULL) { fprintf(stderr,"Can't open %s\n",no_spiral_filename);
-		exit(1); }
-		if (write_nospiheader)
-		  { write_nospiheader=0;
-		  fprintf(fil2,">>planar_code %ce<<", my_endianness);
-		  }
-		fwrite(codeF,sizeof(FLAECHENTYP),zaehler,fil2);
-		fclose(fil2);
+	      { schreibe_ohne_spirale(map,0);
 	      }
 	    break; }
 
   case 6: { vegacode(stdout,map); 
             if (spiralcheck)
-	      { test=spiralcode(map,codeF); 
+	      { test=spiralcode(map,spirale); 
 		if (!test)
-		  { zaehler=longcode(map,codeF);
-		    fil2=fopen(no_spiral_filename,"ab");
-		   if (fil2==NULL) { fprintf(stderr,"Can't open %s\n",no_spiral_filename);
-		   exit(1); }
-		   if (write_nospiheader)
-		     { write_nospiheader=0;
-		     fprintf(fil2,">>planar_code %ce<<", my_endianness);
-		     }
-		    fwrite(codeF,sizeof(FLAECHENTYP),zaehler,fil2);
-		    fclose(fil2);
+		  { schreibe_ohne_spirale(map,0);
 		  }
 	      }
 	    break; }
 
   case 7: { dualcode(map); 
             if (spiralcheck)
-	      { test=spiralcode(map,codeF); 
+	      { test=spiralcode(map,spirale); 
 		if (!test)
-		  { zaehler=longcode(map,codeF);
-		    fil2=fopen(no_spiral_filename,"ab");
-		    if (fil2==NULL) { fprintf(stderr,"Can't open %s\n",no_spiral_filename);
-		    exit(1); }
-		    if (write_nospiheader)
-		      { write_nospiheader=0;
-		      fprintf(fil2,">>planar_code %ce<<", my_endianness);
-		      }
-		    fwrite(codeF,sizeof(FLAECHENTYP),zaehler,fil2);
-		    fclose(fil2);
+		  { schreibe_ohne_spirale(map,0);
 		  }
 	      }
 	    break; }
 
   case 8: {
            if (spiralcheck)
-             { test=spiralcode(map,codeF);
+             { test=spiralcode(map,spirale);
                if (!test)
-                 { zaehler=longcode(map,codeF);
-                   fil2=fopen(no_spiral_filename,"ab");
-                   if (fil2==NULL) { fprintf(stderr,"Can't open %s\n",no_spiral_filename);
-                   exit(1); }
-                   if (write_nospiheader)
-                     { write_nospiheader=0;
-                     fprintf(fil2,">>planar_code %ce<<", my_endianness);
-                     }
-                   fwrite(codeF,sizeof(FLAECHENTYP),zaehler,fil2);
-                   fclose(fil2);
+                 { schreibe_ohne_spirale(map,0);
                  }
              }
             zaehler=sparse6code(map,codeF);
-            fwrite(codeF,sizeof(FLAECHENTYP),zaehler,fil[knotenzahl]);
+            fwrite(codeF,sizeof(CODETYP),zaehler,fil[knotenzahl]);
             break; }
 
   default: { fprintf(stderr,"Dangerous error in switch (codiereplanar) ! \n"); exit(3); }
@@ -1196,15 +1519,28 @@ switch(codenumber)
 
 
 
+/*******************NEUE_MAP************************/
+
+static void *neue_map(void)
+/* alloziert eine map mit maxknoten+1 Zeilen. Die Funktionen, die vorher
+   eine PLANMAP (N+1 Zeilen) auf dem Stack hatten, benutzen diese. */
+{
+void *map;
+
+map=malloc((size_t)(maxknoten+1)*3*sizeof(KANTE));
+if (map==nil) { fprintf(stderr,"Can not get memory for the map. \n"); exit(131); }
+return(map);
+}
+
 /*******************INIT_MAP************************/
 
-void init_map(PLANMAP map)
+static void init_map(PLANMAP map)
 {
 int i,j;
 
 map[0][0].name=0;
 
-for (i=1; i<=N; i++)
+for (i=1; i<=maxknoten; i++)
 {
 map[i][0].next= map[i]+1; map[i][0].prev= map[i]+2;
 map[i][1].next= map[i]+2; map[i][1].prev= map[i];
@@ -1222,7 +1558,7 @@ for (j=0; j<3; j++)
 /* Baut ein einzelnes leeres Polygon mit n Ecken (n>=3) 
    und initialisiert map */
 
-void baue_polygon(int n, PLANMAP map, KANTE **marke )
+static void baue_polygon(int n, PLANMAP map, KANTE **marke )
 {
 int j;
 
@@ -1256,7 +1592,7 @@ map[0][0].name=n;
 
 /* bestimmt die groesse der flaeche rechts von edge -- ist da keine gibt's Probleme */
 
-int checksize_right( KANTE* edge)
+static int checksize_right( KANTE* edge)
 {
 KANTE *run; 
 int zaehler=1;
@@ -1270,7 +1606,7 @@ return(zaehler);
 
 /*********************ADD_POLYGON***********************************/
 
-void add_polygon(int n, PLANMAP map, KANTE *start, KANTE **lastout)
+static void add_polygon(int n, PLANMAP map, KANTE *start, KANTE **lastout)
 /* fuegt ein weiteres polygon einer Reihe an. Dabei ist n die groesse des polygons. 
    Angefuegt wird immer an start. Die Marke wird nicht versetzt. Ueber lastout wird
    die letzte Aussenkante des Polygons zurueckgegeben. */
@@ -1349,7 +1685,7 @@ map[0][0].name=tempknz;
 
 /**********************SEQUENZ_KANONISCH***********************************/
 
-int sequenz_kanonisch( int sequenz[] )
+static int sequenz_kanonisch( int sequenz[] )
 /* checkt, ob eine sequenz kanonisch ist, gibt 1 zurueck wenn ja, 0 sonst */
 
 { int i,j, laenge, max;
@@ -1379,7 +1715,7 @@ return(1);
 
 /***********************BERECHNE_SEQUENZ********************************/
 
-void berechne_sequenz(SEQUENZ *sq, SEQUENZ altsq, int start,int f_ecke)
+static void berechne_sequenz(SEQUENZ *sq, SEQUENZ altsq, int start,int f_ecke)
 /* berechnet die neue sequenz startend bei der Kante start */
 /* geht fest davon aus, dass 2 mal nach innen hintereinander nicht vorkommt */
 /* zwei der Kanten-Eintraege koennen noch nicht belegt werden (die ersten beiden) */
@@ -1489,7 +1825,7 @@ for (i=1; i < laenge; i++)
 
 /***********************BELEGE_SEQUENZ********************************/
 
-void belege_sequenz( KANTE *start, SEQUENZ *sq)
+static void belege_sequenz( KANTE *start, SEQUENZ *sq)
 /* belegt die sequenz startend bei der Kante start */
 /* geht fest davon aus, dass 2 mal nach innen hintereinander nicht vorkommt */
 
@@ -1573,7 +1909,7 @@ for (i=1; sequenz[i] != leer; i++)
 
 /* bestimmt die groesse der flaeche links von edge -- ist da keine gibt's Probleme */
 
-int checksize(KANTE* edge)
+static int checksize(KANTE* edge)
 {
 KANTE *run; 
 int zaehler=1;
@@ -1611,7 +1947,7 @@ return(zaehler);
 */
 
 
-int codiere(PLANMAP map, FLAECHENTYP *code, KANTE *start, int codesize, int laenge)
+static int codiere(PLANMAP map, FLAECHENTYP *code, KANTE *start, int codesize, int laenge)
 {
 int i, j, stelle, zaehler, knotenzahl, flaechennumber, verschiebung, merkeknoten;
 /* zaehler zaehlt die Flaechengroesse, knotenzahl die zahl der restlichen knoten */
@@ -1711,15 +2047,18 @@ return(1);
 
 /***********************BBITEMALLOC********************************************/
 
-BBITEMLISTE *bbitemalloc()
+static BBITEMLISTE *bbitemalloc()
 /* gibt immer die Adresse eines neuen bbitems zurueck */
 {
 static BBITEMLISTE *back=nil; /* back enthaelt immer den letzten, der zurueckgegeben 
 			       wurde -- erst hochsetzen -- wichtig */
 static BBITEMLISTE *last=nil;
+BBALLOCLISTE *feld;
 
 if (back==last) { back=(BBITEMLISTE *)malloc(sizeof(BBITEMLISTE)*1001);
-		  if (back==NULL) { fprintf(stderr,"Can not get more memory for bbitems"); exit(11); }
+		  feld=(BBALLOCLISTE *)malloc(sizeof(BBALLOCLISTE));
+		  if ((back==NULL) || (feld==NULL)) { fprintf(stderr,"Can not get more memory for bbitems"); exit(11); }
+		  feld->space=back; feld->prev=bbitemfelder; bbitemfelder=feld;
 		  last=back+1000;
 		  return(back); }
 
@@ -1731,15 +2070,18 @@ return(back);
 
 /***********************ITEMALLOC********************************************/
 
-ITEMLISTE *itemalloc()
+static ITEMLISTE *itemalloc()
 /* gibt immer die Adresse eines neuen items zurueck */
 {
 static ITEMLISTE *back=nil; /* back enthaelt immer den letzten, der zurueckgegeben 
 			       wurde -- erst hochsetzen -- wichtig */
 static ITEMLISTE *last=nil;
+ALLOCLISTE *feld;
 
 if (back==last) { back=(ITEMLISTE *)malloc(sizeof(ITEMLISTE)*1001);
-		  if (back==NULL) { fprintf(stderr,"Can not get more memory for items"); exit(12); }
+		  feld=(ALLOCLISTE *)malloc(sizeof(ALLOCLISTE));
+		  if ((back==NULL) || (feld==NULL)) { fprintf(stderr,"Can not get more memory for items"); exit(12); }
+		  feld->space=back; feld->prev=itemfelder; itemfelder=feld;
 		  last=back+1000;
 		  return(back); }
 
@@ -1751,7 +2093,7 @@ return(back);
 
 /*******************PUT_IN_LISTE***********************************************/
 
-void put_in_liste(int sechsecke, SEQUENZ sq, FLAECHENTYP *code, int codesize )
+static void put_in_liste(int sechsecke, SEQUENZ sq, FLAECHENTYP *code, int codesize )
 {
 
 ITEMLISTE *item;
@@ -1797,7 +2139,7 @@ for (j=0; j<codesize; j++) item->code[j]=code[j];
 
 /*******************PUT_IN_BB_LISTE***********************************************/
 
-void put_in_bb_liste(int sechsecke, SEQUENZ sq, FLAECHENTYP *code)
+static void put_in_bb_liste(int sechsecke, SEQUENZ sq, FLAECHENTYP *code)
 {
 
 BBITEMLISTE *item, **puffer, *merke;
@@ -1839,7 +2181,7 @@ for (j=0; j<8; j++) item->code[j]=code[j];
 
 /************************SCHREIBE_AUF************************************/
 
-void schreibe_auf(PLANMAP map, SEQUENZ sq, int rest_sechsecke)
+static void schreibe_auf(PLANMAP map, SEQUENZ sq, int rest_sechsecke)
 /* codiert und schreibt eine markierte Pflasterung -- wird nur fuer
    bis zu 5 Fuenfecken aufgerufen */
 {
@@ -1895,7 +2237,7 @@ return;
 Doppelte Aussenkanten, neu ist. Wenn ja, codiert und speichert sie die Einbettung
 und alle sich daraus durch hinzufuegen von 6-Eck-Ringen ergebenden */
 
-void check_mark_und_schreibe(PLANMAP map, KANTE *first, int laenge, int rest_sechsecke)
+static void check_mark_und_schreibe(PLANMAP map, KANTE *first, int laenge, int rest_sechsecke)
 {
 
 
@@ -1941,7 +2283,7 @@ return;
 /* die eigentliche konstruktionsroutine -- legt auf alle moeglichen arten eine
 neue reihe an */
 
-void baue_auf(PLANMAP map, SEQUENZ sq, int sechsecke)
+static void baue_auf(PLANMAP map, SEQUENZ sq, int sechsecke)
 {
 
 SEQUENZ localseq;
@@ -2246,13 +2588,14 @@ if (laenge && (sechsecke >= laenge))
 
 /***************************BAUE_PATCHES************************************/
 
-void baue_patches(int sechsecke)
+static void baue_patches(int sechsecke)
 {
-PLANMAP map;
+KANTE (*map)[3];
 SEQUENZ sq;
 KANTE *marke;
 int i;
 
+map=neue_map();
 
 for (i=0; i<=N; i++) bblmark[i]=brillenglasmark[i]=zwei_3_4_mark[i]=0;
 
@@ -2300,11 +2643,12 @@ for (maxbrillenglas=N; brillenglasmark[maxbrillenglas]==0; maxbrillenglas--);
 for (min_2_3_4=1; zwei_3_4_mark[min_2_3_4]==0; min_2_3_4++);
 
 
+free(map);
 }
 
 /***********************INITIALIZE_LIST**********************************/
 
-void initialize_list()
+static void initialize_list()
 {
 int j;
 SEQUENZLISTE *qq;
@@ -2338,24 +2682,285 @@ for (j=0; j<=max_sechsecke; j++)
 
 
 
+/***********************PATCHZEIGER_SETZEN*******************************/
+
+#define AUFRUNDEN(x) ((((long long int)(x))+7) & ~7LL)
+
+static long long int patchzeiger_setzen(PATCHKOPF *kopf, char *block)
+/* berechnet aus den Anzahlen im Kopf die Lage der Felder im Block und gibt
+   die Groesse des Blocks zurueck. Ist block nicht nil, werden patchkopf und
+   die Zeiger auf die Felder gesetzt. */
+{
+long long int stelle, knoten, kinder, faecher, items, bbitems;
+
+stelle=AUFRUNDEN(sizeof(PATCHKOPF));
+knoten=stelle; stelle+=AUFRUNDEN((long long int)kopf->anzahl_knoten*sizeof(PATCHKNOTEN));
+kinder=stelle; stelle+=AUFRUNDEN((long long int)kopf->anzahl_kinder*sizeof(int));
+faecher=stelle; stelle+=AUFRUNDEN((long long int)kopf->anzahl_bbfaecher*sizeof(BBFACH));
+items=stelle; stelle+=AUFRUNDEN((long long int)kopf->anzahl_items*sizeof(PATCHITEM));
+bbitems=stelle; stelle+=AUFRUNDEN((long long int)kopf->anzahl_bbitems*sizeof(BBPATCHITEM));
+
+if (block!=nil)
+  { patchkopf=(PATCHKOPF *)block;
+    patchknoten=(PATCHKNOTEN *)(block+knoten);
+    patchkinder=(int *)(block+kinder);
+    bbfaecher=(BBFACH *)(block+faecher);
+    patchitems=(PATCHITEM *)(block+items);
+    bbpatchitems=(BBPATCHITEM *)(block+bbitems); }
+
+return(stelle);
+}
+
+/***********************ZAEHLE_SEQUENZLISTE*******************************/
+
+static void zaehle_sequenzliste(SEQUENZLISTE *sq, int *knoten, int *kinder, int *items)
+{
+int i;
+ITEMLISTE *item;
+
+(*knoten)++;
+(*kinder) += sq->number_next;
+for (item=sq->items; item!=nil; item=item->next_item) (*items)++;
+for (i=0; i<sq->number_next; i++)
+  if (sq->next_level[i]!=nil) zaehle_sequenzliste(sq->next_level[i],knoten,kinder,items);
+}
+
+/***********************KOPIERE_SEQUENZLISTE*******************************/
+
+static int kopiere_sequenzliste(SEQUENZLISTE *sq, int *knoten, int *kinder, int *items)
+/* schreibt sq in die verdichteten Felder, gibt sq dabei frei und gibt
+   die Nummer des Knotens zurueck */
+{
+int i, nummer;
+ITEMLISTE *item;
+PATCHKNOTEN *k;
+
+nummer=(*knoten)++;
+k=patchknoten+nummer;
+k->number_next=sq->number_next;
+k->kinder= *kinder; (*kinder) += sq->number_next;
+k->erstes= *items; k->anzahl=0;
+for (item=sq->items; item!=nil; item=item->next_item)
+  { memcpy(patchitems[*items].code,item->code,sizeof(item->code));
+    (*items)++; k->anzahl++; }
+for (i=0; i<sq->number_next; i++)
+  patchkinder[k->kinder+i]= (sq->next_level[i]==nil) ? -1 :
+                             kopiere_sequenzliste(sq->next_level[i],knoten,kinder,items);
+free(sq->next_level);
+free(sq);
+return(nummer);
+}
+
+/***********************VERDICHTE_PATCHES*******************************/
+
+static void verdichte_patches()
+/* schreibt die von baue_patches() erzeugten Listen in einen Block ohne
+   Zeiger (siehe PATCHKOPF) und gibt die Listen frei */
+{
+PATCHKOPF kopf;
+int j, s_eintrag, knoten, kinder, items, faecher, bbitems;
+BBITEMLISTE *bbitem;
+BBSEQUENZLISTE *bbsq;
+BBFACH *fach;
+ALLOCLISTE *feld;
+BBALLOCLISTE *bbfeld;
+char *block;
+
+memset(&kopf,0,sizeof(PATCHKOPF));
+strcpy(kopf.kennung,"fullgen patches");
+kopf.version=PATCHVERSION; kopf.n=N; kopf.s=S; kopf.endian=my_endianness;
+kopf.sechsecke=max_sechsecke; kopf.ipr=IPR;
+kopf.mit_bb=do_bauchbinde; kopf.mit_map=(do_brille || do_sandwich);
+kopf.total_maps=mapliste.total_maps;
+kopf.bb_total_items=bbliste.total_items; kopf.bb_total_maps=bbliste.total_maps;
+kopf.minbbl=minbbl; kopf.maxbbl=maxbbl;
+kopf.minbrillenglas=minbrillenglas; kopf.maxbrillenglas=maxbrillenglas;
+kopf.min_2_3_4=min_2_3_4;
+memcpy(kopf.bblmark,bblmark,sizeof(bblmark));
+memcpy(kopf.brillenglasmark,brillenglasmark,sizeof(brillenglasmark));
+memcpy(kopf.zwei_3_4_mark,zwei_3_4_mark,sizeof(zwei_3_4_mark));
+
+knoten=kinder=items=faecher=bbitems=0;
+for (j=0; j<=max_sechsecke; j++)
+  { zaehle_sequenzliste(mapliste.sechser[j],&knoten,&kinder,&items);
+    bbsq=bbliste.sechser[j];
+    kopf.bbanfang[j]=faecher; kopf.bbanzahl[j]=bbsq->number_next;
+    faecher += bbsq->number_next;
+    for (s_eintrag=0; s_eintrag<bbsq->number_next; s_eintrag++)
+      for (bbitem=bbsq->items[s_eintrag]; bbitem!=nil; bbitem=bbitem->next_item) bbitems++;
+  }
+kopf.anzahl_knoten=knoten; kopf.anzahl_kinder=kinder; kopf.anzahl_items=items;
+kopf.anzahl_bbfaecher=faecher; kopf.anzahl_bbitems=bbitems;
+kopf.groesse=patchzeiger_setzen(&kopf,nil);
+
+block=(char *)malloc(kopf.groesse);
+if (block==NULL) { fprintf(stderr,"Can not get memory for the patches. \n"); exit(127); }
+memset(block,0,kopf.groesse);
+memcpy(block,&kopf,sizeof(PATCHKOPF));
+patchzeiger_setzen(&kopf,block);
+
+knoten=kinder=items=bbitems=0;
+for (j=0; j<=max_sechsecke; j++)
+  { patchkopf->wurzel[j]=kopiere_sequenzliste(mapliste.sechser[j],&knoten,&kinder,&items);
+    mapliste.sechser[j]=nil;
+    bbsq=bbliste.sechser[j];
+    for (s_eintrag=0; s_eintrag<bbsq->number_next; s_eintrag++)
+      { fach=bbfaecher+patchkopf->bbanfang[j]+s_eintrag;
+	fach->erstes=bbitems; fach->anzahl=0;
+	for (bbitem=bbsq->items[s_eintrag]; bbitem!=nil; bbitem=bbitem->next_item)
+	  { memcpy(bbpatchitems[bbitems].code,bbitem->code,sizeof(bbitem->code));
+	    bbitems++; fach->anzahl++; }
+      }
+    free(bbsq->items); free(bbsq);
+    bbliste.sechser[j]=nil;
+  }
+
+while (itemfelder!=nil)
+  { feld=itemfelder; itemfelder=feld->prev; free(feld->space); free(feld); }
+while (bbitemfelder!=nil)
+  { bbfeld=bbitemfelder; bbitemfelder=bbfeld->prev; free(bbfeld->space); free(bbfeld); }
+}
+
+/***********************SCHREIBE_PATCHDATEI*******************************/
+
+static void schreibe_patchdatei(char *name)
+/* schreibt den Block unter einem anderen Namen und benennt ihn erst dann
+   um, so dass andere Prozesse nie eine halbe Datei lesen */
+{
+char hilfsname[filenamenlaenge+20];
+FILE *f;
+
+sprintf(hilfsname,"%s.%d",name,(int)getpid());
+f=fopen(hilfsname,"wb");
+if (f==nil) { fprintf(stderr,"Can not open file %s. \n",hilfsname); exit(128); }
+if ((fwrite(patchkopf,1,patchkopf->groesse,f)!=(size_t)patchkopf->groesse) || fclose(f))
+  { fprintf(stderr,"Can not write file %s. \n",hilfsname); remove(hilfsname); exit(128); }
+if (rename(hilfsname,name))
+  { fprintf(stderr,"Can not rename %s to %s. \n",hilfsname,name); remove(hilfsname); exit(128); }
+}
+
+/***********************LIES_PATCHDATEI*******************************/
+
+static BOOL lies_patchdatei(char *name)
+/* bildet die Datei mit mmap() nur lesend ab. Gibt 0 zurueck, wenn es sie
+   nicht gibt -- passt sie nicht zu diesem Aufruf, wird abgebrochen. */
+{
+int fd;
+struct stat buf;
+char *block;
+PATCHKOPF *kopf;
+
+fd=open(name,O_RDONLY);
+if (fd<0) return 0;
+if (fstat(fd,&buf) || (buf.st_size<(off_t)sizeof(PATCHKOPF)))
+  { fprintf(stderr,"%s is not a fullgen patch file. \n",name); exit(129); }
+block=(char *)mmap(nil,buf.st_size,PROT_READ,MAP_SHARED,fd,0);
+if (block==MAP_FAILED) { fprintf(stderr,"Can not map file %s. \n",name); exit(129); }
+close(fd);
+
+kopf=(PATCHKOPF *)block;
+if (strcmp(kopf->kennung,"fullgen patches") || (kopf->version!=PATCHVERSION) || (kopf->n!=N)
+    || (kopf->s!=S) || (kopf->endian!=my_endianness) 
+    || (kopf->groesse!=buf.st_size) || (patchzeiger_setzen(kopf,nil)!=kopf->groesse))
+  { fprintf(stderr,"%s is not a fullgen patch file of this version. \n",name); exit(129); }
+if ((kopf->sechsecke!=max_sechsecke) || (kopf->ipr!=IPR))
+  { fprintf(stderr,"%s contains the patches for %d vertices%s. \n",name,20+2*kopf->sechsecke,
+	    kopf->ipr ? " (ipr)" : " (not ipr)");
+    exit(129); }
+if ((do_bauchbinde && !kopf->mit_bb) || ((do_brille || do_sandwich) && !kopf->mit_map))
+  { fprintf(stderr,"%s was written for a different case. \n",name); exit(129); }
+
+patchzeiger_setzen(kopf,block);
+memcpy(bblmark,kopf->bblmark,sizeof(bblmark));
+memcpy(brillenglasmark,kopf->brillenglasmark,sizeof(brillenglasmark));
+memcpy(zwei_3_4_mark,kopf->zwei_3_4_mark,sizeof(zwei_3_4_mark));
+minbbl=kopf->minbbl; maxbbl=kopf->maxbbl;
+minbrillenglas=kopf->minbrillenglas; maxbrillenglas=kopf->maxbrillenglas;
+min_2_3_4=kopf->min_2_3_4;
+mapliste.total_maps=kopf->total_maps;
+bbliste.total_items=kopf->bb_total_items; bbliste.total_maps=kopf->bb_total_maps;
+return 1;
+}
+
+
+
+/**********************REKO_ANFANG***************************************/
+
+/* Die Rekonstruktion in bauchbinde_reko(), brille_reko(), sandwich_reko()
+   und den _sp-Versionen benutzt dummy, noleft, noright und mininame der
+   Kanten. Statt diese Felder zu Beginn fuer alle Kanten der map zu
+   loeschen, faengt reko_anfang() eine neue Epoche an; eine Kante wird erst
+   beim ersten Zugriff ueber REKO() in dieser Epoche auf die Startwerte
+   gesetzt (dummy, noleft, noright 0, mininame der Name des Nachbarn bei
+   Bauchbinden und sonst 1), und zwar mit den beiden anderen Kanten
+   desselben Knotens; die Stempel stehen deshalb je Knoten in
+   reko_stempel[]. Alle Zugriffe auf diese Felder in den
+   Rekonstruktionsfunktionen muessen daher ueber REKO() gehen.
+   Ebenso markiert reko_bb_code() die Knoten eines Patches mit
+   knotenstempel[]==patch_epoche statt mit einem geloeschten Feld. */
+
+static int reko_stempel[N+1];
+static int reko_epoche=0;
+static KANTE (*reko_map)[3];
+static BOOL reko_mininame_ist_name;
+static int knotenstempel[N+1];
+static int patch_epoche=0;
+static KNOTENTYP patchliste[N+1];
+
+#define REKO(k) (reko_stempel[(k)->ursprung]==reko_epoche ? (k) : reko_belegen(k))
+
+static KANTE *reko_belegen(KANTE *k)
+{
+int j;
+KANTE *kante;
+
+reko_stempel[k->ursprung]=reko_epoche;
+for (j=0; j<3; j++)
+  { kante=reko_map[k->ursprung]+j;
+    kante->dummy=0; kante->noleft=kante->noright=0;
+    if (reko_mininame_ist_name) kante->mininame=kante->name; else kante->mininame=1; }
+return(k);
+}
+
+static void reko_anfang(PLANMAP map, BOOL mininame_ist_name)
+{
+int i;
+
+reko_epoche++;
+if (reko_epoche==INT_MAX)
+  { for (i=0; i<=N; i++) reko_stempel[i]=0;
+    reko_epoche=1; }
+reko_map=map;
+reko_mininame_ist_name=mininame_ist_name;
+}
+
 /**********************ZAEHLE_KNOTEN*************************************/
 
-void zaehle_knoten(PLANMAP map, KNOTENTYP knoten, BOOL mark[], int *patchknz)
+static void zaehle_knoten(PLANMAP map, KNOTENTYP knoten, int *patchknz)
 
-/* zaehlt die knoten, belegt aber auch dummy */
+/* zaehlt die knoten, belegt aber auch dummy. Markiert ist ein Knoten, wenn
+   knotenstempel[] gleich patch_epoche ist; die Knoten kommen der Reihe nach
+   in patchliste[]. Dabei werden mit REKO() die Knoten des Patches und ihre
+   Nachbarn draussen belegt -- weiter geht reko_bb_code() nicht, und kann
+   deshalb ohne REKO() auf die Felder zugreifen. */
 
 {
 int j;
+KNOTENTYP nachbar;
+KANTE *kante;
 
 for (j=0; j<3; j++) 
-  if (map[knoten][j].mininame == aussen) map[knoten][j].dummy=infty;
-   else { map[knoten][j].dummy=0;
-	  if (!mark[map[knoten][j].mininame])
-	    { (*patchknz)++;
-	      mark[map[knoten][j].mininame]=1;
-	      zaehle_knoten(map,map[knoten][j].mininame,mark,patchknz);
+  { kante=REKO(map[knoten]+j);
+    if (kante->mininame == aussen) { kante->dummy=infty; REKO(kante->invers); }
+   else { kante->dummy=0;
+	  nachbar=kante->mininame;
+	  if (knotenstempel[nachbar]!=patch_epoche)
+	    { patchliste[(*patchknz)++]=nachbar;
+	      knotenstempel[nachbar]=patch_epoche;
+	      zaehle_knoten(map,nachbar,patchknz);
 	    }
 	}
+  }
 }
 
 
@@ -2363,7 +2968,7 @@ for (j=0; j<3; j++)
 /**********************REKO_BB_CODE***************************************/
 /* Rekonstruiert den minimalen Code eines 6-Eck-patches */
 
-void reko_bb_code(PLANMAP map, KNOTENTYP *code, KNOTENTYP *spiegelcode, int laenge, 
+static void reko_bb_code(PLANMAP map, KNOTENTYP *code, KNOTENTYP *spiegelcode, int laenge, 
 		  KANTE *start, KANTE *ministart[], KANTE *spiegelministart[], int *patchknz)
 {
 int i, j, stelle, zaehler, knotenzahl, flaechennumber, schichtenzaehler, verschiebung, merkeknoten;
@@ -2372,7 +2977,6 @@ int laufzaehler;
 KANTE *run, *merke, *run2, *merke_run, *mstart;
 KNOTENTYP testcode[9];
 int mstartzaehler, test, k, laenge_2;
-BOOL mark[N+1];
 
 
 if (start->mininame != aussen) { fprintf(stderr,"Reko_BB_code must start at external edge !\n"); 
@@ -2382,10 +2986,14 @@ for (i=0; i<8; i++) { code[i]=spiegelcode[i]=unbelegt; testcode[i]=0; }
 mstartzaehler=0;
 for (i=0; i<7; i++) ministart[i]=spiegelministart[i]=nil;
 
-for (i=1; i<=map[0][0].name; i++) mark[i]=0;
-mark[start->ursprung]=1; *patchknz=1;
+patch_epoche++;
+if (patch_epoche==INT_MAX)
+  { for (i=0; i<=N; i++) knotenstempel[i]=0;
+    patch_epoche=1; }
+knotenstempel[start->ursprung]=patch_epoche;
+patchliste[0]=start->ursprung; *patchknz=1;
 
-zaehle_knoten(map,start->ursprung,mark,patchknz);
+zaehle_knoten(map,start->ursprung,patchknz);
 
 laenge_2 = laenge/2;
 run=start; knotenzahl=*patchknz;
@@ -2451,11 +3059,12 @@ for ( run2=run->prev; verschiebung<=laenge_2; verschiebung++, run2=run2->prev->i
 
 /* Jetzt den Spiegelcode */
 
-for (i=1; i<=map[0][0].name; i++) 
-  if (mark[i]) 
+for (k=0; k<*patchknz; k++) 
+  { i=patchliste[k];
     for (j=0; j<3; j++) 
       { if (map[i][j].mininame==aussen) map[i][j].dummy=infty;
         else map[i][j].dummy=0; }
+  }
 
 run=start; knotenzahl=*patchknz;
 
@@ -2533,7 +3142,7 @@ return;
                   Originalversion als auch fuer die gespiegelte
                   Version (Automorphismus existiert)              */
 
-int bauchbinde_reko(PLANMAP map,KNOTENTYP *code,KANTE *anfangskante)
+static int bauchbinde_reko(PLANMAP map,KNOTENTYP *code,KANTE *anfangskante)
 {
 int i,j,k, patchknz1, patchknz2, test, test2, test3, test4, returnwert;
 KANTE *run;
@@ -2549,11 +3158,10 @@ FLAECHENTYP c3, c11;
 c3=code[3]; c11=code[11];
 code[3]=code[11]=0;
 
-for (i=1; i<=map[0][0].name; i++) for (j=0;j<3; j++) { map[i][j].dummy=0;
-						       map[i][j].mininame=map[i][j].name; }
+reko_anfang(map,1);
 
 for (i=1, run=anfangskante->invers->prev; i<code[0]; i+=2)
-  { run->prev->mininame=aussen;
+  { REKO(run->prev)->mininame=aussen;
     run=run->invers->next->invers->prev; }
 
 reko_bb_code(map, code1, spiegelcode1, code[0], anfangskante->invers->next, ministart1, spiegelministart1, 
@@ -2561,8 +3169,8 @@ reko_bb_code(map, code1, spiegelcode1, code[0], anfangskante->invers->next, mini
 
 
 for (i=1, run=anfangskante->invers->prev; i<code[0]; i+=2)
-  { run->prev->mininame=run->prev->name;
-    run->invers->prev->mininame=aussen;
+  { REKO(run->prev)->mininame=run->prev->name;
+    REKO(run->invers->prev)->mininame=aussen;
     run=run->invers->next->invers->prev; }
 
 reko_bb_code(map, code2, spiegelcode2, code[0], anfangskante->next, ministart2, spiegelministart2, 
@@ -2676,7 +3284,7 @@ return(returnwert);
 
 /***********************SUCHESTART_REKO********************************/
 
-KANTE *suchestart_reko( KANTE *start, int *fuenfecke)
+static KANTE *suchestart_reko( KANTE *start, int *fuenfecke)
 /* belegt eine sequenz und sucht die kanonische Kante mit dem kleinsten Namen 
    arbeitet "invers", d.h. es wird als Innenrand gesehen, der gefuellt werden
    muss. Wird aufgerufen fuer Brille und Sandwich. Start muss eine Kante sein, die
@@ -2694,7 +3302,7 @@ char kan[7];
 
 
 
-while (start->next->invers->next->invers->next->mininame == aussen) 
+while (REKO(start->next->invers->next->invers->next)->mininame == aussen) 
                       start=start->next->invers->next->invers->next;
 /* Sucht 2 Kanten hintereinander nach aussen -- zu unterscheiden vom namen aussen, was 
    auch nach innen heissen kann. Duerfte nur fuer bauchbinden eine Endlosschleife sein */
@@ -2707,10 +3315,10 @@ seqkanten[0]=start;
 
 
 for (zaehler=1, run=start;
-     run->prev->invers->prev->invers->prev->mininame == aussen;
+     REKO(run->prev->invers->prev->invers->prev)->mininame == aussen;
      run=run->prev->invers->prev->invers->prev) zaehler++;
 sequenz[0]=zaehler; position=1; seqkanten[1]=nil;
-for (run=run->prev->invers->prev->invers->prev->invers->prev; run->mininame != aussen;
+for (run=run->prev->invers->prev->invers->prev->invers->prev; REKO(run)->mininame != aussen;
      run=run->invers->prev) 
 { sequenz[position]=0; position++; seqkanten[position]=nil; }
 /* naechste Kante vor nicht-0-sequenz suchen -- entsprechende innenkanten gibt es nicht
@@ -2721,10 +3329,10 @@ while (run != start)
 {
 seqkanten[position]=run;
 for (zaehler=1; 
-     run->prev->invers->prev->invers->prev->mininame == aussen;
+     REKO(run->prev->invers->prev->invers->prev)->mininame == aussen;
      run=run->prev->invers->prev->invers->prev) { zaehler++; }
 sequenz[position]=zaehler; position++; seqkanten[position]=nil;
-for (run=run->prev->invers->prev->invers->prev->invers->prev; run->mininame != aussen;
+for (run=run->prev->invers->prev->invers->prev->invers->prev; REKO(run)->mininame != aussen;
      run=run->invers->prev) 
 { sequenz[position]=0; position++; seqkanten[position]=nil; }
 }
@@ -2749,12 +3357,12 @@ for (i=0; sequenz[i] != leer; i++)
 
 for (i=0, run=nil; sequenz[i] != leer; i++)
   { if (kan[i])
-      if ((run==nil) || (seqkanten[i]->dummy < run->dummy)) run=seqkanten[i];
+      if ((run==nil) || (REKO(seqkanten[i])->dummy < REKO(run)->dummy)) run=seqkanten[i];
       /* dummy ersetzt ursprung */
   }
 
 /* Jetzt die vorige Innenkante suchen, um rechts davon dann einfuegen zu koennen */
-for (run=run->next->invers->next->invers->next; run->mininame != aussen; run=run->invers->next);
+for (run=run->next->invers->next->invers->next; REKO(run)->mininame != aussen; run=run->invers->next);
 
 
 return(run);
@@ -2767,13 +3375,13 @@ return(run);
    ausserdem setzt er fuer alle kanten, so dass diese flaeche links davon ist, dummy
    auf 1*/
 
-int checksize_and_mark( KANTE* edge)
+static int checksize_and_mark( KANTE* edge)
 {
 KANTE *run; 
 int zaehler=1;
 
-edge->noleft=1;
-for (run=edge->invers->next; run != edge; run=run->invers->next) {run->noleft=1; zaehler++;}
+REKO(edge)->noleft=1;
+for (run=edge->invers->next; run != edge; run=run->invers->next) {REKO(run)->noleft=1; zaehler++;}
 return(zaehler);
 }
 
@@ -2782,7 +3390,7 @@ return(zaehler);
 
 /**************************REKO_PATCH*****************************/
 
-void reko_patch(KANTE *anfang,KNOTENTYP code[],int fuenfecke)
+static void reko_patch(KANTE *anfang,KNOTENTYP code[],int fuenfecke)
 {
 int i, position, zaehler, z2;
 KANTE *run, *merke;
@@ -2803,9 +3411,9 @@ while (position<fuenfecke)
 					  if (position==fuenfecke) return; }
     zaehler++;
     merke=run->invers; run=run->prev; z2=1;
-    while ((merke != run) && (run->noleft) && (z2 <=6))
+    while ((merke != run) && (REKO(run)->noleft) && (z2 <=6))
       { run=run->invers->prev; z2++; }
-    if ((merke==run) && (run->noleft)) /* dann muss die letzte flaeche das letzte 5-eck sein */
+    if ((merke==run) && (REKO(run)->noleft)) /* dann muss die letzte flaeche das letzte 5-eck sein */
       { code[position]=zaehler; position++; 
 	if (position<fuenfecke)  
 		{ fprintf(stderr," ERROR in reko_patch ! Patch empty and missing 5-gon !\n"); exit(32); }
@@ -2824,43 +3432,42 @@ while (position<fuenfecke)
    1 zurueckgibt, wenn code < minimaler Code (wie bisher)
    2 zurueckgibt, wenn code== minimaler Code (Automorphismus existiert) */
 
-int brille_reko(PLANMAP map,KNOTENTYP *code,KANTE *anfangskante)
+static int brille_reko(PLANMAP map,KNOTENTYP *code,KANTE *anfangskante)
 {
-int i,j, l1, l2, l3, fuenfecke, vergleichsanfang, test;
+int i, l1, l2, l3, fuenfecke, vergleichsanfang, test;
 KANTE *run, *startkante1, *startkante2, *startkante3, *anfang;
 KNOTENTYP testcode[6];
 
 
 l1=code[2]; l3=code[3]; l2=code[0]-l1-l3;
 
-for (i=1; i<=map[0][0].name; i++) for (j=0;j<3; j++) { map[i][j].dummy=map[i][j].noleft=0;
-						       map[i][j].mininame=1; }
+reko_anfang(map,0);
 
 /* markieren der Brille: */
 
-anfangskante->mininame=anfangskante->noleft=anfangskante->invers->noleft=1;
-anfangskante->invers->mininame=l1;
+REKO(anfangskante)->mininame=REKO(anfangskante)->noleft=REKO(anfangskante->invers)->noleft=1;
+REKO(anfangskante->invers)->mininame=l1;
 
 for (i=1, run=anfangskante; i<code[0]; i++)
   { run=run->invers->prev; 
-    run->noleft=run->invers->noleft=1;
-    run->mininame=i+1;
-    run->dummy=run->prev->dummy=run->next->dummy=i;
-    run->invers->mininame=i;
-    if (i!=l1) run->prev->mininame=aussen;
+    REKO(run)->noleft=REKO(run->invers)->noleft=1;
+    REKO(run)->mininame=i+1;
+    REKO(run)->dummy=REKO(run->prev)->dummy=REKO(run->next)->dummy=i;
+    REKO(run->invers)->mininame=i;
+    if (i!=l1) REKO(run->prev)->mininame=aussen;
     i++;
     if (i<code[0])
       {
       run=run->invers->next;
-      run->noleft=run->invers->noleft=1;
-      run->dummy=run->prev->dummy=run->next->dummy=i;
-      run->mininame=i+1;
-      run->invers->mininame=i;
-      if (i!=l1) run->next->mininame=aussen;
+      REKO(run)->noleft=REKO(run->invers)->noleft=1;
+      REKO(run)->dummy=REKO(run->prev)->dummy=REKO(run->next)->dummy=i;
+      REKO(run)->mininame=i+1;
+      REKO(run->invers)->mininame=i;
+      if (i!=l1) REKO(run->next)->mininame=aussen;
       }
   }
 
-/*  reparieren: */ run->mininame=l1+l2;
+/*  reparieren: */ REKO(run)->mininame=l1+l2;
 
 if (l1%2) { startkante1=anfangskante->invers->next; 
 	    startkante2=anfangskante->invers->prev->invers->prev; }
@@ -2894,7 +3501,7 @@ return(1);
 
 /***********************SUCHESTART_REKO_SP********************************/
 
-KANTE *suchestart_reko_sp( KANTE *start, int *fuenfecke)
+static KANTE *suchestart_reko_sp( KANTE *start, int *fuenfecke)
 /* Wie suchestart_reko -- nur die spiegelversion */
 
 {
@@ -2907,7 +3514,7 @@ char kan[7];
 
 
 
-while (start->prev->invers->prev->invers->prev->mininame == aussen) 
+while (REKO(start->prev->invers->prev->invers->prev)->mininame == aussen) 
                       start=start->prev->invers->prev->invers->prev;
 /* Sucht 2 Kanten hintereinander nach aussen -- zu unterscheiden vom namen aussen, was 
    auch nach innen heissen kann. Duerfte nur fuer bauchbinden eine Endlosschleife sein */
@@ -2920,10 +3527,10 @@ seqkanten[0]=start;
 
 
 for (zaehler=1, run=start;
-     run->next->invers->next->invers->next->mininame == aussen;
+     REKO(run->next->invers->next->invers->next)->mininame == aussen;
      run=run->next->invers->next->invers->next) zaehler++;
 sequenz[0]=zaehler; position=1; seqkanten[1]=nil;
-for (run=run->next->invers->next->invers->next->invers->next; run->mininame != aussen;
+for (run=run->next->invers->next->invers->next->invers->next; REKO(run)->mininame != aussen;
      run=run->invers->next) 
 { sequenz[position]=0; position++; seqkanten[position]=nil; }
 /* naechste Kante vor nicht-0-sequenz suchen -- entsprechende innenkanten gibt es nicht
@@ -2934,10 +3541,10 @@ while (run != start)
 {
 seqkanten[position]=run;
 for (zaehler=1; 
-     run->next->invers->next->invers->next->mininame == aussen;
+     REKO(run->next->invers->next->invers->next)->mininame == aussen;
      run=run->next->invers->next->invers->next) { zaehler++; }
 sequenz[position]=zaehler; position++; seqkanten[position]=nil;
-for (run=run->next->invers->next->invers->next->invers->next; run->mininame != aussen;
+for (run=run->next->invers->next->invers->next->invers->next; REKO(run)->mininame != aussen;
      run=run->invers->next) 
 { sequenz[position]=0; position++; seqkanten[position]=nil; }
 }
@@ -2962,12 +3569,12 @@ for (i=0; sequenz[i] != leer; i++)
 
 for (i=0, run=nil; sequenz[i] != leer; i++)
   { if (kan[i])
-      if ((run==nil) || (seqkanten[i]->dummy < run->dummy)) run=seqkanten[i];
+      if ((run==nil) || (REKO(seqkanten[i])->dummy < REKO(run)->dummy)) run=seqkanten[i];
       /* dummy ersetzt ursprung */
   }
 
 /* Jetzt die vorige Innenkante suchen, um links (spiegel !!) davon dann einfuegen zu koennen */
-for (run=run->prev->invers->prev->invers->prev; run->mininame != aussen; run=run->invers->prev);
+for (run=run->prev->invers->prev->invers->prev; REKO(run)->mininame != aussen; run=run->invers->prev);
 
 return(run);
 
@@ -2979,13 +3586,13 @@ return(run);
    ausserdem setzt er fuer alle kanten, so dass diese flaeche rechts davon ist, 
    noright auf 1  */
 
-int checksize_and_mark_sp( KANTE* edge)
+static int checksize_and_mark_sp( KANTE* edge)
 {
 KANTE *run; 
 int zaehler=1;
 
-edge->noright=1;
-for (run=edge->invers->prev; run != edge; run=run->invers->prev) {run->noright=1; zaehler++;}
+REKO(edge)->noright=1;
+for (run=edge->invers->prev; run != edge; run=run->invers->prev) {REKO(run)->noright=1; zaehler++;}
 return(zaehler);
 }
 
@@ -2994,7 +3601,7 @@ return(zaehler);
 
 /**************************REKO_PATCH_SP*****************************/
 
-void reko_patch_sp(KANTE *anfang,KNOTENTYP code[],int fuenfecke)
+static void reko_patch_sp(KANTE *anfang,KNOTENTYP code[],int fuenfecke)
 {
 int i, position, zaehler, z2;
 KANTE *run, *merke;
@@ -3014,9 +3621,9 @@ while (position<fuenfecke)
 					     if (position==fuenfecke) return; }
     zaehler++;
     merke=run->invers; run=run->next; z2=1;
-    while ((merke != run) && (run->noright) && (z2 <=6))
+    while ((merke != run) && (REKO(run)->noright) && (z2 <=6))
       { run=run->invers->next; z2++; }
-    if ((merke==run) && (run->noright)) /* dann muss die letzte flaeche das letzte 5-eck sein */
+    if ((merke==run) && (REKO(run)->noright)) /* dann muss die letzte flaeche das letzte 5-eck sein */
       { code[position]=zaehler; position++; 
 	if (position<fuenfecke)  
 		{ fprintf(stderr," ERROR in reko_patch_sp ! Patch empty and missing 5-gon !\n"); exit(33); }
@@ -3036,9 +3643,9 @@ while (position<fuenfecke)
    1 zurueckgibt, wenn code < minimaler Code (wie bisher)
    2 zurueckgibt, wenn code== minimaler Code (Automorphismus existiert) */
 
-int brille_sp_reko(PLANMAP map,KNOTENTYP *code,KANTE *anfangskante)
+static int brille_sp_reko(PLANMAP map,KNOTENTYP *code,KANTE *anfangskante)
 {
-int i,j, l1, l2, l3, fuenfecke, vergleichsanfang, test;
+int i, l1, l2, l3, fuenfecke, vergleichsanfang, test;
 KANTE *run, *startkante1, *startkante2, *startkante3, *anfang;
 KNOTENTYP testcode[6];
 
@@ -3046,34 +3653,33 @@ KNOTENTYP testcode[6];
 
 l1=code[2]; l3=code[3]; l2=code[0]-l1-l3;
 
-for (i=1; i<=map[0][0].name; i++) for (j=0;j<3; j++) { map[i][j].dummy=map[i][j].noright=0;
-						       map[i][j].mininame=1; }
+reko_anfang(map,0);
 
 /* markieren der Brille: */
 
-anfangskante->mininame=anfangskante->noright=anfangskante->invers->noright=1;
-anfangskante->invers->mininame=l1;
+REKO(anfangskante)->mininame=REKO(anfangskante)->noright=REKO(anfangskante->invers)->noright=1;
+REKO(anfangskante->invers)->mininame=l1;
 
 for (i=1, run=anfangskante; i<code[0]; i++)
   { run=run->invers->next; 
-    run->noright=run->invers->noright=1;
-    run->mininame=i+1;
-    run->dummy=run->prev->dummy=run->next->dummy=i;
-    run->invers->mininame=i;
-    if (i!=l1) run->next->mininame=aussen;
+    REKO(run)->noright=REKO(run->invers)->noright=1;
+    REKO(run)->mininame=i+1;
+    REKO(run)->dummy=REKO(run->prev)->dummy=REKO(run->next)->dummy=i;
+    REKO(run->invers)->mininame=i;
+    if (i!=l1) REKO(run->next)->mininame=aussen;
     i++;
     if (i<code[0])
       {
       run=run->invers->prev;
-      run->noright=run->invers->noright=1;
-      run->dummy=run->prev->dummy=run->next->dummy=i;
-      run->mininame=i+1;
-      run->invers->mininame=i;
-      if (i!=l1) run->prev->mininame=aussen;
+      REKO(run)->noright=REKO(run->invers)->noright=1;
+      REKO(run)->dummy=REKO(run->prev)->dummy=REKO(run->next)->dummy=i;
+      REKO(run)->mininame=i+1;
+      REKO(run->invers)->mininame=i;
+      if (i!=l1) REKO(run->prev)->mininame=aussen;
       }
   }
 
-/*  reparieren: */ run->mininame=l1+l2;
+/*  reparieren: */ REKO(run)->mininame=l1+l2;
 
 if (l1%2) { startkante1=anfangskante->invers->prev; 
 	    startkante2=anfangskante->invers->next->invers->next; }
@@ -3118,9 +3724,9 @@ return(1);
    1 zurueckgibt, wenn code < minimaler Code (wie bisher)
    2 zurueckgibt, wenn code== minimaler Code (Automorphismus existiert) */
 
-int sandwich_reko(PLANMAP map,KNOTENTYP *code,KANTE *anfangskante)
+static int sandwich_reko(PLANMAP map,KNOTENTYP *code,KANTE *anfangskante)
 {
-int i,j, l1, l2, l1_p_l2, fuenfecke, vergleichsanfang, test;
+int i, l1, l2, l1_p_l2, fuenfecke, vergleichsanfang, test;
 KANTE *run, *startkante1, *startkante2, *startkante3, *anfang;
 KNOTENTYP testcode[6];
 
@@ -3128,34 +3734,33 @@ KNOTENTYP testcode[6];
 l1=code[2]; l2=code[3]; 
 l1_p_l2 = l1+l2;
 
-for (i=1; i<=map[0][0].name; i++) for (j=0;j<3; j++) { map[i][j].dummy=map[i][j].noleft=0;
-						       map[i][j].mininame=1; }
+reko_anfang(map,0);
 
 /* markieren der Brille: */
 
-anfangskante->mininame=anfangskante->noleft=anfangskante->invers->noleft=1;
-anfangskante->invers->mininame=l1_p_l2;
+REKO(anfangskante)->mininame=REKO(anfangskante)->noleft=REKO(anfangskante->invers)->noleft=1;
+REKO(anfangskante->invers)->mininame=l1_p_l2;
 
 for (i=1, run=anfangskante; i<code[0]; i++)
   { run=run->invers->prev; 
-    run->noleft=run->invers->noleft=1;
-    run->mininame=i+1;
-    run->dummy=run->prev->dummy=run->next->dummy=i;
-    run->invers->mininame=i;
-    if (i != l1_p_l2) run->prev->mininame=aussen;
+    REKO(run)->noleft=REKO(run->invers)->noleft=1;
+    REKO(run)->mininame=i+1;
+    REKO(run)->dummy=REKO(run->prev)->dummy=REKO(run->next)->dummy=i;
+    REKO(run->invers)->mininame=i;
+    if (i != l1_p_l2) REKO(run->prev)->mininame=aussen;
     i++;
     if (i<code[0])
       {
       run=run->invers->next;
-      run->noleft=run->invers->noleft=1;
-      run->dummy=run->prev->dummy=run->next->dummy=i;
-      run->mininame=i+1;
-      run->invers->mininame=i;
-      if (i != l1_p_l2) run->next->mininame=aussen;
+      REKO(run)->noleft=REKO(run->invers)->noleft=1;
+      REKO(run)->dummy=REKO(run->prev)->dummy=REKO(run->next)->dummy=i;
+      REKO(run)->mininame=i+1;
+      REKO(run->invers)->mininame=i;
+      if (i != l1_p_l2) REKO(run->next)->mininame=aussen;
       }
   }
 
-/*  reparieren: */ run->mininame=l1;
+/*  reparieren: */ REKO(run)->mininame=l1;
 
 /* l1 ist immer >= 3, also geht das folgende: */
 
@@ -3200,9 +3805,9 @@ return(1);
    1 zurueckgibt, wenn code < minimaler Code (wie bisher)
    2 zurueckgibt, wenn code== minimaler Code (Automorphismus existiert) */
 
-int sandwich_reko_sp(PLANMAP map,KNOTENTYP *code,KANTE *anfangskante)
+static int sandwich_reko_sp(PLANMAP map,KNOTENTYP *code,KANTE *anfangskante)
 {
-int i,j, l1, l2, l1_p_l2, fuenfecke, vergleichsanfang, test;
+int i, l1, l2, l1_p_l2, fuenfecke, vergleichsanfang, test;
 KANTE *run, *startkante1, *startkante2, *startkante3, *anfang;
 KNOTENTYP testcode[6];
 
@@ -3210,34 +3815,33 @@ KNOTENTYP testcode[6];
 l1=code[2]; l2=code[3]; 
 l1_p_l2 = l1+l2;
 
-for (i=1; i<=map[0][0].name; i++) for (j=0;j<3; j++) { map[i][j].dummy=map[i][j].noright=0;
-						       map[i][j].mininame=1; }
+reko_anfang(map,0);
 
 /* markieren der Brille: */
 
-anfangskante->mininame=anfangskante->noright=anfangskante->invers->noright=1;
-anfangskante->invers->mininame=l1_p_l2;
+REKO(anfangskante)->mininame=REKO(anfangskante)->noright=REKO(anfangskante->invers)->noright=1;
+REKO(anfangskante->invers)->mininame=l1_p_l2;
 
 for (i=1, run=anfangskante; i<code[0]; i++)
   { run=run->invers->next; 
-    run->noright=run->invers->noright=1;
-    run->mininame=i+1;
-    run->dummy=run->prev->dummy=run->next->dummy=i;
-    run->invers->mininame=i;
-    if (i != l1_p_l2) run->next->mininame=aussen;
+    REKO(run)->noright=REKO(run->invers)->noright=1;
+    REKO(run)->mininame=i+1;
+    REKO(run)->dummy=REKO(run->prev)->dummy=REKO(run->next)->dummy=i;
+    REKO(run->invers)->mininame=i;
+    if (i != l1_p_l2) REKO(run->next)->mininame=aussen;
     i++;
     if (i<code[0])
       {
       run=run->invers->prev;
-      run->noright=run->invers->noright=1;
-      run->dummy=run->prev->dummy=run->next->dummy=i;
-      run->mininame=i+1;
-      run->invers->mininame=i;
-      if (i != l1_p_l2) run->prev->mininame=aussen;
+      REKO(run)->noright=REKO(run->invers)->noright=1;
+      REKO(run)->dummy=REKO(run->prev)->dummy=REKO(run->next)->dummy=i;
+      REKO(run)->mininame=i+1;
+      REKO(run->invers)->mininame=i;
+      if (i != l1_p_l2) REKO(run->prev)->mininame=aussen;
       }
   }
 
-/*  reparieren: */ run->mininame=l1;
+/*  reparieren: */ REKO(run)->mininame=l1;
 
 /* l1 ist immer >= 3, also geht das folgende: */
 
@@ -3290,7 +3894,7 @@ return(1);
 
 /* Die folgende Prozedur enthaelt den Rekursionsschritt */
 
-void bilde_f_rek(KNOTENTYP *f, KANTE *k1, KANTE *k2) {
+static void bilde_f_rek(KNOTENTYP *f, KANTE *k1, KANTE *k2) {
   KNOTENTYP u;
   k1 = k1->invers->prev;
   k2 = k2->invers->prev;   /* k1 und k2 im Gleichschritt nach rechts */
@@ -3310,7 +3914,7 @@ void bilde_f_rek(KNOTENTYP *f, KANTE *k1, KANTE *k2) {
 
 /* Die folgende Prozedur enthaelt den Rekursionsanfang */
 
-void bilde_f(KNOTENTYP *f, KANTE *k1, KANTE *k2, KNOTENTYP anz) {
+static void bilde_f(KNOTENTYP *f, KANTE *k1, KANTE *k2, KNOTENTYP anz) {
   KNOTENTYP i;
   for (i=1; i<=anz; i++) {f[i] = 0;}   /* Funktionstabelle loeschen */
   f[k1->ursprung] = k2->ursprung;
@@ -3327,7 +3931,7 @@ void bilde_f(KNOTENTYP *f, KANTE *k1, KANTE *k2, KNOTENTYP anz) {
 
 /* Die folgende Prozedur enthaelt den Rekursionsschritt */
 
-void bilde_f_sp_rek(KNOTENTYP *f, KANTE *k1, KANTE *k2) {
+static void bilde_f_sp_rek(KNOTENTYP *f, KANTE *k1, KANTE *k2) {
   KNOTENTYP u;
   k1 = k1->invers->prev;
   k2 = k2->invers->next;   /* k1 und k2 spiegelverkehrt nach rechts und links */
@@ -3347,7 +3951,7 @@ void bilde_f_sp_rek(KNOTENTYP *f, KANTE *k1, KANTE *k2) {
 
 /* Die folgende Prozedur enthaelt den Rekursionsanfang */
 
-void bilde_f_sp(KNOTENTYP *f, KANTE *k1, KANTE *k2, KNOTENTYP anz) {
+static void bilde_f_sp(KNOTENTYP *f, KANTE *k1, KANTE *k2, KNOTENTYP anz) {
   KNOTENTYP i;
   for (i=1; i<=anz; i++) {f[i] = 0;}   /* Funktionstabelle loeschen */
   f[k1->ursprung] = k2->ursprung;
@@ -3373,7 +3977,7 @@ void bilde_f_sp(KNOTENTYP *f, KANTE *k1, KANTE *k2, KNOTENTYP anz) {
 
 /* Die folgende Prozedur enthaelt den Rekursionsschritt */
 
-BOOL bilde_f_und_g_sp_rek(KNOTENTYP *f, KNOTENTYP *g, KANTE *k1, KANTE *k2) {
+static BOOL bilde_f_und_g_sp_rek(KNOTENTYP *f, KNOTENTYP *g, KANTE *k1, KANTE *k2) {
   KNOTENTYP u,v;
   k1 = k1->invers->prev;
   k2 = k2->invers->next;   /* k1 und k2 spiegelverkehrt nach rechts und links */
@@ -3409,7 +4013,7 @@ BOOL bilde_f_und_g_sp_rek(KNOTENTYP *f, KNOTENTYP *g, KANTE *k1, KANTE *k2) {
 
 /* Die folgende Prozedur enthaelt den Rekursionsanfang */
 
-BOOL bilde_f_und_g_sp(KNOTENTYP *f, KNOTENTYP *g, KANTE *k1, KANTE *k2, KNOTENTYP anz) {
+static BOOL bilde_f_und_g_sp(KNOTENTYP *f, KNOTENTYP *g, KANTE *k1, KANTE *k2, KNOTENTYP anz) {
   KNOTENTYP i;
   for (i=1; i<=anz; i++) {f[i]=0; g[i]=0;}   /* Funktionstabellen loeschen */
   f[k1->ursprung] = k2->ursprung;
@@ -3430,7 +4034,7 @@ BOOL bilde_f_und_g_sp(KNOTENTYP *f, KNOTENTYP *g, KANTE *k1, KANTE *k2, KNOTENTY
 
 /* Die folgende Prozedur enthaelt den Rekursionsschritt */
 
-BOOL bilde_f_und_g_rek(KNOTENTYP *f, KNOTENTYP *g, KANTE *k1, KANTE *k2) {
+static BOOL bilde_f_und_g_rek(KNOTENTYP *f, KNOTENTYP *g, KANTE *k1, KANTE *k2) {
   KNOTENTYP u,v;
   k1 = k1->invers->prev;
   k2 = k2->invers->prev;   /* k1 und k2 im Gleichschritt nach rechts und links */
@@ -3466,7 +4070,7 @@ BOOL bilde_f_und_g_rek(KNOTENTYP *f, KNOTENTYP *g, KANTE *k1, KANTE *k2) {
 
 /* Die folgende Prozedur enthaelt den Rekursionsanfang */
 
-BOOL bilde_f_und_g(KNOTENTYP *f, KNOTENTYP *g, KANTE *k1, KANTE *k2, KNOTENTYP anz) {
+static BOOL bilde_f_und_g(KNOTENTYP *f, KNOTENTYP *g, KANTE *k1, KANTE *k2, KNOTENTYP anz) {
   KNOTENTYP i;
   for (i=1; i<=anz; i++) {f[i]=0; g[i]=0;}   /* Funktionstabellen loeschen */
   f[k1->ursprung] = k2->ursprung;
@@ -3477,9 +4081,88 @@ BOOL bilde_f_und_g(KNOTENTYP *f, KNOTENTYP *g, KANTE *k1, KANTE *k2, KNOTENTYP a
 }
 
 
+/************************SYMM_VORBEREITEN*******************************/
+
+static void symm_vorbereiten(void)
+/* Fuer die Option "symmonly": Ein Automorphismus, der ein 5-Eck festlaesst,
+   liegt in dessen Diedergruppe D5, der Stabilisator hat also eine Ordnung
+   d, die 10 teilt. Bei einer Gruppe der Ordnung o haben die Bahnen der
+   5-Ecke daher die Groessen o/d mit d|10 und d|o. Eine Klasse von 5-Ecken,
+   die nicht durch eine Invariante unterschieden werden, ist eine
+   Vereinigung von Bahnen -- ihre Groesse also eine Summe solcher Zahlen.
+   Diese Groessen (bis 12) werden fuer jede gewaehlte Gruppe als Bitmaske
+   gespeichert. Ist fuer eine Gruppe jede Groesse moeglich (Ordnung 1, 2
+   oder 10), kann symm_moeglich() nichts verwerfen. */
+{
+int i, j, k, o, bahn;
+int teiler[4]={1,2,5,10};
+
+symm_min_ordnung=INT_MAX;
+symm_klassentest=1;
+for (i=0; i<symm_len; i++)
+  { o=symm_ordnung[(int)symm[i]];
+    if (o<symm_min_ordnung) symm_min_ordnung=o;
+    symm_klassen[i]=1; /* die leere Summe */
+    for (j=0; j<4; j++)
+      if ((o%teiler[j]==0) && ((bahn=o/teiler[j])<=12))
+	for (k=bahn; k<=12; k++)
+	  if (symm_klassen[i] & (1<<(k-bahn))) symm_klassen[i] |= (1<<k);
+    if (symm_klassen[i]==(1<<13)-1) symm_klassentest=0;
+  }
+}
+
+/************************SYMM_MOEGLICH**********************************/
+
+static BOOL symm_moeglich(PLANMAP map)
+/* Prueft vor dem Ablaufen der Pfade in minitest(), ob die map eine der
+   gewaehlten Symmetrien haben kann: Die 5-Ecke werden nach der Zahl der
+   benachbarten 5-Ecke und der Zahl der 5-Eck-Kanten an den Nachbarflaechen
+   eingeteilt; fuer mindestens eine der Gruppen muessen alle Klassengroessen
+   moeglich sein (siehe symm_vorbereiten()). Die Marken werden wie in
+   minitest() nicht geloescht, sondern ueber eine Epoche ungueltig. */
+{
+static int fuenfeck[3*(N+1)];
+static int epoche=0;
+int i, j, k, groesse, alle;
+int invariante[12];
+KANTE *run, *nachbar;
+
+epoche++;
+if (epoche==INT_MAX)
+  { for (i=0; i<3*(N+1); i++) fuenfeck[i]=0;
+    epoche=1; }
+
+for (i=0; i<60; i++) fuenfeck[F_eck_kanten[i]-map[0]]=epoche;
+
+/* F_eck_kanten[5*i] bis F_eck_kanten[5*i+4] sind die Kanten des 5-Ecks i */
+for (i=0; i<12; i++)
+  { invariante[i]=0;
+    for (j=5*i; j<5*i+5; j++)
+      { nachbar=F_eck_kanten[j]->invers; /* links davon die Nachbarflaeche */
+	if (fuenfeck[nachbar-map[0]]==epoche) invariante[i]+=64; /* Nachbar ist 5-Eck */
+	run=nachbar;
+	do { if (fuenfeck[run->invers-map[0]]==epoche) invariante[i]++;
+	     run=run->invers->next; }
+	while (run!=nachbar);
+      }
+  }
+
+for (k=0; k<symm_len; k++)
+  { alle=1;
+    for (i=0; (i<12) && alle; i++)
+      { for (j=groesse=0; j<12; j++) if (invariante[j]==invariante[i]) groesse++;
+	if (!(symm_klassen[k] & (1<<groesse))) alle=0; }
+    if (alle) return(True);
+  }
+return(False);
+}
+
+
 /************************MINITEST***********TH***************************/
 
-int minitest(PLANMAP map, KNOTENTYP *code)
+#define KANTENMARKE(k) kantenmarke[(k)-map[0]]
+
+static int minitest(PLANMAP map, KNOTENTYP *code)
 
 /* WICHTIG: Bei der bauchbinde muss auch ueberprueft werden, ob sie wirklich
    minimal gebaut ist. Moeglich: Verdrehen und hinterher ist das Spiegelbild
@@ -3521,17 +4204,19 @@ int minitest(PLANMAP map, KNOTENTYP *code)
 
 {
 int i, j, ii, m_laenge, ms_laenge, knoten_auf_pfad;
-int l1, l2, l3, ll1, ll2, ll3, edgemark, middle, lower_border;
+int l1, l2, l3, ll1, ll2, ll3, middle, lower_border;
 KANTE *miniliste[120], *mini_spiegel[120];
 KANTE  *run, *start, *merke_1, *merke_2;
-long mark[N+1];
+static long mark[N+1];
+static int kantenmarke[3*(N+1)]; /* statt dummy -- Index wie bei KANTENMARKE */
+static int edgemark=1; /* laeuft ueber alle Aufrufe weiter, siehe unten */
 int zaehler, stelle_1, stelle_2, pfadlaenge;
 KNOTENTYP cpcode[20];
 int test, runzaehler;
 BOOL rekonstruiert;
 int minierg[120];          /* fuer Bauchbinden */
 
-rekonstruiert=0;
+rekonstruiert=0; minitest_stufe=0;
 if (code[1]==1) knoten_auf_pfad=code[0]; else knoten_auf_pfad=code[0]-1;
 /* die knoten auf dem Pfad sind immer mit 1..k_a_p nummeriert */
 
@@ -3539,12 +4224,17 @@ if (code[1]==1) knoten_auf_pfad=code[0]; else knoten_auf_pfad=code[0]-1;
 test=1;
 m_laenge=ms_laenge=0;
 
-for (i=1; i<=map[0][0].name; i++) { mark[i]=0;
-				    for(j=0;j<3;j++) 
-				      { run=map[i]+j;
-					run->dummy=run->mininame=0;
-				      }
-				  }
+/* Die Marken der Knoten (mark) und Kanten (kantenmarke) werden nicht fuer
+   jede map geloescht: edgemark zaehlt ueber alle Aufrufe weiter (auch ein
+   Aufruf, der mit return(0) endet, hat mit edgemark markiert -- daher
+   gleich zu Anfang erhoehen), so dass alte Eintraege immer kleiner sind.
+   Nur bevor 2*N*edgemark ueberlaufen koennte, wird geloescht und wieder
+   bei 1 angefangen. */
+edgemark++;
+if (edgemark > (INT_MAX/N-1)/2-121)
+  { for (i=0; i<=N; i++) mark[i]=0;
+    for (i=0; i<3*(N+1); i++) kantenmarke[i]=0;
+    edgemark=1; }
 
 
 l1=code[2];
@@ -3597,6 +4287,8 @@ else /* d.h. code[1]==3 -- also sandwich */
 
 
 if (!rekonstruiert) { return(0); }
+if (symm_vorab && symm_klassentest && !symm_moeglich(map)) { minitest_stufe=3; return(0); }
+minitest_stufe=1;
 
 
 /* Jetzt die Kanten markieren, bei denen man den Originalpfad rekonstruieren wuerde,
@@ -3635,8 +4327,6 @@ if (code[1]!=1)
 
 /* Jetzt ans konstruieren: */
 
-edgemark=1;
-
 for (i=0; i<60; i++) /* for ueber alle kanten, von denen links ein 5-Eck ist */
   { 
     start=F_eck_kanten[i];
@@ -3649,23 +4339,23 @@ for (i=0; i<60; i++) /* for ueber alle kanten, von denen links ein 5-Eck ist */
 	mark[start->ursprung]=middle;
 	runzaehler=middle-1;
 
-	start->dummy=start->invers->dummy=edgemark;
+	KANTENMARKE(start)=KANTENMARKE(start->invers)=edgemark;
 	run=start->prev;
-	run->dummy=run->invers->dummy=edgemark;
+	KANTENMARKE(run)=KANTENMARKE(run->invers)=edgemark;
 	run=run->invers->next;
 	pfadlaenge=2;
 
 	/* nach rechts laufen: */
-	while (run->dummy < edgemark) /* neue kante */
+	while (KANTENMARKE(run) < edgemark) /* neue kante */
 	  { mark[run->ursprung]=runzaehler; runzaehler--;
 	    pfadlaenge++;
-	    run->dummy=run->invers->dummy=edgemark;
+	    KANTENMARKE(run)=KANTENMARKE(run->invers)=edgemark;
 	    merke_1=run; /* letzte neue kante */
 	    run=run->invers->prev;
-	    if (run->dummy < edgemark)
+	    if (KANTENMARKE(run) < edgemark)
 	      { mark[run->ursprung]=runzaehler; runzaehler--; 
 		pfadlaenge++;
-		run->dummy=run->invers->dummy=edgemark;
+		KANTENMARKE(run)=KANTENMARKE(run->invers)=edgemark;
 		merke_1=run;
 		run=run->invers->next; }
 	  }
@@ -3678,16 +4368,16 @@ for (i=0; i<60; i++) /* for ueber alle kanten, von denen links ein 5-Eck ist */
 	                                      /* kann (z.b. bei bauchbinde) vor der schleife noetig
 						 sein */
 	merke_2=start;
-	while (run->dummy < edgemark) /* neue kante */
+	while (KANTENMARKE(run) < edgemark) /* neue kante */
 	  { mark[run->ursprung]=runzaehler; runzaehler++; 
 	    pfadlaenge++;
-	    run->dummy=run->invers->dummy=edgemark;
+	    KANTENMARKE(run)=KANTENMARKE(run->invers)=edgemark;
 	    merke_2=run; /* letzte neue kante */
 	    run=run->invers->next;
-	    if (run->dummy < edgemark)
+	    if (KANTENMARKE(run) < edgemark)
 	      { mark[run->ursprung]=runzaehler; runzaehler++; 
 		pfadlaenge++;
-		run->dummy=run->invers->dummy=edgemark;
+		KANTENMARKE(run)=KANTENMARKE(run->invers)=edgemark;
 		merke_2=run;
 		run=run->invers->prev; }
 	  }
@@ -3799,23 +4489,23 @@ if (code[1]!=1) /* fuer bauchbinden wurde in switch schon markiert */
 	mark[start->ursprung]=middle;
 	runzaehler=middle-1;
 
-	start->dummy=start->invers->dummy=edgemark;
+	KANTENMARKE(start)=KANTENMARKE(start->invers)=edgemark;
 	run=start->prev;
-	run->dummy=run->invers->dummy=edgemark;
+	KANTENMARKE(run)=KANTENMARKE(run->invers)=edgemark;
 	pfadlaenge=2;
 
 	/* nach links laufen: */
 	run=start->invers->prev;
-	while (run->dummy < edgemark) /* neue kante */
+	while (KANTENMARKE(run) < edgemark) /* neue kante */
 	  { mark[run->ursprung]=runzaehler; runzaehler--; 
 	    pfadlaenge++;
-	    run->dummy=run->invers->dummy=edgemark;
+	    KANTENMARKE(run)=KANTENMARKE(run->invers)=edgemark;
 	    merke_1=run; /* letzte neue kante */
 	    run=run->invers->next;
-	    if (run->dummy < edgemark)
+	    if (KANTENMARKE(run) < edgemark)
 	      { mark[run->ursprung]=runzaehler; runzaehler--; 
 		pfadlaenge++;
-		run->dummy=run->invers->dummy=edgemark;
+		KANTENMARKE(run)=KANTENMARKE(run->invers)=edgemark;
 		merke_1=run;
 		run=run->invers->prev; }
 	  }
@@ -3828,16 +4518,16 @@ if (code[1]!=1) /* fuer bauchbinden wurde in switch schon markiert */
 	                                      /* kann (z.b. bei bauchbinde) vor der schleife noetig
 						 sein */
 	merke_2=start->prev;
-	while (run->dummy < edgemark) /* neue kante */
+	while (KANTENMARKE(run) < edgemark) /* neue kante */
 	  { mark[run->ursprung]=runzaehler; runzaehler++; 
 	    pfadlaenge++;
-	    run->dummy=run->invers->dummy=edgemark;
+	    KANTENMARKE(run)=KANTENMARKE(run->invers)=edgemark;
 	    merke_2=run; /* letzte neue kante */
 	    run=run->invers->prev;
-	    if (run->dummy < edgemark)
+	    if (KANTENMARKE(run) < edgemark)
 	      { mark[run->ursprung]=runzaehler; runzaehler++;
 		pfadlaenge++;
-		run->dummy=run->invers->dummy=edgemark;
+		KANTENMARKE(run)=KANTENMARKE(run->invers)=edgemark;
 		merke_2=run;
 		run=run->invers->next; }
 	  }
@@ -3927,9 +4617,18 @@ if (code[1]!=1) /* fuer bauchbinden wurde in switch schon markiert */
 
 
 
+/* Bei Brillen und Sandwiches ist jeder Automorphismus ausser der Identitaet
+   unter den gefundenen gleichen Pfaden (siehe unten symm_ord) -- mit
+   "symmonly" braucht man nicht zu rekonstruieren, wenn das nicht reicht. */
+
+if (symm_vorab && (code[1]!=1) && (m_laenge+ms_laenge+1 < symm_min_ordnung))
+  { minitest_stufe=3; return(0); }
+
 /* TH:  ab hier ist alles massiv veraendert */
 /* Nun wird geprueft, ob der uebergebene Code der kleinstmoegliche ist. */
 
+minitest_stufe=2;
+
 if (code[1]==1) /* Bauchbinde */
   { i=0;
     while (i<m_laenge)
@@ -4902,7 +5601,7 @@ if (code[1]==1) {      /* Bauchbinde  (redundante if-Abfrage) */
 */
 
 
-int checksize_right_2( KANTE* edge)
+static int checksize_right_2( KANTE* edge)
 {
 KANTE *run; 
 int zaehler=1;
@@ -4925,7 +5624,7 @@ return(zaehler);
 */
 
 
-int checksize_2( KANTE* edge)
+static int checksize_2( KANTE* edge)
 {
 KANTE *run; 
 int zaehler=1;
@@ -4943,7 +5642,7 @@ return(zaehler);
 /*  Diese Funktion prueft, ob die Nummer "nr" im Array "symm" auftritt,
     wobei die ersten "symm_len" Arrayelemente belegt sind.               */
 
-BOOL vergleiche_symm(char nr) {
+static BOOL vergleiche_symm(char nr) {
   int i;
   for (i=0; i<symm_len; i++) {
     if (symm[i]==nr) {return(True);}
@@ -4952,61 +5651,104 @@ BOOL vergleiche_symm(char nr) {
 }
 
 
+/***********************WANDZEIT*****************************************/
+
+static double wandzeit(void)
+/* die vergangene Zeit (nicht die des Prozessors) in Sekunden */
+{
+struct timeval t;
+
+gettimeofday(&t,nil);
+return((double)t.tv_sec+t.tv_usec/1e6);
+}
+
+/***********************ZEIGE_FORTSCHRITT********************************/
+
+static void zeige_fortschritt(void)
+/* schreibt alle "fortschritt" Sekunden eine Zeile nach stderr */
+{
+double jetzt;
+long long int akzeptiert=0;
+int i;
+
+jetzt=wandzeit();
+if (jetzt<naechster_fortschritt) return;
+naechster_fortschritt=jetzt+fortschritt;
+
+for (i=20+(2*min_sechsecke); i<=20+(2*max_sechsecke); i+=2) akzeptiert+=graphenzahl[i];
+if (threads>1) fprintf(stderr,"thread %d: ",arbeiter_nummer);
+fprintf(stderr,"%.0f seconds, case %d: %lld maps, %lld fullerenes",
+	jetzt-fortschritt_start,aktueller_fall,geprueft,akzeptiert);
+if (threads>1) fprintf(stderr,", unit %lld",einheit_nummer);
+fprintf(stderr," \n");
+}
+
 /***********************TESTE_UND_SCHREIBE*******TH***********************/
 
 /* ueberprueft ein fertiges Fulleren, testet es auf Kanonizitaet und schreibt
    es gegebenenfalls auf */
 
-void teste_und_schreibe(PLANMAP map, KNOTENTYP *code)
+static void teste_und_schreibe(PLANMAP map, KNOTENTYP *code)
 { int erg;
 
+geprueft++;
+if (fortschritt && ((geprueft & 1023)==0)) zeige_fortschritt();
+
 (non_iso_graphenzahl[map[0][0].name])++;
-if ((erg=minitest(map,code))) { 
+erg=minitest(map,code);
+if (erg && symm_vorab && !vergleiche_symm(erg)) { erg=0; minitest_stufe=3; }
+if (erg) { 
   (graphenzahl[map[0][0].name])++;
-  if (symm_len==0 || vergleiche_symm(erg)) codiereplanar(map);
+  if (symm_len==0 || vergleiche_symm(erg)) codiereplanar(map,erg);
   (symm_anz[erg])++;                  /* fuer die Symmetriestatistik */  
 }
+else minitest_verworfen[minitest_stufe]++;
 
 }
 
 
 /***********************SUCHE_ITEM**************************************/
 
-ITEMLISTE *suche_item(KNOTENTYP *adresse)
+static PATCHITEM *suche_item(KNOTENTYP *adresse, PATCHITEM **ende)
+/* gibt das erste Item zur Adresse zurueck -- in *ende das Item hinter dem letzten */
 {
-int i, laenge;
-SEQUENZLISTE *sq;
+int i, laenge, kind;
+PATCHKNOTEN *sq;
 
 laenge=8-adresse[0];
+*ende=nil;
 
-sq=mapliste.sechser[adresse[1]];
+sq=patchknoten+patchkopf->wurzel[adresse[1]];
 
 for (i=2; i<laenge; i++)
   { if (sq->number_next <= adresse[i]) return(nil);
-    if (sq->next_level[adresse[i]]==nil) return(nil);
-    sq=sq->next_level[adresse[i]]; }
-return(sq->items);
+    kind=patchkinder[sq->kinder+adresse[i]];
+    if (kind<0) return(nil);
+    sq=patchknoten+kind; }
+*ende=patchitems+sq->erstes+sq->anzahl;
+return(patchitems+sq->erstes);
 }
 
 
 /***********************SUCHE_ITEM_BB**************************************/
 
-BBITEMLISTE *suche_item_bb(KNOTENTYP *adresse)
+static BBPATCHITEM *suche_item_bb(KNOTENTYP *adresse, BBPATCHITEM **ende)
+/* wie suche_item() */
 {
+BBFACH *fach;
 
-BBSEQUENZLISTE *sq;
-
-sq=bbliste.sechser[adresse[1]];
-
-if (sq->number_next <= adresse[2]) return(nil);
-return(sq->items[adresse[2]]);
+*ende=nil;
+if (patchkopf->bbanzahl[adresse[1]] <= adresse[2]) return(nil);
+fach=bbfaecher+patchkopf->bbanfang[adresse[1]]+adresse[2];
+*ende=bbpatchitems+fach->erstes+fach->anzahl;
+return(bbpatchitems+fach->erstes);
 }
 
 
 
 /*********************ADD_POLYGON_INVERS***********************************/
 
-void add_polygon_invers(int n, PLANMAP map, KANTE *start, KANTE **lastout)
+static void add_polygon_invers(int n, PLANMAP map, KANTE *start, KANTE **lastout)
 /* fuegt ein weiteres polygon einer Reihe an. Dabei ist n die groesse des polygons. 
    Angefuegt wird immer an start. Ueber lastout wird die letzte Aussenkante des 
    Polygons zurueckgegeben.
@@ -5117,7 +5859,7 @@ return;
 
 /***************************BAUE_KUPPE********************************/
 
-void baue_kuppe(PLANMAP map, int bblaenge, FLAECHENTYP code[], KANTE **anfang, int flaechenzahl)
+static void baue_kuppe(PLANMAP map, int bblaenge, FLAECHENTYP code[], KANTE **anfang, int flaechenzahl)
 {
 int i, puffer, codestelle, zaehler, flaechenzaehler;
 KANTE *run;
@@ -5188,6 +5930,28 @@ else /* d.h. untere Kuppe bauen */
 
 
 
+/*********************EINHEIT_NEHMEN****************************************/
+
+static BOOL einheit_nehmen(int *modulozaehler)
+/* entscheidet, ob die naechste Arbeitseinheit (ein Schleifendurchlauf, der
+   bei "mod" verteilt wird) von diesem Prozess bearbeitet werden soll.
+   Zuerst wird wie bei "mod" ausgewaehlt, bei "threads" wird dann unter den
+   ausgewaehlten Einheiten jede von genau einem Prozess bearbeitet.
+   Nach einem Abbruch (siehe fullgen.h) wird keine Einheit mehr bearbeitet. */
+{
+if (abbrechen) return 0;
+(*modulozaehler)++;
+if ((*modulozaehler)==mod) *modulozaehler=0;
+if (mod && ((*modulozaehler)!=0)) return 0;
+if (threads<=1) return 1;
+einheit_nummer++;
+if (einheit_nummer<meine_einheit) return 0;
+/* Die Einheit gehoert diesem Prozess -- gleich die naechste reservieren: */
+meine_einheit=__sync_fetch_and_add(naechste_einheit,1LL);
+return 1;
+}
+
+
 /*********************BAUCHBINDE****************************************/
 
 /* Der erste Fall der Fullerenkonstruktion: Fullerene mit Bauchbinde */
@@ -5212,17 +5976,20 @@ die man erhaelt, wenn man die Ringe nach oben verschiebt, kleiner ist. */
    gesamtcodelaenge: 19 stellen */
 
 
-void bauchbinde(int min_sechsecke, int max_sechsecke)
+static void bauchbinde(int min_sechsecke, int max_sechsecke)
 {
 int sechsecke, i, j, k, bblaenge, upper6gons, lower6gons;
 KNOTENTYP adresse[4];
 KANTE *anfang, *merkeanfang; /* eine kante auf dem Rand zum Anfangen */
 KANTE *run;
-PLANMAP map;
-BBITEMLISTE *upitem, *lowitem;
+KANTE (*map)[3];
+BBPATCHITEM *upitem, *lowitem, *upende, *lowende;
 KNOTENTYP code[20];
 int modulozaehler;
 
+aktueller_fall=1;
+map=neue_map();
+
 modulozaehler=rest;
 
 init_map(map);
@@ -5238,11 +6005,10 @@ for (bblaenge=minbbl; bblaenge <= maxbbl; bblaenge++)
     for (upper6gons=sechsecke, lower6gons=0; upper6gons >= lower6gons;
 	 upper6gons--, lower6gons++)
          { adresse[1]=upper6gons;
-	   for (upitem=suche_item_bb(adresse); upitem != nil;
-		upitem=upitem->next_item)
+	   for (upitem=suche_item_bb(adresse,&upende); upitem < upende; upitem++)
 	       { adresse[1]=lower6gons; merkeanfang=nil;
 		 for (k=0; k<8; k++) code[k+10]=upitem->code[k];
-		 for (lowitem=suche_item_bb(adresse); lowitem!=nil; lowitem=lowitem->next_item)
+		 for (lowitem=suche_item_bb(adresse,&lowende); lowitem < lowende; lowitem++)
 		   if ((lowitem->code[0]==0) && 
 		        ((upper6gons>lower6gons) || (codecmp(upitem->code+2,lowitem->code+2,6)>=0)))
 		     /* hier geht schon die minimalitaet ein: Wenn es einen 6-Eck-Ring gibt, kann der
@@ -5251,9 +6017,7 @@ for (bblaenge=minbbl; bblaenge <= maxbbl; bblaenge++)
 			Im Fall upper6gons==lower6gons,"(uppercode+2)<(lowercode+2)",aber upper6gons hat
 			einen 6-eck-ring, kann ein besserer code durch verschieben des ringes und vertauschen
 			von oben und unten gebaut werden  */
-		     { modulozaehler++;
-		       if (modulozaehler==mod) modulozaehler=0;
-		       if (!mod || (modulozaehler==0))
+		     { if (einheit_nehmen(&modulozaehler))
 			 { /* so dass nur gebaut wird, wenn auch ein passendes Unterteil gefunden wird
 			      und auch dann nur einmal: */
 			   if (merkeanfang==nil) { map[0][0].name=0;
@@ -5277,13 +6041,14 @@ for (bblaenge=minbbl; bblaenge <= maxbbl; bblaenge++)
 	       } /* ende for ueber upitems */
 	 } /* ende for ueber 6-Eckverteilung */
   } /* ende for ueber bauchbindenlaenge */
+free(map);
 } /* ende funktion */
 
 
 
 /***********************SUCHESTART********************************/
 
-KANTE *suchestart( KANTE *start)
+static KANTE *suchestart( KANTE *start)
 /* belegt eine sequenz und sucht die kanonische Kante mit dem kleinsten Namen 
    arbeitet "invers", d.h. es wird als Innenrand gesehen, der gefuellt werden
    muss. Wird aufgerufen fuer Brille und Sandwich. Start muss eine Kante sein, die
@@ -5368,7 +6133,7 @@ return(run);
    uebergeben werden l1 l3 und lgesamt. berechnet werden die
    sequenzen */
 
-void berechne_brillenadressen( int l1, int lg, int l3, KNOTENTYP *seg,
+static void berechne_brillenadressen( int l1, int lg, int l3, KNOTENTYP *seg,
 			      KNOTENTYP *se3 )
 {int l2, zaehler;
  int bogen1, bogen3; 
@@ -5449,7 +6214,7 @@ else /* d.h. "verbogene" Brille */
    auch das Spiegelbild behandelt wird, ist diese Festlegung moeglich,
    aber Achtung -- das ist wichtig fuer die kanonische Darstellung */
 
-void baue_brille(int pfadlaenge,int laenge_1,int laenge_3,PLANMAP map, 
+static void baue_brille(int pfadlaenge,int laenge_1,int laenge_3,PLANMAP map, 
 		 KANTE **anfang_1, KANTE **anfang_2, KANTE **anfang_3)
 {
 int stelle_2, knotenzahl, i;
@@ -5519,7 +6284,7 @@ if ((knotenzahl%2)==0)
 
 /*********************INSERT_PATCH*********************************/
 
-void insert_patch(PLANMAP map, KANTE *anfang, ITEMLISTE *item, int flaechenzahl, int fuenfecke)
+static void insert_patch(PLANMAP map, KANTE *anfang, PATCHITEM *item, int flaechenzahl, int fuenfecke)
 {
 
 FLAECHENTYP *code;
@@ -5542,7 +6307,7 @@ code=item->code;
 
 /**********************DELETE_PATCH**************************************/
 
-void delete_patch(PLANMAP map, KANTE *anfang, KNOTENTYP *adresse)
+static void delete_patch(PLANMAP map, KANTE *anfang, KNOTENTYP *adresse)
 {
 int sqlaenge, randlaenge, i, j, knotenverlust;
 KANTE *run;
@@ -5613,7 +6378,7 @@ gesamtcodelaenge:16
 
 
 
-void brille(int min_sechsecke, int max_sechsecke) 
+static void brille(int min_sechsecke, int max_sechsecke) 
 { 
 int knotenzahl, pfadlaenge, s1ps2; 
 int laenge_1, laenge_3; 
@@ -5621,13 +6386,16 @@ KNOTENTYP adresse_1[6], adresse_2[6],adresse_3[6];
 int sixgons_1, sixgons_2, sixgons_3; /* zur besseren lesbarkeit -- es koennte auch immer adresse_i[1] 
 					benutzt werden */
 KANTE *anfang_1, *anfang_2, *anfang_3; /* eine kanonische Kante auf dem Rand zum Anfangen */ 
-ITEMLISTE *item_1, *item_2, *item_3; 
+PATCHITEM *item_1, *item_2, *item_3, *ende_1, *ende_2, *ende_3;
 BOOL gebaut_1, gebaut_2, ipr_fault_item2; 
-PLANMAP map;
+KANTE (*map)[3];
 KNOTENTYP code[20];
 int j, czmerke_1, czmerke_2, czmerke_3;
 int modulozaehler;
 
+aktueller_fall=2;
+map=neue_map();
+
 modulozaehler=rest;
 
 knotenzahl= 20 + 2*max_sechsecke;
@@ -5650,7 +6418,7 @@ for (pfadlaenge=2*minbrillenglas+1; pfadlaenge <= knotenzahl+1; pfadlaenge++)
 	for (sixgons_1=0; sixgons_1 <= max_sechsecke; sixgons_1++) 
 	  /* auch hier kann man besser abschaetzen */ 	 
 	  { adresse_1[1]=sixgons_1;
-	    for (item_1=suche_item(adresse_1); item_1 != nil; item_1=item_1->next_item) 	 
+	    for (item_1=suche_item(adresse_1,&ende_1); item_1 < ende_1; item_1++) 	 
 	      { 
 		czmerke_1=4+adresse_1[0];
 		for (j=4; j<czmerke_1; j++) code[j]=item_1->code[j-4];
@@ -5658,9 +6426,7 @@ for (pfadlaenge=2*minbrillenglas+1; pfadlaenge <= knotenzahl+1; pfadlaenge++)
 		     (laenge_3 <= laenge_1) && (laenge_1+laenge_3 < pfadlaenge); laenge_3++)
 		 if (brillenglasmark[laenge_3])
  		 {
-		   modulozaehler++;
-		   if (modulozaehler==mod) modulozaehler=0;
-		   if (!mod || (modulozaehler==0))
+		   if (einheit_nehmen(&modulozaehler))
 		     {
 		       code[3]=laenge_3;
 		       berechne_brillenadressen(laenge_1,pfadlaenge,laenge_3,adresse_2,adresse_3);
@@ -5675,13 +6441,13 @@ for (pfadlaenge=2*minbrillenglas+1; pfadlaenge <= knotenzahl+1; pfadlaenge++)
 				sixgons_3--)
 			     {
 			       adresse_3[1]=sixgons_3;
-			       for (item_2=suche_item(adresse_2); item_2 != nil; item_2=item_2->next_item)
+			       for (item_2=suche_item(adresse_2,&ende_2); item_2 < ende_2; item_2++)
 				 { is_ipr=1; ipr_fault_item2=0;
 				   gebaut_2=0;
 				   czmerke_2=czmerke_1+adresse_2[0];
 				   for (j=czmerke_1; j<czmerke_2; j++) code[j]=item_2->code[j-czmerke_1];
-				   for (item_3=suche_item(adresse_3); (item_3 != nil) && (!ipr_fault_item2); 
-					item_3=item_3->next_item) 	  
+				   for (item_3=suche_item(adresse_3,&ende_3); (item_3 < ende_3) && (!ipr_fault_item2); 
+					item_3++) 	  
 				     { czmerke_3=czmerke_2+adresse_3[0];
 				       for (j=czmerke_2; j<czmerke_3; j++) code[j]=item_3->code[j-czmerke_2];
 				       if (gebaut_1==0) {
@@ -5712,12 +6478,13 @@ for (pfadlaenge=2*minbrillenglas+1; pfadlaenge <= knotenzahl+1; pfadlaenge++)
 	  } /* ende for ueber sixgons_1 */
       } /* ende for ueber laenge_1 */ 
   } /* ende for ueber pfadlaenge */
- } /* ende funktion */
+free(map);
+} /* ende funktion */
 
 
 /*********************BERECHNE_ADRESSE3********************************/
 
-void berechne_adresse3(int l1, int l3, KNOTENTYP adresse[]) 
+static void berechne_adresse3(int l1, int l3, KNOTENTYP adresse[]) 
 {
 int sl1, sl3;
 
@@ -5751,7 +6518,7 @@ else { sl1=(l1-2)/2;
 
 /*********************BAUE_SANDWICH***********************************/
 
-void baue_sandwich(PLANMAP map, int laenge_1, int laenge_2, int laenge_3,
+static void baue_sandwich(PLANMAP map, int laenge_1, int laenge_2, int laenge_3,
 		   KANTE **anfang_1, KANTE **anfang_2, KANTE **anfang_3) 
 
 { int stelle_2, knotenzahl, i, stelle, pfadlaenge; 
@@ -5861,7 +6628,7 @@ gesamtcodelaenge:16
 
 
 
-void sandwich (int min_sechsecke, int max_sechsecke)
+static void sandwich (int min_sechsecke, int max_sechsecke)
 
 { 
 int knotenzahl, maxpfadlaenge, s1ps2; 
@@ -5872,14 +6639,17 @@ int sixgons_1, sixgons_2, sixgons_3; /* zur besseren lesbarkeit -- es koennte au
 					die Anzahl der 6-Ecke zwischen l1 und l2. s_2 zwischen
 					l2 und l3 und s_3..... analog fuer adresse und item */ 
 KANTE *anfang_1, *anfang_2, *anfang_3; /* eine kanonische Kante auf dem Rand zum Anfangen */ 
-ITEMLISTE *item_1, *item_2, *item_3; 
+PATCHITEM *item_1, *item_2, *item_3, *ende_1, *ende_2, *ende_3;
 int randl_p1, randl_p2, randl_p3; 
 BOOL gebaut_1, gebaut_2, ipr_fault_item2; 
-PLANMAP map;
+KANTE (*map)[3];
 KNOTENTYP code[20];
 int j, czmerke_1, czmerke_2, czmerke_3;
 int modulozaehler;
 
+aktueller_fall=3;
+map=neue_map();
+
 modulozaehler=rest;
 /* l1--l2  und  l2--l3  bilden je ein brillenglas */
 
@@ -5901,11 +6671,9 @@ for (laenge_1=(min_2_3_4 /2); laenge_1 <= maxpfadlaenge-minbrillenglas; laenge_1
  	for (sixgons_1=0; sixgons_1 <= max_sechsecke; sixgons_1++)
  	 { 	
 	   adresse_1[1]=sixgons_1;
-	   for (item_1=suche_item(adresse_1); item_1 != nil; item_1=item_1->next_item)
+	   for (item_1=suche_item(adresse_1,&ende_1); item_1 < ende_1; item_1++)
 	     { 	
-	       modulozaehler++;
-	       if (modulozaehler==mod) modulozaehler=0;
-	       if (!mod || (modulozaehler==0))
+	       if (einheit_nehmen(&modulozaehler))
 		 {
 		   czmerke_1=4+adresse_1[0];
 		   for (j=4; j<czmerke_1; j++) code[j]=item_1->code[j-4];
@@ -5926,13 +6694,13 @@ for (laenge_1=(min_2_3_4 /2); laenge_1 <= maxpfadlaenge-minbrillenglas; laenge_1
 				    sixgons_3--)
 				 { 
 				   adresse_3[1]=sixgons_3;
-				   for (item_2=suche_item(adresse_2); item_2 != nil; item_2=item_2->next_item)
+				   for (item_2=suche_item(adresse_2,&ende_2); item_2 < ende_2; item_2++)
 				     { is_ipr=1; ipr_fault_item2=0;
 				       gebaut_2=0;
 				       czmerke_2=czmerke_1+adresse_2[0];
 				       for (j=czmerke_1; j<czmerke_2; j++) code[j]=item_2->code[j-czmerke_1];
-				       for (item_3=suche_item(adresse_3); (item_3 != nil) && (!ipr_fault_item2); 
-					    item_3=item_3->next_item)
+				       for (item_3=suche_item(adresse_3,&ende_3); (item_3 < ende_3) && (!ipr_fault_item2); 
+					    item_3++)
 					 {
 					   czmerke_3=czmerke_2+adresse_3[0];
 					   for (j=czmerke_2; j<czmerke_3; j++) code[j]=item_3->code[j-czmerke_2];
@@ -5970,19 +6738,355 @@ for (laenge_1=(min_2_3_4 /2); laenge_1 <= maxpfadlaenge-minbrillenglas; laenge_1
   } /* ende for ueber laenge_2; */
 } /* ende for ueber laenge_1 */
 
+free(map);
 } /* ende funktion */
 
 
-/**************************MAIN*********************************************/
+/*********************HILFSDATEINAME***************************************/
 
-int main(int argc, char *argv[])
+static void hilfsdateiname(char *name, int arbeiter, int nummer)
+/* Name der Datei, in die Prozess "arbeiter" bei "threads" die Ausgabe
+   schreibt, die sonst nach fil[nummer] (nummer 0: stdout, N+1 bis N+3:
+   No_spiral, No_pentagon_spiral, No_hexagon_spiral) gehen wuerde. */
+{
+sprintf(name,"Full_gen_tmp_%d_%d_%d",thread_kennung,arbeiter,nummer);
+}
+
+/*********************ARBEITER_VORBEREITEN*********************************/
+
+static void arbeiter_vorbereiten(int arbeiter)
+/* leitet alle Ausgaben eines abgespaltenen Prozesses in eigene Dateien um */
+{
+int i;
+char name[filenamenlaenge];
+
+for (i=20+(2*min_sechsecke); i<=knotenzahl; i+=2)
+  if ((fil[i]!=nil) && (fil[i]!=stdout))
+    { fclose(fil[i]);
+      hilfsdateiname(name,arbeiter,i);
+      fil[i]=fopen(name,"wb");
+      if (fil[i]==nil) { fprintf(stderr,"Can not open file %s. \n",name); exit(125); }
+      puffere_ausgabe(fil[i],i);
+    }
+hilfsdateiname(name,arbeiter,0);
+if (freopen(name,"wb",stdout)==nil) { fprintf(stderr,"Can not open file %s. \n",name); exit(125); }
+puffere_ausgabe(stdout,0);
+schliesse_ohne_spirale();
+hilfsdateiname(no_spiral_filename,arbeiter,N+1);
+hilfsdateiname(no_penta_spiral_filename,arbeiter,N+2);
+hilfsdateiname(no_hexa_spiral_filename,arbeiter,N+3);
+}
 
-{ int sechsecke, i, puffer, do_case;
+/*********************ZUSAMMENFUEGEN***************************************/
+
+static void zusammenfuegen(FILE **ziel, char *zielname, int nummer)
+/* haengt die Dateien der Prozesse fuer fil[nummer] an *ziel an und loescht
+   sie. Ist *ziel nil, wird zielname erst geoeffnet, wenn es etwas zu
+   schreiben gibt. Jeder Prozess hat seinen eigenen Header (">>...<<")
+   geschrieben -- nur der erste bleibt stehen. */
+{
+int arbeiter;
+size_t n, anfang;
+BOOL erste=1;
+FILE *f;
+char name[filenamenlaenge], puffer[1<<16];
+
+for (arbeiter=0; arbeiter<threads; arbeiter++)
+  { hilfsdateiname(name,arbeiter,nummer);
+    f=fopen(name,"rb");
+    if (f==nil) continue;
+    n=fread(puffer,1,sizeof(puffer),f);
+    if (n>0)
+      { anfang=0;
+	if (!erste && (n>=2) && (puffer[0]=='>') && (puffer[1]=='>'))
+	  { for (anfang=2; (anfang+1<n) && !((puffer[anfang]=='<') && (puffer[anfang+1]=='<')); anfang++)
+	      ;
+	    anfang+=2;
+	    if ((anfang<n) && (puffer[anfang]=='\n')) anfang++; /* code 6 */ }
+	if (*ziel==nil)
+	  { *ziel=fopen(zielname,"wb");
+	    if (*ziel==nil) { fprintf(stderr,"Can not open file %s. \n",zielname); exit(125); } }
+	erste=0;
+	fwrite(puffer+anfang,1,n-anfang,*ziel);
+	while ((n=fread(puffer,1,sizeof(puffer),f))>0) fwrite(puffer,1,n,*ziel);
+      }
+    fclose(f);
+    remove(name);
+  }
+}
+
+/*********************PARALLEL_GENERIEREN**********************************/
+
+static void parallel_generieren(int min_sechsecke, int max_sechsecke)
+/* erledigt die drei Faelle mit "threads" Prozessen und fuegt danach
+   Zaehler und Ausgaben zusammen */
+{
+int arbeiter, i, j, status, fehler=0;
+pid_t pid;
+void *speicher;
+FILE *ziel;
+char name[filenamenlaenge];
+ZAEHLER *z;
+
+speicher=mmap(nil,sizeof(long long int)+threads*sizeof(ZAEHLER),PROT_READ|PROT_WRITE,
+	      MAP_SHARED|MAP_ANONYMOUS,-1,0);
+if (speicher==MAP_FAILED) { fprintf(stderr,"Can not get shared memory for the threads. \n"); exit(123); }
+naechste_einheit=(long long int *)speicher;
+thread_zaehler=(ZAEHLER *)(naechste_einheit+1);
+*naechste_einheit=threads; /* die Einheiten 0..threads-1 sind schon vergeben */
+
+fflush(nil);
+for (arbeiter=0; arbeiter<threads; arbeiter++)
+  { pid=fork();
+    if (pid<0) { fprintf(stderr,"Can not start thread %d. \n",arbeiter); exit(124); }
+    if (pid==0)
+      { meine_einheit=arbeiter; arbeiter_nummer=arbeiter;
+	arbeiter_vorbereiten(arbeiter);
+	if (do_bauchbinde) bauchbinde(min_sechsecke,max_sechsecke);
+	if (do_brille) brille(min_sechsecke,max_sechsecke);
+	if (do_sandwich) sandwich(min_sechsecke,max_sechsecke);
+	z=thread_zaehler+arbeiter;
+	for (i=0; i<=N; i++)
+	  { z->graphenzahl[i]=graphenzahl[i]; z->non_iso_graphenzahl[i]=non_iso_graphenzahl[i]; }
+	for (i=0; i<29; i++) z->symm_anz[i]=symm_anz[i];
+	for (i=0; i<=12*S+120; i++) z->spiralnumbers[i]=spiralnumbers[i];
+	z->no_penta_spiral=no_penta_spiral; z->no_hexa_spiral=no_hexa_spiral;
+	z->spiralversuche=spiralversuche;
+	for (i=0; i<4; i++) z->minitest_verworfen[i]=minitest_verworfen[i];
+#ifndef NOTIMES
+	z->spiralzeit=spiralzeit;
+#endif
+	if (codenumber==3) /* der Hauptprozess mischt die Laeufe aller Prozesse */
+	  for (i=20+(2*min_sechsecke); i<=knotenzahl; i+=2)
+	    { if (codeliste[i].anzahl) schreibe_lauf(i);
+	      z->laeufe[i]=codeliste[i].laeufe; }
+	for (i=20+(2*min_sechsecke); i<=knotenzahl; i+=2)
+	  if ((fil[i]!=nil) && (fil[i]!=stdout) && fclose(fil[i])) exit(125);
+	schliesse_ohne_spirale();
+	if (fclose(stdout)) exit(125);
+	exit(0);
+      }
+  }
+
+for (arbeiter=0; arbeiter<threads; arbeiter++)
+  { if (wait(&status)<0) { fehler=126; break; }
+    if (!WIFEXITED(status)) fehler=126;
+    else if (WEXITSTATUS(status) && !fehler) fehler=WEXITSTATUS(status);
+  }
+
+if (fehler)
+  { fprintf(stderr,"A thread of the generation failed. \n");
+    for (arbeiter=0; arbeiter<threads; arbeiter++)
+      for (i=0; i<=N+3; i++) { hilfsdateiname(name,arbeiter,i); remove(name); }
+    exit(fehler);
+  }
+
+for (arbeiter=0; arbeiter<threads; arbeiter++)
+  { z=thread_zaehler+arbeiter;
+    for (i=0; i<=N; i++)
+      { graphenzahl[i]+=z->graphenzahl[i]; non_iso_graphenzahl[i]+=z->non_iso_graphenzahl[i]; }
+    for (j=0; j<29; j++) symm_anz[j]+=z->symm_anz[j];
+    for (j=0; j<=12*S+120; j++) spiralnumbers[j]+=z->spiralnumbers[j];
+    no_penta_spiral+=z->no_penta_spiral; no_hexa_spiral+=z->no_hexa_spiral;
+    spiralversuche+=z->spiralversuche;
+    for (j=0; j<4; j++) minitest_verworfen[j]+=z->minitest_verworfen[j];
+#ifndef NOTIMES
+    spiralzeit+=z->spiralzeit;
+#endif
+  }
+
+if (codenumber==3)
+  { thread_laeufe=(int *)malloc(threads*(N+1)*sizeof(int));
+    if (thread_laeufe==nil) { fprintf(stderr,"Can not get memory for the threads. \n"); exit(123); }
+    for (arbeiter=0; arbeiter<threads; arbeiter++)
+      for (i=0; i<=N; i++) thread_laeufe[arbeiter*(N+1)+i]=thread_zaehler[arbeiter].laeufe[i];
+  }
+
+for (i=20+(2*min_sechsecke); i<=knotenzahl; i+=2)
+  if ((fil[i]!=nil) && (fil[i]!=stdout)) zusammenfuegen(fil+i,nil,i);
+ziel=stdout; zusammenfuegen(&ziel,nil,0);
+ziel=nil; zusammenfuegen(&ziel,no_spiral_filename,N+1); if (ziel!=nil) fclose(ziel);
+ziel=nil; zusammenfuegen(&ziel,no_penta_spiral_filename,N+2); if (ziel!=nil) fclose(ziel);
+ziel=nil; zusammenfuegen(&ziel,no_hexa_spiral_filename,N+3); if (ziel!=nil) fclose(ziel);
+
+munmap(speicher,sizeof(long long int)+threads*sizeof(ZAEHLER));
+}
+
+
+/*********************SCHLIESSE_CODEDATEIEN********************************/
+
+static void schliesse_codedateien(void)
+{
+int i;
+
+for (i=20+(2*min_sechsecke); i<=knotenzahl; i+=2)
+  if ((fil[i]!=nil) && (fil[i]!=stdout))
+    { if (fclose(fil[i])) { fprintf(stderr,"Can not write the codes with %d vertices. \n",i); exit(133); }
+      fil[i]=nil; }
+}
+
+/*********************SCHREIBE_ZAHL_LE*************************************/
+
+static void schreibe_zahl_le(unsigned long long zahl, int bytes, FILE *f)
+/* schreibt zahl mit bytes Bytes, das niedrigste zuerst */
+{
+for ( ; bytes>0; bytes--) { putc((int)(zahl&0xFF),f); zahl>>=8; }
+}
+
+/*********************SCHREIBE_CONTAINER***********************************/
+
+static void schreibe_container(void)
+/* schreibt die Codes aller Knotenzahlen, die mit "container" in den
+   Hilfsdateien fil[i] stehen, in die eine Datei containername: "FGC1", die
+   Anzahl k der Knotenzahlen (4 Bytes), dann k Eintraege aus Knotenzahl (4
+   Bytes), Anfang und Laenge ihres Abschnitts in der Datei (je 8 Bytes) und
+   danach die Abschnitte. Jeder Abschnitt ist genau das, was ohne
+   "container" in Full_codes_x bzw. Spiral_codes_x stuende. Alle Zahlen
+   sind little endian. */
+{
+int i, k=0;
+unsigned long long anfang, laenge[N+1];
+size_t n;
+FILE *ziel;
+char puffer[1<<16];
+
+for (i=20+(2*min_sechsecke); i<=knotenzahl; i+=2)
+  { if (fflush(fil[i])) { fprintf(stderr,"Can not write the codes with %d vertices. \n",i); exit(133); }
+    laenge[i]=(unsigned long long)ftello(fil[i]);
+    k++; }
+
+ziel=fopen(containername,"wb");
+if (ziel==nil) { fprintf(stderr,"Can not open file %s. \n",containername); exit(133); }
+puffere_ausgabe(ziel,N+1);
+
+fputs("FGC1",ziel);
+schreibe_zahl_le(k,4,ziel);
+anfang=8+20*(unsigned long long)k;
+for (i=20+(2*min_sechsecke); i<=knotenzahl; i+=2)
+  { schreibe_zahl_le(i,4,ziel); schreibe_zahl_le(anfang,8,ziel); schreibe_zahl_le(laenge[i],8,ziel);
+    anfang+=laenge[i]; }
+
+for (i=20+(2*min_sechsecke); i<=knotenzahl; i+=2)
+  { rewind(fil[i]);
+    while ((n=fread(puffer,1,sizeof(puffer),fil[i]))>0) fwrite(puffer,1,n,ziel);
+    fclose(fil[i]); fil[i]=nil; }
+
+if (fclose(ziel)) { fprintf(stderr,"Can not write file %s. \n",containername); exit(133); }
+}
+
+/*********************CPUZEIT*********************************************/
+
+static double cpuzeit(void)
+/* die Prozessorzeit dieses Prozesses und seiner beendeten Kinder in
+   Sekunden */
+{
+#ifndef NOTIMES
+struct tms t;
+
+times(&t);
+return((double)(t.tms_utime+t.tms_stime+t.tms_cutime+t.tms_cstime)/time_factor);
+#else
+return(0.0);
+#endif //NOTIMES
+}
+
+/*********************PHASE_ENDE******************************************/
+
+static void phase_ende(char *name)
+/* traegt fuer "stats" eine Phase mit der Zeit seit dem Ende der vorigen ein */
+{
+double wand, cpu;
+
+wand=wandzeit(); cpu=cpuzeit();
+if (phasenzahl<8)
+  { strncpy(phasen[phasenzahl].name,name,sizeof(phasen[0].name)-1);
+    phasen[phasenzahl].wand=wand-phase_wand;
+    phasen[phasenzahl].cpu=cpu-phase_cpu;
+    phasenzahl++; }
+phase_wand=wand; phase_cpu=cpu;
+}
+
+/*********************SCHREIBE_STATS**************************************/
+
+static void schreibe_stats(void)
+/* schreibt Zeiten und Zaehler des Laufs als JSON nach statsdateiname */
+{
+FILE *f;
+int i, j;
+long long int erzeugt=0, akzeptiert=0;
+double wand=0.0, cpu=0.0;
+char name[4];
+
+f=fopen(statsdateiname,"w");
+if (f==nil) { fprintf(stderr,"Can not open file %s. \n",statsdateiname); exit(135); }
+
+fprintf(f,"{\n  \"min_vertices\": %d,\n  \"max_vertices\": %d,\n  \"ipr\": %d,\n  \"threads\": %d,\n",
+	20+(2*min_sechsecke),20+(2*max_sechsecke),IPR,threads);
+
+fprintf(f,"  \"phases\": [");
+for (i=0; i<phasenzahl; i++)
+  { fprintf(f,"%s\n    {\"name\": \"%s\", \"wall\": %.3f, \"cpu\": %.3f}",i ? "," : "",
+	    phasen[i].name,phasen[i].wand,phasen[i].cpu);
+    wand+=phasen[i].wand; cpu+=phasen[i].cpu; }
+fprintf(f,"\n  ],\n  \"total\": {\"wall\": %.3f, \"cpu\": %.3f},\n",wand,cpu);
+
+fprintf(f,"  \"vertex_counts\": [");
+for (i=20+(2*min_sechsecke); i<=20+(2*max_sechsecke); i+=2)
+  { fprintf(f,"%s\n    {\"vertices\": %d, \"generated\": %lld, \"accepted\": %lld}",
+	    (i==20+(2*min_sechsecke)) ? "" : ",",i,non_iso_graphenzahl[i],graphenzahl[i]);
+    erzeugt+=non_iso_graphenzahl[i]; akzeptiert+=graphenzahl[i]; }
+fprintf(f,"\n  ],\n");
+
+fprintf(f,"  \"minitest\": {\"calls\": %lld, \"accepted\": %lld, \"rejection_rate\": %.6f,\n",
+	erzeugt,akzeptiert,erzeugt ? (double)(erzeugt-akzeptiert)/erzeugt : 0.0);
+fprintf(f,"    \"rejected_no_pentagon_path\": %lld, \"rejected_smaller_path\": %lld, \"rejected_reconstruction\": %lld,\n",
+	minitest_verworfen[0],minitest_verworfen[1],minitest_verworfen[2]);
+fprintf(f,"    \"rejected_symmetry\": %lld},\n",minitest_verworfen[3]);
+
+fprintf(f,"  \"patches\": {\"read_from_file\": %d, \"maplist_patches\": %d, \"bblist_items\": %d, \"bblist_patches\": %d",
+	patches_gelesen,mapliste.total_maps,bbliste.total_items,bbliste.total_maps);
+if (patchkopf!=nil)
+  fprintf(f,",\n    \"nodes\": %d, \"items\": %d, \"bb_items\": %d, \"bytes\": %lld",
+	  patchkopf->anzahl_knoten,patchkopf->anzahl_items,patchkopf->anzahl_bbitems,patchkopf->groesse);
+fprintf(f,"},\n");
+
+fprintf(f,"  \"spirals\": {\"developments\": %lld",spiralversuche);
+#ifndef NOTIMES
+fprintf(f,", \"cpu\": %.3f",(double)spiralzeit/CLOCKS_PER_SEC);
+#endif //NOTIMES
+if (spiralcheck) fprintf(f,", \"no_pentagon_spiral\": %d",no_penta_spiral);
+if (hexspi) fprintf(f,", \"no_hexagon_spiral\": %d",no_hexa_spiral);
+if (spistat)
+  { fprintf(f,",\n    \"spiral_numbers\": {");
+    for (i=0, j=0; i<=12*max_sechsecke+120; i++)
+      if (spiralnumbers[i]) { fprintf(f,"%s\"%d\": %d",j ? ", " : "",i,spiralnumbers[i]); j=1; }
+    fprintf(f,"}"); }
+fprintf(f,"}");
+
+if (symstat)
+  { fprintf(f,",\n  \"symmetries\": {");
+    for (i=1, j=0; i<=28; i++)
+      if (symm_anz[i]>0)
+	{ strncpy(name,symm_name[i],3); name[3]=0;
+	  if (name[2]==' ') name[2]=0;
+	  if (name[1]==' ') name[1]=0;
+	  fprintf(f,"%s\"%s\": %d",j ? ", " : "",name,symm_anz[i]); j=1; }
+    fprintf(f,"}"); }
+fprintf(f,"\n}\n");
+
+if (fclose(f)) { fprintf(stderr,"Can not write file %s. \n",statsdateiname); exit(135); }
+}
+
+/**************************FULLGEN_RUN*************************************/
+
+int fullgen_run(int argc, char *argv[])
+/* das eigentliche Programm -- main() ruft nur das auf */
+
+{ static BOOL schon_gelaufen=0;
+  int sechsecke, i, puffer, do_case;
   char strpuf[filenamenlaenge], strpuf2[filenamenlaenge], strdummy[filenamenlaenge+3];
   struct stat buf;
   char name[4];     /* TH - fuer die Option "symm" */
-  FLAECHENTYP dummycode[12]={UCHAR_MAX,UCHAR_MAX,UCHAR_MAX,0,0,0,0,0,0,0,0,0}; 
-  FLAECHENTYP *dummypointer;
 
 #ifndef NOTIMES
   clock_t savetime=0, buffertime;
@@ -6000,8 +7104,15 @@ exit(0);
 #endif
 #endif
 
+/* Die Zaehler und Optionen werden nur beim Start des Programms
+   initialisiert, also darf es nur einen Lauf je Prozess geben. */
+if (schon_gelaufen)
+  { fprintf(stderr,"fullgen_run() can only be called once in a process. \n"); exit(137); }
+schon_gelaufen=1;
 
 for (i=1;i<=N;i++) graphenzahl[i]=non_iso_graphenzahl[i]=0;
+thread_kennung=getpid();
+fortschritt_start=phase_wand=wandzeit(); phase_cpu=cpuzeit();
 
 do_brille=do_sandwich=do_bauchbinde=1;
 
@@ -6046,12 +7157,16 @@ for (i=2; i<argc; i++)
 		      min_sechsecke=(puffer-20)/2; }
                     else
 		      if (strcmp(argv[i],"stdout")==0) to_stdout=1;
+                    else
+		      if (strcmp(argv[i],"stats")==0) { i++; statsdateiname=argv[i]; }
                     else
 		      if (strcmp(argv[i],"spistat")==0) spistat=1;
                     else
 		      if (strcmp(argv[i],"spiralcheck")==0) spiralcheck=1;
                     else
                       if (strcmp(argv[i],"symstat")==0) symstat=1;   /* TH */
+                    else
+                      if (strcmp(argv[i],"symmonly")==0) symm_vorab=1;
                     else
                       if (strcmp(argv[i],"symm")==0) {               /* TH */
                         int j=28, ii;
@@ -6080,6 +7195,9 @@ for (i=2; i<argc; i++)
 		  break; }
       case 'c': { if (strcmp(argv[i],"code")==0)
 		    { i++; codenumber=atoi(argv[i]); }
+		  else
+		    if (strcmp(argv[i],"container")==0)
+		    { i++; containername=argv[i]; }
 		  else
 		    if (strcmp(argv[i],"case")==0)
 		    { i++; do_case=atoi(argv[i]);
@@ -6093,6 +7211,10 @@ for (i=2; i<argc; i++)
 		    else { fprintf(stderr,"Nonidentified option: %s \n",argv[i]); exit(105); }
 		  break; }
       case 'p': { if (strcmp(argv[i],"pid")==0) {fprintf(stdout,"%d\n",getpid());  fflush(stdout);}
+                  else if (strcmp(argv[i],"patchfile")==0) { i++; patchdateiname=argv[i]; }
+                  else if (strcmp(argv[i],"progress")==0)
+		    { i++; fortschritt=atoi(argv[i]);
+		      if (fortschritt<1) { fprintf(stderr,"Bad value for option progress \n"); exit(119); } }
                   else {fprintf(stderr,"Nonidentified option: %s \n",argv[i]); exit(119);}
                   break;
                 }   
@@ -6109,6 +7231,13 @@ for (i=2; i<argc; i++)
 		  else { fprintf(stderr,"Nonidentified option: %s \n",argv[i]); exit(106); }
 		  break; }
 
+      case 't': { if (strcmp(argv[i],"threads")==0)
+		    { i++; threads=atoi(argv[i]);
+		      if (threads<1) { fprintf(stderr,"Bad value for option threads \n"); exit(121); }
+		    }
+		  else { fprintf(stderr,"Nonidentified option: %s \n",argv[i]); exit(121); }
+		  break; }
+
       case 'm': { if (strcmp(argv[i],"mod")==0)
 		    { i++; rest=atoi(argv[i]); i++; mod=atoi(argv[i]);
 		      if ((mod<=0) || (rest<0) || (rest>=mod))
@@ -6122,6 +7251,27 @@ for (i=2; i<argc; i++)
       default: { fprintf(stderr,"Nonidentified option: %s \n",argv[i]); exit(107); }
       }
 
+maxknoten=4*max_sechsecke+20;
+
+/* die Puffer der Ausgabedateien zusammen hoechstens etwa 64 MB */
+while (((max_sechsecke-min_sechsecke+5)*ausgabepuffergroesse > (1<<26)) && (ausgabepuffergroesse > (1<<16)))
+  ausgabepuffergroesse/=2;
+
+if ((containername!=nil) && (to_stdout || ((codenumber!=1) && (codenumber!=2) && (codenumber!=3)
+					    && (codenumber!=5) && (codenumber!=8))))
+  { fprintf(stderr,"The option \"container\" can only be used with codes 1, 2, 3, 5 and 8 written to files. \n");
+    exit(134); }
+if ((codenumber==6) || (codenumber==7) || to_stdout) puffere_ausgabe(stdout,0);
+if (symm_vorab)
+  { if (symm_len==0)
+      { fprintf(stderr,"The option \"symmonly\" can only be used together with \"symm\". \n");
+	exit(136); }
+    symm_vorbereiten(); }
+
+/* codeart 2 und 3 schreiben die Positionen der 5-Ecke als ein Byte */
+if (((codenumber==2) || (codenumber==3)) && (knotenzahl/2+2 > UCHAR_MAX-2))
+  { fprintf(stderr,"Codes 2 and 3 can only be used up to %d vertices. \n",2*(UCHAR_MAX-4));
+    exit(132); }
 
 switch (codenumber)
   {
@@ -6133,7 +7283,7 @@ switch (codenumber)
 		if (do_case) { sprintf(strpuf2,"_c%d",do_case); strcat(strpuf,strpuf2); }
 		if (mod) { sprintf(strpuf2,"_m_%d_%d",rest,mod); strcat(strpuf,strpuf2); }
                 if (symm_len>0)    {strcat(strpuf,symmstring);}
-		if (to_stdout) fil[i]=stdout; else fil[i]=fopen(strpuf,"wb");
+		if (to_stdout) fil[i]=stdout; else fil[i]=oeffne_ausgabe(strpuf,i);
 		if (!to_stdout) write_header_fil[i]=1;
 	        if (fil[i]==nil) { fprintf(stderr,"Can not open file %s. \n",strpuf); exit(109);}
 	      }
@@ -6144,29 +7294,25 @@ switch (codenumber)
 		if (do_case) { sprintf(strpuf2,"_c%d",do_case); strcat(strpuf,strpuf2); }
 		if (mod) { sprintf(strpuf2,"_m_%d_%d",rest,mod); strcat(strpuf,strpuf2); }
                 if (symm_len>0)    {strcat(strpuf,symmstring);}
-		if (to_stdout) fil[i]=stdout; else fil[i]=fopen(strpuf,"wb");
+		if (to_stdout) fil[i]=stdout; else fil[i]=oeffne_ausgabe(strpuf,i);
 		if (!to_stdout) write_header_fil[i]=1;
 	        if (fil[i]==nil) { fprintf(stderr,"Can not open file %s. \n",strpuf); exit(110);}
 	      }
 	    spiralcheck=1;
-	    last_code[0]=FL_MAX;
+	    last_code[0]=UCHAR_MAX;
 	    break; }
   case 3: { spiralcheck=1;
-            if (listenlaenge==0) listenlaenge=2000;
+            if (listenlaenge<=0) listenlaenge=100000;
             for (i=20+(2*min_sechsecke); i<=knotenzahl; i+=2)
-	      { (codeliste[i].code)[0]=0;
+	      { codeliste[i].codes=nil; codeliste[i].anzahl=codeliste[i].laeufe=0;
 		if (IPR) sprintf(strpuf,"Spiral_codes_%d_ipr",i);
 		  else sprintf(strpuf,"Spiral_codes_%d",i);
 		if (do_case) { sprintf(strpuf2,"_c%d",do_case); strcat(strpuf,strpuf2); }
 		if (mod) { sprintf(strpuf2,"_m_%d_%d",rest,mod); strcat(strpuf,strpuf2); }
                 if (symm_len>0)    {strcat(strpuf,symmstring);}
-		if (to_stdout) fil[i]=stdout; else fil[i]=fopen(strpuf,"wb");
+		if (to_stdout) fil[i]=stdout; else fil[i]=oeffne_ausgabe(strpuf,i);
                 if (!to_stdout) write_header_fil[i]=1;
 	        if (fil[i]==nil) { fprintf(stderr,"Can not open file %s. \n",strpuf); exit(111);}
-		lastcode[i]=(FLAECHENTYP **)malloc(sizeof(FLAECHENTYP *));
-		if (lastcode[i] ==nil) { fprintf(stderr,"Can not get memory for lastcode. \n"); exit(112); }
-		(*(lastcode[i]))=(FLAECHENTYP *)malloc(sizeof(FLAECHENTYP)*12);
-		(*(lastcode[i]))[0]=FL_MAX;
 	      }
 	    break; }
   case 4: spiralcheck=1; break; /* Nur nicht-spiral-codes schreiben */
@@ -6177,7 +7323,7 @@ switch (codenumber)
 		if (do_case) { sprintf(strpuf2,"_c%d",do_case); strcat(strpuf,strpuf2); }
 		if (mod) { sprintf(strpuf2,"_m_%d_%d",rest,mod); strcat(strpuf,strpuf2); }
                 if (symm_len>0)    {strcat(strpuf,symmstring);}
-		if (to_stdout) fil[i]=stdout; else fil[i]=fopen(strpuf,"wb");
+		if (to_stdout) fil[i]=stdout; else fil[i]=oeffne_ausgabe(strpuf,i);
 	        if (fil[i]==nil) { fprintf(stderr,"Can not open file %s. \n",strpuf); exit(113);}
                 if (!to_stdout) write_header_fil[i]=1;
 	      }
@@ -6246,29 +7392,57 @@ if (!quiet)
     fprintf(logfile,"Maximal vertex number: %d \n",knotenzahl);
     fprintf(logfile,"Code_type: %d \n",codenumber);
     if (codenumber==3) fprintf(logfile,"List length: %d \n",listenlaenge);
+    if (threads>1) fprintf(logfile,"Threads: %d \n",threads);
     if (separate_logfile) fclose(logfile);
   }
 
 
-initialize_list();
-
-baue_patches(sechsecke); 
+if ((patchdateiname!=nil) && lies_patchdatei(patchdateiname)) patches_gelesen=1;
+else
+  { initialize_list();
+    baue_patches(sechsecke); 
+    verdichte_patches();
+    if (patchdateiname!=nil) schreibe_patchdatei(patchdateiname);
+  }
+phase_ende(patches_gelesen ? "reading the patches" : "generating the patches");
+naechster_fortschritt=wandzeit()+fortschritt;
 #ifndef NOTIMES
 times(&TMS);
 savetime= TMS.tms_utime;
 if (!quiet) 
-  { fprintf(stderr,"Time for generating the patches: %.1f seconds \n",(double)savetime/time_factor);
+  { fprintf(stderr,"Time for %s%s: %.1f seconds \n",patches_gelesen ? "reading the patches from " : "generating the patches",
+	    patches_gelesen ? patchdateiname : "",(double)savetime/time_factor);
     if (separate_logfile) {
       logfile=fopen(logfilename,"a");
-      fprintf(logfile,"Time for generating the patches: %.1f seconds \n",(double)savetime/time_factor);
+      fprintf(logfile,"Time for %s%s: %.1f seconds \n",patches_gelesen ? "reading the patches from " : "generating the patches",
+	      patches_gelesen ? patchdateiname : "",(double)savetime/time_factor);
       fclose(logfile);
     }
   }
 #endif //NOTIMES
 
-if (do_bauchbinde)
+if (threads>1)
+{
+parallel_generieren(min_sechsecke,max_sechsecke);
+phase_ende("all cases");
+#ifndef NOTIMES
+times(&TMS);
+buffertime= TMS.tms_utime+TMS.tms_cutime;
+if (!quiet) 
+  { fprintf(stderr,"Time for all cases (%d threads): %.1f seconds \n\n",threads,(double)(buffertime-savetime)/time_factor);
+    if (separate_logfile) {
+      logfile=fopen(logfilename,"a");
+      fprintf(logfile,"Time for all cases (%d threads): %.1f seconds \n\n",threads,(double)(buffertime-savetime)/time_factor);
+      fclose(logfile);
+    }
+  }
+#endif //NOTIMES
+}
+
+if (do_bauchbinde && (threads==1))
 {
 bauchbinde(min_sechsecke,max_sechsecke);
+phase_ende("case 1");
 #ifndef NOTIMES
 times(&TMS);
 buffertime= TMS.tms_utime;
@@ -6284,9 +7458,10 @@ savetime=buffertime;
 #endif //NOTIMES
 }
 
-if (do_brille)
+if (do_brille && (threads==1))
 {
 brille(min_sechsecke,max_sechsecke);
+phase_ende("case 2");
 #ifndef NOTIMES
 times(&TMS);
 buffertime= TMS.tms_utime;
@@ -6302,9 +7477,10 @@ if (!quiet)
 #endif //NOTIMES
 }
 
-if (do_sandwich)
+if (do_sandwich && (threads==1))
 {
 sandwich(min_sechsecke,max_sechsecke);
+phase_ende("case 3");
 #ifndef NOTIMES
 times(&TMS);
 buffertime= TMS.tms_utime;
@@ -6320,7 +7496,13 @@ if (!quiet)
 }
 
 if (codenumber==3) 
-  for (i=20+(2*min_sechsecke); i<=knotenzahl; i++) { dummypointer=dummycode; ausgabe(codeliste+i,i,&dummypointer); }
+  for (i=20+(2*min_sechsecke); i<=knotenzahl; i+=2) ausgabe(i);
+
+schliesse_ohne_spirale();
+if (containername!=nil) schreibe_container();
+else schliesse_codedateien();
+fflush(stdout);
+phase_ende("output");
 
 
 if (!quiet) 
@@ -6333,6 +7515,12 @@ if (!quiet)
      if (spiralnumbers[i]) fprintf(stderr,"Fullerenes with %d spirals: %d \n",i,spiralnumbers[i]);
    if (spiralcheck) fprintf(stderr,"Graphs without a spiral starting at a pentagon: %d \n",no_penta_spiral);
    if (hexspi) fprintf(stderr,"Graphs without a spiral starting at a hexagon: %d \n",no_hexa_spiral);
+   if (spiralversuche) 
+     { fprintf(stderr,"Spiral developments tried: %lld \n",spiralversuche);
+#ifndef NOTIMES
+       fprintf(stderr,"Time for the spirals: %.1f seconds \n",(double)spiralzeit/CLOCKS_PER_SEC);
+#endif //NOTIMES
+     }
    if (symstat) schreibe_symmetriestatistik();
 #ifndef NOTIMES 
   fprintf(stderr,"\nTotal generation time: %.1f seconds \n",(double)buffertime/time_factor);
@@ -6349,6 +7537,12 @@ if (!quiet)
        if (spiralnumbers[i]) fprintf(logfile,"Fullerenes with %d spirals: %d \n",i,spiralnumbers[i]);
      if (spiralcheck) fprintf(logfile,"Graphs without a spiral starting at a pentagon: %d \n",no_penta_spiral);
      if (hexspi) fprintf(logfile,"Graphs without a spiral starting at a hexagon: %d \n",no_hexa_spiral);
+     if (spiralversuche) 
+       { fprintf(logfile,"Spiral developments tried: %lld \n",spiralversuche);
+#ifndef NOTIMES
+	 fprintf(logfile,"Time for the spirals: %.1f seconds \n",(double)spiralzeit/CLOCKS_PER_SEC);
+#endif //NOTIMES
+       }
      if (symstat) {    /* schreibe Symmetriestatistik */
        int j=0;
        fprintf(logfile,"Symmetries:\n");
@@ -6368,6 +7562,17 @@ if (!quiet)
    }
  }
 
+if (statsdateiname!=nil) schreibe_stats();
+
 return(0);
 }
 
+
+/**************************MAIN*********************************************/
+
+#ifndef FULLGEN_LIBRARY
+int main(int argc, char *argv[])
+{
+return(fullgen_run(argc,argv));
+}
+#endif
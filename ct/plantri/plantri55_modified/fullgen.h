@@ -0,0 +1,74 @@
+/* fullgen.h */
+/* Schnittstelle, um fullgen als Bibliothek zu benutzen.
+
+   Uebersetzt man fullgen.c mit -DFULLGEN_LIBRARY, gibt es kein main(),
+   sondern fullgen_run(), das die Argumente wie die Kommandozeile
+   auswertet ("fullgen_run(3, {"fullgen","60","ipr"})"). Ist mit
+   fullgen_set_callback() eine Funktion eingetragen, wird sie fuer jedes
+   erzeugte Fulleren (nach "symm" gefiltert) statt der Codierung
+   aufgerufen.
+
+   Die Funktion bekommt die Einbettung so, wie fullgen sie selbst benutzt:
+   map[0][0].name ist die Knotenzahl n, die Knoten sind 1..n, und
+   map[i][0..2] sind die drei Kanten, die bei Knoten i beginnen. Fuer eine
+   Kante e ist e->name der andere Endknoten, e->next und e->prev die
+   naechste bzw. vorige Kante um e->ursprung im Uhrzeigersinn und
+   e->invers die Gegenkante. Die Einbettung darf nicht veraendert werden
+   und ist nur waehrend des Aufrufs gueltig. symmetrie ist die Nummer der
+   Symmetriegruppe (1..28); fullgen_symmetry_name() gibt ihren Namen
+   zurueck, wie in der Statistik mit Leerzeichen auf 3 Zeichen aufgefuellt.
+
+   Gibt die Funktion einen Wert != 0 zurueck, wird die Erzeugung
+   abgebrochen (die gerade bearbeitete Einheit wird noch beendet, die
+   Funktion aber nicht mehr aufgerufen).
+
+   Bei Fehlern wird wie im Programm exit() aufgerufen. fullgen_run() darf
+   in einem Prozess nur einmal aufgerufen werden, da die Zaehler und
+   Optionen nicht zurueckgesetzt werden; ein zweiter Aufruf endet mit
+   exit(137). Mit "threads" laeuft die Funktion in mehreren abgespaltenen
+   Prozessen.
+
+   Ausser den drei Funktionen unten exportiert die Bibliothek keine
+   Namen; alles andere in fullgen.c ist static.
+
+   fullgen_halfedge.hpp stellt die Einbettung fuer C++ ohne Kopieren als
+   Feld von Halbkanten dar.
+*/
+
+#ifndef FULLGEN_H
+#define FULLGEN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef unsigned short KNOTENTYP;
+
+/* Element der Adjazenztabelle: */
+
+typedef struct K {
+                   KNOTENTYP ursprung; /* bei welchem knoten startet die kante */
+                   KNOTENTYP name;  /* Identifikation des Knotens, mit
+                                       dem Verbindung besteht */
+		   int dummy;   /* fuer alle moeglichen zwecke -- int, damit KANTE 40 Bytes hat */
+		   char nostart;
+		   char noleft; /* fuer die Rekonstruktion: Keine Flaeche links hiervon */
+		   char noright; /* fuer die Rekonstruktion: Keine Flaeche rechts hiervon */
+		   char mirror_nostart;
+		   KNOTENTYP mininame; /* jeweils fuer den minimalitaetstest */
+                   struct K *prev;  /* vorige Kante im Uhrzeigersinn */
+                   struct K *next;  /* naechste Kante im Uhrzeigersinn */
+		   struct K *invers; /* die inverse Kante (in der Liste von "name") */
+                  } KANTE;
+
+typedef int (*FULLGEN_CALLBACK)(KANTE (*map)[3], int symmetrie, void *daten);
+
+void fullgen_set_callback(FULLGEN_CALLBACK funktion, void *daten);
+int fullgen_run(int argc, char *argv[]);
+const char *fullgen_symmetry_name(int symmetrie);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FULLGEN_H */
@@ -0,0 +1,73 @@
+// fullgen_halfedge.hpp
+//
+// Read-only half-edge view of the embedding passed to a fullgen callback
+// (see fullgen.h).  Nothing is copied: the half-edges are the KANTE
+// entries map[1][0] .. map[n][2] themselves, numbered 0 .. 3n-1 in that
+// order, and vertices are numbered 0 .. n-1 (fullgen vertex i is i-1).
+//
+//     static int colour(KANTE (*map)[3], int symmetrie, void *daten)
+//     {
+//         fullgen::HalfEdgeView g(map);
+//         for (std::size_t h = 0; h < g.num_half_edges(); ++h) { ... }
+//         return 0;
+//     }
+//
+// Half-edge h starts at origin(h), ends at target(h); twin(h) is the same
+// edge in the other direction.  next_around(h) is the next half-edge with
+// the same origin in clockwise order, and face_next(h) the next half-edge
+// of the face that lies on the same side of h as fullgen's traversal
+// (twin(h) then clockwise).  The view is valid only during the callback.
+
+#ifndef FULLGEN_HALFEDGE_HPP
+#define FULLGEN_HALFEDGE_HPP
+
+#include <cstddef>
+
+#include "fullgen.h"
+
+namespace fullgen {
+
+class HalfEdgeView {
+public:
+    explicit HalfEdgeView(KANTE (*map)[3])
+        : base_(&map[1][0]), n_(map[0][0].name) {}
+
+    std::size_t num_vertices() const { return n_; }
+    std::size_t num_half_edges() const { return 3 * n_; }
+    std::size_t num_edges() const { return 3 * n_ / 2; }
+    std::size_t num_faces() const { return n_ / 2 + 2; }
+
+    std::size_t origin(std::size_t h) const { return base_[h].ursprung - 1; }
+    std::size_t target(std::size_t h) const { return base_[h].name - 1; }
+    std::size_t twin(std::size_t h) const { return index(base_[h].invers); }
+    std::size_t next_around(std::size_t h) const { return index(base_[h].next); }
+    std::size_t prev_around(std::size_t h) const { return index(base_[h].prev); }
+    std::size_t face_next(std::size_t h) const { return index(base_[h].invers->next); }
+
+    // The first half-edge leaving vertex v; the others are +1 and +2.
+    std::size_t first_out(std::size_t v) const { return 3 * v; }
+
+    // Number of half-edges of the face that face_next() walks from h
+    // (5 or 6 for a fullerene).
+    std::size_t face_size(std::size_t h) const
+    {
+        std::size_t k = 1;
+        for (std::size_t e = face_next(h); e != h; e = face_next(e)) ++k;
+        return k;
+    }
+
+    const KANTE &raw(std::size_t h) const { return base_[h]; }
+
+private:
+    std::size_t index(const KANTE *e) const
+    {
+        return static_cast<std::size_t>(e - base_);
+    }
+
+    const KANTE *base_;
+    std::size_t n_;
+};
+
+}  // namespace fullgen
+
+#endif  // FULLGEN_HALFEDGE_HPP
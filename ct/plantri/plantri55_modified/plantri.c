@@ -224,6 +224,13 @@ Change History:
        17-May-2024 : Fixed -p splitting for 2 or 3 vertices.
                      -- making 5.5
 
+       18-Oct-2026 : added -c6 for internally 6-connected triangulations
+                   : -P# prunes subtrees that can't reach degree #
+                   : added -estimate# for search tree size estimates
+                   : added -S to start from a file of parent graphs
+
+       19-Oct-2026 : -S with -A rejects parents that are not Apollonian
+
 **************************************************************************/
 
 #include <stdio.h> 
@@ -294,6 +301,7 @@ typedef struct
 /* Global variables */
 
 static char *outfilename;  /* name of output file (NULL for stdout) */
+static char *parentfilename; /* -S: file of parent graphs, or NULL */
 static FILE *outfile;      /* output file for graphs */
 static FILE *msgfile;      /* file for informational messages */
 
@@ -309,6 +317,8 @@ static int minpolyconnec;  /* lower bound on minumum connectivity for
                               polytopes.  Defaults to same as minconnec. */
 static int xconnec;        /* Value of connectivity appropriate for -x.
                               The same as either minconnec or minpolyconnec. */
+static int internal6;      /* -c6: only internally 6-connected outputs */
+static int probing;        /* -estimate: random probes, no outputs */
 static int edgebound[2];   /* edge count min,max for polytopes */
 static int maxfacesize;    /* maximum face size for polytopes */
 
@@ -366,6 +376,9 @@ static EDGE edges[NUMEDGES];
 #define STAR3(n) (edges + 6 + ((n)<<3))
 #define STAR4(n) (edges + 6 + 8*MAXN + ((n)<<3))
 #define STAR5(n) (edges + 6 + 16*MAXN + ((n)<<4))
+#define PARENT_EDGES (edges + 6 + 32*MAXN)
+/* A -S parent graph, placed after the stars since scansimple() and
+   the routines it calls use nothing else. */
 
 #define P_op(n) (edges + 24 + 12*(n))
 #define Q_op(n) (edges + 24 + 12*MAXN + 6*(n))
@@ -434,6 +447,9 @@ static char am2[MAXN][64];
 #define ISEQADJ(i,j) (am2[i][j] != 0)
 #define ISNEQADJ(i,j) (am2[i][j] == 0)
 
+static unsigned char int6adj[MAXN][MAXN];  /* Only used for -c6, and
+                                              all 0 between uses */
+
 static EDGE *doubles[MAXE];  /* holds edges with parallel mates */
 
 #define PCODE ">>planar_code<<"
@@ -501,6 +517,8 @@ static bigint nout_p_op[MAXN+1];  /* .. per polygon size, OP */
 static bigint totalout;       /* Sum of nout[] (always) */
 static bigint totalout_op;    /* Sum of nout_op[] (only if -o) */
 static bigint nout_V;        /* Deletions due to -V */
+static bigint nout_int6;     /* Deletions due to -c6 */
+static bigint nodes_simple;  /* Calls to scansimple() below maxnv */
 
 static char outtypename[50];  /* How to describe output objects */
 
@@ -4463,6 +4481,491 @@ check_it(int code, int facesize)
 
 /**************************************************************************/
 
+static int
+is_internally_6_connected(void)
+
+/* Test whether the current 5-connected triangulation is internally
+   6-connected, meaning that every separating 5-cycle is the
+   neighbourhood of a vertex (necessarily of degree 5).
+
+   In a 5-connected triangulation a 5-cycle is separating iff it has
+   no chord.  A trivial separating 5-cycle through the edge u-v must
+   have its inner vertex on one of the two faces containing u-v, so
+   only those two vertices need to be tried.  Each cycle u,v,x,y,z
+   is only looked at from its least vertex u, in the direction with
+   v < z.
+*/
+
+{
+    int i,u,v,x,y,z,w1,w2,ans;
+    EDGE *e,*elast,*ex,*ey,*eylast,*ez;
+
+    for (i = 0; i < nv; ++i)
+    {
+        e = elast = firstedge[i];
+        do
+        {
+            int6adj[i][e->end] = 1;
+            e = e->next;
+        } while (e != elast);
+    }
+
+    ans = TRUE;
+    for (u = 0; u < nv && ans; ++u)
+    {
+        e = elast = firstedge[u];
+        do
+        {
+            v = e->end;
+            if (v > u)
+            {
+                w1 = e->next->end;
+                w2 = e->prev->end;
+                for (ex = e->invers->next->next; 
+                                 ans && ex != e->invers->prev; ex = ex->next)
+                {
+                    x = ex->end;
+                    if (x < u || int6adj[u][x]) continue;
+                    for (ez = e->next->next; ans && ez != e->prev;
+                                                              ez = ez->next)
+                    {
+                        z = ez->end;
+                        if (z < v || z == x || int6adj[v][z] || int6adj[x][z])
+                            continue;
+                        ey = eylast = ex->invers;
+                        do
+                        {
+                            y = ey->end;
+                            if (y > u && int6adj[z][y] && !int6adj[u][y]
+                                      && !int6adj[v][y]
+                                && !(degree[w1] == 5 && int6adj[w1][x]
+                                      && int6adj[w1][y] && int6adj[w1][z])
+                                && !(degree[w2] == 5 && int6adj[w2][x]
+                                      && int6adj[w2][y] && int6adj[w2][z]))
+                            {
+                                ans = FALSE;
+                                break;
+                            }
+                            ey = ey->next;
+                        } while (ey != eylast);
+                    }
+                }
+            }
+            e = e->next;
+        } while (ans && e != elast);
+    }
+
+    for (i = 0; i < nv; ++i)
+    {
+        e = elast = firstedge[i];
+        do
+        {
+            int6adj[i][e->end] = 0;
+            e = e->next;
+        } while (e != elast);
+    }
+
+    return ans;
+}
+
+/**************************************************************************/
+
+/* Search tree size estimation (-estimate#).
+
+   Each probe follows a random path down the real recursion (Knuth,
+   Math. Comp. 29 (1975) 121-136).  Every node on the path is run twice.
+   In the first pass its children are only counted as they are entered.
+   Then one of them is chosen uniformly at random and the second pass
+   descends into it alone.  If a node at depth d is reached with weight
+   W (the product of the child counts above it), then W estimates the
+   number of nodes at depth d, W times the cpu time of the first pass
+   estimates the time spent on that depth, and each output found during
+   a first pass counts W times.
+
+   The recursive scan procedures start with PROBE_NODE(), which does all
+   this and returns, except that it falls through into the normal body
+   for the two passes.  The group in numbering[] is overwritten by the
+   children, so it is saved and restored around each pass.  A scan
+   procedure entered while no probe is in progress is a root of the
+   search, and probe_count probes are made from it.  Scan procedures
+   without PROBE_NODE() are part of the work of whichever node calls
+   them.
+*/
+
+#define PROBE_MAXDEPTH (MAXN+MAXE/2+2)
+#define PROBE_OUT   PROBE_MAXDEPTH       /* indices into probe_this[] etc. */
+#define PROBE_NODES (PROBE_MAXDEPTH+1)
+#define PROBE_TIME  (PROBE_MAXDEPTH+2)
+#define PROBE_NSTAT (PROBE_MAXDEPTH+3)
+
+static long probe_count;         /* number of probes per root */
+static unsigned long long probe_seed;
+static int probe_reentry;        /* PROBE_NODE() is calling its own node */
+static int probe_lev;            /* depth of the current node, -1 if none */
+static int probe_maxlev;         /* greatest depth reached */
+static long probe_done;          /* probes completed from this root */
+static int probe_first[PROBE_MAXDEPTH];    /* TRUE in the first pass */
+static long probe_nchild[PROBE_MAXDEPTH];  /* children found */
+static long probe_target[PROBE_MAXDEPTH];  /* the child to descend into */
+static long probe_seen[PROBE_MAXDEPTH];    /* children entered, pass 2 */
+static double probe_weight[PROBE_MAXDEPTH];
+static int probe_nvmin[PROBE_MAXDEPTH],probe_nvmax[PROBE_MAXDEPTH];
+#if CPUTIME
+static clock_t probe_clock[PROBE_MAXDEPTH];
+#endif
+static double probe_this[PROBE_NSTAT];     /* estimates from this probe */
+static double probe_s1[PROBE_NSTAT],probe_s2[PROBE_NSTAT];
+                                 /* sums and sums of squares over probes */
+static double probe_mean[PROBE_NSTAT],probe_var[PROBE_NSTAT];
+                                 /* estimates and variances, all roots */
+static EDGE **probe_feas;        /* saved edge lists for scanpoly() etc. */
+static EDGE **probe_group;       /* saved numbering[] for each depth */
+static size_t probe_groupbase[PROBE_MAXDEPTH+1],probe_groupsize;
+
+#define PROBE_NODE(call,save,restore) \
+    if (probing) \
+    { \
+        if (!probe_reentry) \
+        { \
+            if (probe_select()) \
+            { \
+                probe_savegroup(nbtot); \
+                save; \
+                do \
+                { \
+                    probe_reentry = TRUE; \
+                    call; \
+                    probe_restoregroup(nbtot); \
+                    restore; \
+                    if (probe_choose()) \
+                    { \
+                        probe_reentry = TRUE; \
+                        call; \
+                        probe_restoregroup(nbtot); \
+                        restore; \
+                    } \
+                } while (probe_finish()); \
+            } \
+            return; \
+        } \
+        probe_reentry = FALSE; \
+    }
+
+#define PROBE(call) PROBE_NODE(call,(void)0,(void)0)
+
+ /* The polytope procedures change oldfeas[] in place, so it must be
+    restored before each pass. */
+#define PROBE_FEAS(call) PROBE_NODE(call, \
+     probe_savefeas(oldfeas,noldfeas),probe_restorefeas(oldfeas,noldfeas))
+
+/**************************************************************************/
+
+static void
+probe_init(void)
+
+/* Check the switches for -estimate and prepare for probing. */
+{
+    if (mod > 1)
+    {
+        fprintf(stderr,">E %s: -estimate can't be used with res/mod\n",
+                cmdname);
+        exit(1);
+    }
+
+    uswitch = TRUE;
+    vswitch = FALSE;
+    probe_lev = probe_maxlev = -1;
+    probe_seed ^= 0x9E3779B97F4A7C15ULL;
+
+    probe_feas = (EDGE**)malloc(PROBE_MAXDEPTH*(MAXE/2)*sizeof(EDGE*));
+    if (probe_feas == NULL)
+    {
+        fprintf(stderr,">E malloc failed in probe_init()\n");
+        exit(1);
+    }
+}
+
+/**************************************************************************/
+
+static long
+probe_random(long n)
+
+/* A random integer in 0..n-1 (xorshift64*). */
+{
+    probe_seed ^= probe_seed >> 12;
+    probe_seed ^= probe_seed << 25;
+    probe_seed ^= probe_seed >> 27;
+
+    return (long)(((probe_seed * 2685821657736338717ULL) >> 33) % n);
+}
+
+/**************************************************************************/
+
+static void
+probe_push(double w)
+
+/* Start expanding a node with weight w, one deeper than the last. */
+{
+    int lev;
+
+    lev = ++probe_lev;
+    if (lev >= PROBE_MAXDEPTH)
+    {
+        fprintf(stderr,">E -estimate: recursion deeper than %d\n",
+                PROBE_MAXDEPTH);
+        exit(1);
+    }
+
+    if (lev > probe_maxlev)
+    {
+        probe_maxlev = lev;
+        probe_nvmin[lev] = probe_nvmax[lev] = nv;
+    }
+    else if (nv < probe_nvmin[lev]) probe_nvmin[lev] = nv;
+    else if (nv > probe_nvmax[lev]) probe_nvmax[lev] = nv;
+
+    probe_weight[lev] = w;
+    probe_first[lev] = TRUE;
+    probe_nchild[lev] = 0;
+    probe_this[lev] += w;
+    probe_this[PROBE_NODES] += w;
+#if CPUTIME
+    probe_clock[lev] = clock();
+#endif
+}
+
+/**************************************************************************/
+
+static int
+probe_select(void)
+
+/* Called by PROBE_NODE() on entry to a scan procedure.  Count the
+   node if its parent is in the first pass.  Return TRUE if this node
+   starts a probe, or is the child chosen for the second pass. */
+{
+    if (probe_lev < 0)
+    {
+        probe_done = 0;
+        probe_push(1.0);
+        return TRUE;
+    }
+
+    if (probe_first[probe_lev])
+    {
+        ++probe_nchild[probe_lev];
+        return FALSE;
+    }
+
+    if (++probe_seen[probe_lev] != probe_target[probe_lev]) return FALSE;
+
+    probe_push(probe_weight[probe_lev] * probe_nchild[probe_lev]);
+    return TRUE;
+}
+
+/**************************************************************************/
+
+static int
+probe_choose(void)
+
+/* Called after the first pass over the current node.  Choose a child
+   for the second pass, or return FALSE if there are none. */
+{
+    int lev;
+
+    lev = probe_lev;
+#if CPUTIME
+    probe_this[PROBE_TIME] += probe_weight[lev]
+                  * (double)(clock() - probe_clock[lev]) / CLOCKS_PER_SEC;
+#endif
+    probe_first[lev] = FALSE;
+
+    if (probe_nchild[lev] == 0) return FALSE;
+
+    probe_target[lev] = 1 + probe_random(probe_nchild[lev]);
+    probe_seen[lev] = 0;
+    return TRUE;
+}
+
+/**************************************************************************/
+
+static int
+probe_finish(void)
+
+/* Called when the current node is finished.  If that completes a
+   probe from the root, record it and return TRUE if another probe
+   is to be made. */
+{
+    int i;
+    double k;
+
+    if (--probe_lev >= 0) return FALSE;
+
+    for (i = 0; i < PROBE_NSTAT; ++i)
+    {
+        probe_s1[i] += probe_this[i];
+        probe_s2[i] += probe_this[i] * probe_this[i];
+        probe_this[i] = 0.0;
+    }
+
+    if (++probe_done < probe_count)
+    {
+        probe_push(1.0);
+        return TRUE;
+    }
+
+    /* Independent roots: the estimates and their variances add. */
+    k = (double)probe_count;
+    for (i = 0; i < PROBE_NSTAT; ++i)
+    {
+        probe_mean[i] += probe_s1[i] / k;
+        if (probe_count > 1)
+            probe_var[i] += (probe_s2[i] - probe_s1[i]*probe_s1[i]/k)
+                            / (k - 1.0) / k;
+        probe_s1[i] = probe_s2[i] = 0.0;
+    }
+
+    return FALSE;
+}
+
+/**************************************************************************/
+
+static void
+probe_output(int wt)
+
+/* Called by got_one() for each output.  Outputs found outside of
+   any probe (small cases made by the dispatch routines) are exact. */
+{
+    if (probe_lev < 0)
+        probe_mean[PROBE_OUT] += wt;
+    else if (probe_first[probe_lev])
+        probe_this[PROBE_OUT] += wt * probe_weight[probe_lev];
+}
+
+/**************************************************************************/
+
+static void
+probe_savefeas(EDGE *feas[], int nfeas)
+{
+    EDGE **p;
+    int i;
+
+    p = probe_feas + probe_lev*(MAXE/2);
+    for (i = 0; i < nfeas; ++i) p[i] = feas[i];
+}
+
+static void
+probe_restorefeas(EDGE *feas[], int nfeas)
+{
+    EDGE **p;
+    int i;
+
+    p = probe_feas + probe_lev*(MAXE/2);
+    for (i = 0; i < nfeas; ++i) feas[i] = p[i];
+}
+
+/**************************************************************************/
+
+static void
+probe_savegroup(int nbtot)
+
+/* Save numbering[0..nbtot-1] for the current depth. */
+{
+    size_t top,need;
+    int i,j;
+    EDGE **p;
+
+    top = probe_groupbase[probe_lev];
+    need = top + (size_t)nbtot*ne;
+    if (need > probe_groupsize)
+    {
+        probe_groupsize = 2*need;
+        probe_group = (EDGE**)realloc(probe_group,
+                                      probe_groupsize*sizeof(EDGE*));
+        if (probe_group == NULL)
+        {
+            fprintf(stderr,">E realloc failed in probe_savegroup()\n");
+            exit(1);
+        }
+    }
+    probe_groupbase[probe_lev+1] = need;
+
+    p = probe_group + top;
+    for (i = 0; i < nbtot; ++i)
+        for (j = 0; j < ne; ++j) *p++ = numbering[i][j];
+}
+
+static void
+probe_restoregroup(int nbtot)
+{
+    int i,j;
+    EDGE **p;
+
+    p = probe_group + probe_groupbase[probe_lev];
+    for (i = 0; i < nbtot; ++i)
+        for (j = 0; j < ne; ++j) numbering[i][j] = *p++;
+}
+
+/**************************************************************************/
+
+static void
+probe_print(FILE *f, int i)
+
+/* Write estimate i with its 95% confidence interval.  The square root
+   is done here to avoid needing the maths library. */
+{
+    double x,r;
+    int j;
+
+    fprintf(f,"%11.4e",probe_mean[i]);
+    if (probe_count > 1)
+    {
+        x = probe_var[i];
+        r = (x > 1.0 ? x : 1.0);
+        if (x > 0.0)
+            for (j = 0; j < 2000; ++j) r = 0.5 * (r + x/r);
+        else
+            r = 0.0;
+        fprintf(f," +- %.2e",1.96*r);
+    }
+}
+
+/**************************************************************************/
+
+static void
+probe_report(double cpu)
+
+/* Write the estimates.  cpu is the time taken by the probes. */
+{
+    int i;
+
+    fprintf(msgfile,"Estimates from %ld probes",probe_count);
+    if (probe_count > 1) fprintf(msgfile," (95%% confidence intervals)");
+    fprintf(msgfile,":\n depth     nv       nodes\n");
+
+    for (i = 0; i <= probe_maxlev; ++i)
+    {
+        if (probe_nvmin[i] == probe_nvmax[i])
+            fprintf(msgfile," %5d %6d  ",i,probe_nvmin[i]);
+        else
+            fprintf(msgfile," %5d %3d-%-3d ",i,probe_nvmin[i],probe_nvmax[i]);
+        probe_print(msgfile,i);
+        fprintf(msgfile,"\n");
+    }
+
+    fprintf(msgfile,"Search tree nodes: ");
+    probe_print(msgfile,PROBE_NODES);
+    fprintf(msgfile,"\n%s: ",outtypename);
+    probe_print(msgfile,PROBE_OUT);
+    fprintf(msgfile,"\n");
+#if CPUTIME
+    fprintf(msgfile,"Projected cpu (sec): ");
+    probe_print(msgfile,PROBE_TIME);
+    fprintf(msgfile,"\nEstimation cpu=%.2f sec\n",cpu);
+#endif
+}
+
+/**************************************************************************/
+
 static void
 got_one(int nbtot, int nbop, int connec)
 
@@ -4491,10 +4994,22 @@ got_one(int nbtot, int nbop, int connec)
         }
     }
 
+    if (internal6 && !is_internally_6_connected())
+    {
+        nout_int6 += wt;
+        return;
+    }
+
 #ifdef FILTER
     if (!FILTER(nbtot,nbop,doflip)) return;
 #endif
 
+    if (probing)
+    {
+        probe_output(oswitch ? wt : 1);
+        return;
+    }
+
     ++nout[connec];
     if (oswitch) nout_op[connec] += wt;
 
@@ -6327,6 +6842,9 @@ scanpoly_c4(int nbtot, int nbop, EDGE *oldfeas[], int noldfeas,
     int ngood_or,ncan_or,ngood_inv,ncan_inv;
     int newmaxlist0,newmaxlist1;
 
+    PROBE_FEAS(scanpoly_c4(nbtot,nbop,oldfeas,noldfeas,
+                           oldmaxface,oldmaxlist0,oldmaxlist1));
+
     if (ne <= edgebound[1]) got_one(nbtot,nbop,3);
     if (ne == edgebound[0]) return;
     if (ne - 2*noldfeas > edgebound[1]) return;
@@ -6681,6 +7199,9 @@ scanpoly_c3(int nbtot, int nbop, EDGE *oldfeas[], int noldfeas,
     int ngood_or,ncan_or,ngood_inv,ncan_inv;
     int newmaxlist0,newmaxlist1;
 
+    PROBE_FEAS(scanpoly_c3(nbtot,nbop,oldfeas,noldfeas,
+                           oldmaxface,oldmaxlist0,oldmaxlist1));
+
     if (ne <= edgebound[1]) got_one(nbtot,nbop,3);
     if (ne == edgebound[0]) return;
     if (ne - 2*noldfeas > edgebound[1]) return;
@@ -7130,6 +7651,9 @@ scanpoly(int nbtot, int nbop, EDGE *oldfeas[], int noldfeas,
     int ngood_or,ncan_or,ngood_inv,ncan_inv;
     int newmaxlist0,newmaxlist1,newconnec;
 
+    PROBE_FEAS(scanpoly(nbtot,nbop,oldfeas,noldfeas,
+                        oldmaxface,oldmaxlist0,oldmaxlist1,connec));
+
     if (ne <= edgebound[1]) got_one(nbtot,nbop,connec);
     if (ne == edgebound[0]) return;
     if (ne - 2*noldfeas > edgebound[1]) return;
@@ -7470,6 +7994,49 @@ polygon_triang(int nbtot, int nbop)
 
 /**************************************************************************/
 
+static int
+polygon_reachable(void)
+
+/* For -P# with # > 0.  Returns FALSE if no vertex can have degree
+   polygonsize once nv reaches maxnv.  Each extension adds one vertex of
+   degree 3..5 and changes the degree of any old vertex by at most 1.
+   So with r = maxnv-nv steps left, the vertex to be removed must either
+   be added later (only possible if r > 0 and polygonsize <= r+4) or have
+   degree polygonsize-r..polygonsize+r now.  When r = 0, the vertices
+   polygon_triang() would skip for being next to a vertex of degree 3
+   are not counted either. */
+{
+    int i,r;
+    EDGE *e,*elast;
+
+    r = maxnv - nv;
+    if (r > 0 && polygonsize <= r + 4) return TRUE;
+
+    if (r == 0 && (minimumdeg == 3 || minconnec == 3))
+    {
+        for (i = 0; i < nv; ++i)
+        if (degree[i] == polygonsize)
+        {
+            e = elast = firstedge[i];
+            do
+            {
+                if (degree[e->end] == 3) break;
+                e = e->next;
+            } while (e != elast);
+            if (e == elast && degree[e->end] != 3) return TRUE;
+        }
+        return FALSE;
+    }
+
+    for (i = 0; i < nv; ++i)
+        if (degree[i] >= polygonsize - r && degree[i] <= polygonsize + r)
+            return TRUE;
+
+    return FALSE;
+}
+
+/**************************************************************************/
+
 static void
 scansimple(int nbtot, int nbop)
 
@@ -7484,10 +8051,14 @@ scansimple(int nbtot, int nbop)
     register int i;
     register EDGE *e1,*e2,**nb,**nblim;
     EDGE *e,*ex;
-    int nc,xnbtot,xnbop,v,needed_deg;
+    int nc,xnbtot,xnbop,v;
     int colour[MAXN];
     EDGE *firstedge_save[MAXE];
 
+    PROBE(scansimple(nbtot,nbop));
+
+    ++nodes_simple;
+
     if (nv == maxnv)
     {
         if (pswitch)               startpolyscan(nbtot,nbop);
@@ -7509,15 +8080,7 @@ scansimple(int nbtot, int nbop)
         for (i = 0; i < nv; ++i) firstedge_save[i] = firstedge[i];
     }
 
-   /* The following could be improved significantly by avoiding
-      extensions that can't lead to success here. */
-    if (polygonsize >= 9)
-    {
-        needed_deg = polygonsize + nv - maxnv;
-        for (i = 0; i < nv; ++i)
-            if (degree[i] >= needed_deg) break;
-        if (i == nv) return;
-    }
+    if (polygonsize > 0 && !polygon_reachable()) return;
 
 #ifdef PRE_FILTER_SIMPLE
     if (!(PRE_FILTER_SIMPLE)) return;
@@ -7538,6 +8101,7 @@ scansimple(int nbtot, int nbop)
 #ifdef FAST_FILTER_SIMPLE
             if (FAST_FILTER_SIMPLE)
 #endif 
+            if (polygonsize <= 0 || polygon_reachable())
             {
                 if (nc == 1 && nv == maxnv && !needgroup)
                     got_one(1,1,3);
@@ -7554,6 +8118,7 @@ scansimple(int nbtot, int nbop)
 #ifdef FAST_FILTER_SIMPLE
         if (FAST_FILTER_SIMPLE)
 #endif
+        if (polygonsize <= 0 || polygon_reachable())
         { 
             if (canon(degree,numbering,&xnbtot,&xnbop))   
             {
@@ -7582,6 +8147,7 @@ scansimple(int nbtot, int nbop)
 #ifdef FAST_FILTER_SIMPLE
         if (FAST_FILTER_SIMPLE)
 #endif 
+        if (polygonsize <= 0 || polygon_reachable())
         {
             if (canon(degree,numbering,&xnbtot,&xnbop))    
             {
@@ -8367,6 +8933,9 @@ scanbipartite(int nbtot, int nbop, EDGE *wheelrim, int dosplit,
     int xnbtot,xnbop;
     EDGE *hint,*newPedges[MAXN/2];
 
+    PROBE(scanbipartite(nbtot,nbop,wheelrim,dosplit,
+                        Pedges,nPedges));
+
     if (nv == maxnv)
     {
         got_one(nbtot,nbop,3);
@@ -8644,6 +9213,9 @@ scanbipartite4c(int nbtot, int nbop, EDGE *wheelrim, int dosplit,
     triangle newnft[MAXN];
     int newnumnft,connec;
 
+    PROBE(scanbipartite4c(nbtot,nbop,wheelrim,dosplit,
+                          Pedges,nPedges,nft,numnft));
+
     if (nv == maxnv)
     {
         connec = 3 + (numnft==0);
@@ -9963,6 +10535,8 @@ scanmin4c(int nbtot, int nbop, int dosplit, EDGE *lastfour,
     int xnbtot,xnbop;
     int hint;
 
+    PROBE(scanmin4c(nbtot,nbop,dosplit,lastfour,nft,numnft));
+
     if (nv == maxnv)
     {
         if (numnft == 0)
@@ -10127,6 +10701,8 @@ scanmin4(int nbtot, int nbop, int dosplit, EDGE *lastfour)
     int xnbtot,xnbop;
     int hint;
 
+    PROBE(scanmin4(nbtot,nbop,dosplit,lastfour));
+
     if (nv == maxnv)
     {
         if (pswitch) startpolyscan(nbtot,nbop);
@@ -12147,6 +12723,8 @@ scanmin5c(int nbtot, int nbop, int dosplit, EDGE **prevA, int nprevA)
     int xnbtot,xnbop;
     int colour[MAXN];
 
+    PROBE(scanmin5c(nbtot,nbop,dosplit,prevA,nprevA));
+
     if (nv == maxnv)
     {
         got_one(nbtot,nbop,5);
@@ -13652,6 +14230,8 @@ scanmin5(int nbtot, int nbop, int dosplit, EDGE **prevA, int nprevA,
     int xnbtot,xnbop;
     int colour[MAXN];
 
+    PROBE(scanmin5(nbtot,nbop,dosplit,prevA,nprevA,bangle,nbangles));
+
     if (nv == maxnv) 
     {
         if (pswitch) startpolyscan(nbtot,nbop);   /* Saves the group! */
@@ -14507,6 +15087,9 @@ scanbip(int nbtot, int nbop, EDGE *oldfeas[], int noldfeas,
     int ngood_or,ncan_or,ngood_inv,ncan_inv;
     int newmaxlist0,newmaxlist1,newconnec;
 
+    PROBE_FEAS(scanbip(nbtot,nbop,oldfeas,noldfeas,
+                       oldmaxface,oldmaxlist0,oldmaxlist1,connec));
+
     if (ne <= edgebound[1]) got_one(nbtot,nbop,connec);
     if (ne == edgebound[0]) return;
     if (ne - 2*noldfeas > edgebound[1]) return;
@@ -18284,6 +18867,9 @@ scanquadrangulations(int nbtot, int nbop, EDGE *spoke, int dosplit,
     EDGE *newP1edge[MAXN],*rededge;
     EDGE *hint;
 
+    PROBE(scanquadrangulations(nbtot,nbop,spoke,dosplit,
+                               P1edge,nP1edges));
+
     if (nv == maxnv)
     {
         if (pswitch) startbipscan(nbtot,nbop,3);
@@ -18419,6 +19005,9 @@ scanquadrangulations_min3(int nbtot, int nbop, EDGE *spoke, int dosplit,
     EDGE *newP1edge[MAXN],*rededge;
     EDGE *hint;
 
+    PROBE(scanquadrangulations_min3(nbtot,nbop,spoke,dosplit,
+                                    P1edge,nP1edges));
+
     if (nv == maxnv)
     {
         if (pswitch || xswitch) conn = con_quad();
@@ -18558,6 +19147,9 @@ scanquadrangulations_nf4(int nbtot, int nbop, EDGE *spoke, int dosplit,
     EDGE *newP1edge[MAXN],*rededge;
     EDGE *hint;
 
+    PROBE(scanquadrangulations_nf4(nbtot,nbop,spoke,dosplit,
+                                   P1edge,nP1edges));
+
     if (nv == maxnv)
     {
         got_one(nbtot,nbop,4);   /* Note connectivity is really 3 */
@@ -18658,6 +19250,8 @@ scanquadrangulations_all(int nbtot, int nbop)
     int xnbtot,xnbop,conn;
     EDGE *rededge;
 
+    PROBE(scanquadrangulations_all(nbtot,nbop));
+
     if (nv == maxnv)
     {
         if (pswitch || xswitch) conn = con_quad();
@@ -18757,6 +19351,8 @@ scanmultiquadrangulations(int nbtot, int nbop)
     int xnbtot,xnbop;
     EDGE *rededge;
 
+    PROBE(scanmultiquadrangulations(nbtot,nbop));
+
     if (nv == maxnv)
     {
         got_one(nbtot,nbop,1);  /* Third arg is connectivity but
@@ -19000,6 +19596,7 @@ decode_command_line(int argc, char *argv[])
     argsgot = 0;
     badargs = FALSE;
     outfilename = NULL;
+    parentfilename = NULL;
     aswitch = FALSE;
     gswitch = FALSE;
     sswitch = FALSE;
@@ -19026,11 +19623,31 @@ decode_command_line(int argc, char *argv[])
     polygonsize = -1;
     minimumdeg = -1;
     res = 0; mod = 1;
+    probing = FALSE;
+    probe_seed = 1;
 
     for (i = 1; !badargs && i < argc; ++i)
     {
         arg = argv[i];
-        if (arg[0] == '-' && arg[1] != '\0')
+        if (strncmp(arg,"-estimate",9) == 0)
+        {
+            j = 8;
+            probe_count = getswitchvalue(arg,&j);
+            if (probe_count == 0) probe_count = 1000;
+            if (arg[j+1] == ':')
+            {
+                ++j;
+                probe_seed = getswitchvalue(arg,&j);
+            }
+            if (arg[j+1] != '\0') badargs = TRUE;
+            probing = TRUE;
+        }
+        else if (strcmp(arg,"-S") == 0)
+        {
+            if (i+1 < argc) parentfilename = argv[++i];
+            else            badargs = TRUE;
+        }
+        else if (arg[0] == '-' && arg[1] != '\0')
         {
         for (j = 1; arg[j] != '\0'; ++j)
             if (arg[j] == '\0') { }
@@ -19166,7 +19783,7 @@ initialize_splitting(int minlevel, int hint, int maxlevel)
         if (minlevel <= maxlevel) splitlevel = minlevel;
         else                      splitlevel = 0;
     }
-    if (mod == 1) splitlevel = 0;
+    if (mod == 1 || parentfilename) splitlevel = 0;
 
     splitcount = res;
 }
@@ -19270,6 +19887,257 @@ open_output_file(void)
 
 /****************************************************************************/
 
+static int
+read_parent(FILE *f)
+
+/* Read the next graph in planar_code from f, making it the current
+   graph with its edges at PARENT_EDGES.  Return FALSE at end of file.
+   The graph must be a simple triangulation with 4..maxnv vertices. */
+{
+    int n,v,w,c,i,k,nf;
+    int adj[MAXN][MAXN];
+    int queue[MAXN],seen[MAXN];
+    EDGE *e,*ex,*estart;
+
+    if ((n = getc(f)) == EOF) return FALSE;
+
+    PERROR(n == 0,"-S: the 2-byte form of planar_code is not supported");
+    PERROR(n < 4 || n > maxnv,"-S: parent graphs must have 4..n vertices");
+
+    nv = n;
+    ne = 0;
+    for (v = 0; v < nv; ++v)
+    {
+        degree[v] = 0;
+        while ((c = getc(f)) != 0)
+        {
+            PERROR(c == EOF,"-S: unexpected end of parent file");
+            PERROR(c > nv || c == v+1 || degree[v] >= nv-1 || ne >= MAXE,
+                   "-S: a parent graph is not simple");
+            adj[v][degree[v]++] = c - 1;
+            ++ne;
+        }
+        PERROR(degree[v] < 3,"-S: a parent graph has a vertex of degree < 3");
+    }
+    PERROR(ne != 6*nv-12,"-S: a parent graph is not a triangulation");
+
+    k = 0;
+    for (v = 0; v < nv; ++v)
+    {
+        firstedge[v] = PARENT_EDGES + k;
+        for (i = 0; i < degree[v]; ++i)
+        {
+            e = PARENT_EDGES + k + i;
+            e->start = v;
+            e->end = adj[v][i];
+            e->next = PARENT_EDGES + k + (i+1) % degree[v];
+            e->prev = PARENT_EDGES + k + (i+degree[v]-1) % degree[v];
+            e->invers = NULL;
+        }
+        k += degree[v];
+    }
+
+    for (v = 0; v < nv; ++v)
+    {
+        e = estart = firstedge[v];
+        do
+        {
+            if (e->invers == NULL)
+            {
+                w = e->end;
+                ex = firstedge[w];
+                for (i = degree[w]; --i >= 0 && ex->end != v; ) ex = ex->next;
+                PERROR(i < 0 || ex->invers != NULL,
+                       "-S: a parent graph is not simple");
+                e->invers = ex;
+                ex->invers = e;
+                e->min = ex->min = (e < ex ? e : ex);
+            }
+            e = e->next;
+        } while (e != estart);
+    }
+
+  /* Every face must be a triangle, and Euler's formula holds
+     if the graph is connected. */
+
+    RESETMARKS;
+    nf = 0;
+    for (k = 0; k < ne; ++k)
+    {
+        e = PARENT_EDGES + k;
+        if (ISMARKEDLO(e)) continue;
+        ++nf;
+        for (i = 0; i < 3; ++i)
+        {
+            MARKLO(e);
+            e = e->invers->next;
+        }
+        PERROR(e != PARENT_EDGES + k,
+               "-S: a parent graph is not a triangulation");
+    }
+    PERROR(nf != 2*nv-4,"-S: a parent graph is not a plane triangulation");
+
+    for (v = 0; v < nv; ++v) seen[v] = FALSE;
+    queue[0] = 0;
+    seen[0] = TRUE;
+    for (i = 0, k = 1; i < k; ++i)
+    {
+        e = estart = firstedge[queue[i]];
+        do
+        {
+            if (!seen[e->end])
+            {
+                seen[e->end] = TRUE;
+                queue[k++] = e->end;
+            }
+            e = e->next;
+        } while (e != estart);
+    }
+    PERROR(k != nv,"-S: a parent graph is not connected");
+
+    return TRUE;
+}
+
+/****************************************************************************/
+
+static int
+parent_is_apollonian(void)
+
+/* For -S with -A.  Return TRUE if the current triangulation is an
+   Apollonian network, i.e. a member of the tree that -A makes from K4
+   by inserting vertices of degree 3 only.  Those are the triangulations
+   that can be taken back to K4 by removing vertices of degree 3, and
+   as removing one leaves such a graph, the order does not matter. */
+{
+    int v,k,left,deg[MAXN],stack[MAXN],gone[MAXN];
+    EDGE *e,*ex;
+
+    k = 0;
+    for (v = 0; v < nv; ++v)
+    {
+        deg[v] = degree[v];
+        gone[v] = FALSE;
+        if (deg[v] == 3) stack[k++] = v;
+    }
+
+    for (left = nv; left > 4 && k > 0; )
+    {
+        v = stack[--k];
+        gone[v] = TRUE;
+        --left;
+        e = ex = firstedge[v];
+        do
+        {
+            if (!gone[e->end] && --deg[e->end] == 3) stack[k++] = e->end;
+            e = e->next;
+        } while (e != ex);
+    }
+
+    return left == 4;
+}
+
+/****************************************************************************/
+
+static void
+parent_group(int *nbtot, int *nbop)
+
+/* Find the automorphism group of a parent graph, in the form made by
+   canon().  canon() itself only works for a new last vertex, so use
+   canon_edge() on the edges from a vertex of minimum degree to a
+   neighbour of least degree, trying each in turn until it is found
+   to be canonical. */
+{
+    EDGE *list[MAXE],*e,*ex;
+    int i,n,d0,d1;
+
+    d0 = d1 = MAXN;
+    for (i = 0; i < nv; ++i) if (degree[i] < d0) d0 = degree[i];
+    for (i = 0; i < nv; ++i)
+    if (degree[i] == d0)
+    {
+        e = ex = firstedge[i];
+        do
+        {
+            if (degree[e->end] < d1) d1 = degree[e->end];
+            e = e->next;
+        } while (e != ex);
+    }
+
+    n = 0;
+    for (i = 0; i < nv; ++i)
+    if (degree[i] == d0)
+    {
+        e = ex = firstedge[i];
+        do
+        {
+            if (degree[e->end] == d1) list[n++] = e;
+            e = e->next;
+        } while (e != ex);
+    }
+
+    for (i = 0; i < n; ++i)
+    {
+        e = list[0]; list[0] = list[i]; list[i] = e;
+        if (canon_edge(list,n,degree,numbering,nbtot,nbop)) return;
+        e = list[0]; list[0] = list[i]; list[i] = e;
+    }
+
+    fprintf(stderr,">E parent_group() failed\n");
+    exit(1);
+}
+
+/****************************************************************************/
+
+static void
+scan_parents(void)
+
+/* -S: run scansimple() from each graph in parentfilename instead of
+   from K4.  The graphs are taken as canonical members of the tree, so
+   their descendants are exactly the outputs of a normal run that lie
+   below them.  With res/mod, parent number i (from 0) is used only
+   if i = res (mod mod). */
+{
+    FILE *f;
+    int c,nbtot,nbop;
+    long count;
+
+    if ((f = fopen(parentfilename,"rb")) == NULL)
+    {
+        fprintf(stderr,">E %s: can't open %s\n",cmdname,parentfilename);
+        exit(1);
+    }
+
+    if ((c = getc(f)) == '>')
+    {
+        while ((c = getc(f)) != EOF)
+            if (c == '<' && (c = getc(f)) == '<') break;
+        PERROR(c == EOF,"-S: bad header in parent file");
+    }
+    else if (c != EOF)
+        ungetc(c,f);
+
+    for (count = 0; read_parent(f); ++count)
+    {
+        if (Aswitch && !parent_is_apollonian())
+        {
+            fprintf(stderr,">E %s: -S: parent %ld is not an Apollonian"
+                           " network, as -A needs\n",cmdname,count);
+            exit(1);
+        }
+        if (count % mod != res) continue;
+
+        parent_group(&nbtot,&nbop);
+#ifdef FAST_FILTER_SIMPLE
+        if (FAST_FILTER_SIMPLE)
+#endif
+        scansimple(nbtot,nbop);
+    }
+
+    fclose(f);
+}
+
+/****************************************************************************/
+
 static void
 simple_dispatch(void)
 
@@ -19308,11 +20176,16 @@ simple_dispatch(void)
 
     hint = (maxnv < 18 ? 15 : 16);
     initialize_splitting(startingsize,hint,maxnv-1);
-    if (splitlevel == 0 && res > 0) return;
+    if (splitlevel == 0 && res > 0 && !parentfilename) return;
 
     xconnec = minconnec;
 
-    if (maxnv >= startingsize)
+    if (parentfilename)
+    {
+        initialize_triang();
+        scan_parents();
+    }
+    else if (maxnv >= startingsize)
     {
         initialize_triang();
         canon(degree,numbering,&nbtot,&nbop);
@@ -19426,12 +20299,13 @@ polygon_dispatch(void)
     open_output_file();
 
     for (i = 0; i <= MAXN; ++i) nout_p[i] = nout_p_op[i] = 0;
+    nodes_simple = 0;
 
     needgroup = TRUE;
 
     hint = (maxnv < 18 ? 15 : 16);
     initialize_splitting(startingsize,hint,maxnv-2);
-    if (splitlevel == 0 && res > 0)
+    if (splitlevel == 0 && res > 0 && !parentfilename)
     {
         --maxnv;
         return;
@@ -19440,11 +20314,23 @@ polygon_dispatch(void)
     xconnec = minconnec;
 
     initialize_triang();
-    canon(degree,numbering,&nbtot,&nbop);
-    scansimple(nbtot,nbop);
+    if (parentfilename)
+        scan_parents();
+    else
+    {
+        canon(degree,numbering,&nbtot,&nbop);
+        scansimple(nbtot,nbop);
+    }
 
     --maxnv;
 
+    if (vswitch)
+    {
+        fprintf(msgfile,"Search tree nodes: ");
+        PRINTBIG(msgfile,nodes_simple);
+        fprintf(msgfile,"\n");
+    }
+
     if (vswitch && polygonsize == 0)
     {
         for (i = 0; i <= MAXN; ++i)
@@ -19603,6 +20489,65 @@ min5_dispatch(void)
 
 /****************************************************************************/
 
+static void
+int6_dispatch(void)
+
+/* Case of -c6: internally 6-connected triangulations, that is,
+   5-connected triangulations in which every separating 5-cycle is the
+   neighbourhood of a vertex.  These are made as for -c5 and filtered
+   in got_one().  Extensions can destroy separating 5-cycles, so no
+   smaller graph can be rejected. */
+{
+    int startingsize,nbtot,nbop,hint;
+    EDGE *prevA[MAXN];
+
+    if (minimumdeg <= 0) minimumdeg = 5;
+    startingsize = 12;
+
+    CHECKRANGE(maxnv,"n",startingsize,MAXN);
+    CHECKRANGE(minconnec,"-c",6,6);
+    CHECKRANGE(minimumdeg,"-m",5,5);
+
+    INCOMPAT(tswitch,"-c6","-t");
+    INCOMPAT(qswitch,"-c6","-q");
+    INCOMPAT(Aswitch,"-c6","-A");
+    INCOMPAT(xswitch,"-c6","-x");
+    INCOMPAT(edgebound[0]>=0,"-c6 without -p","-e");
+    INCOMPAT(maxfacesize>=0,"-c6 without -p","-f");
+    
+    if (dswitch) strcpy(outtypename,"cubic graphs");
+    else         strcpy(outtypename,"triangulations");
+
+    open_output_file();
+
+    needgroup = Gswitch;
+    internal6 = TRUE;
+    nout_int6 = 0;
+
+    hint = (maxnv < 35 ? 28 : maxnv < 38 ? 29 : 30);
+    initialize_splitting(startingsize,hint,maxnv-5);
+    if (splitlevel == 0 && res > 0) return;
+
+    minconnec = xconnec = 5;
+
+    initialize_min5();
+    canon(degree,numbering,&nbtot,&nbop);
+
+#ifdef FAST_FILTER_MIN5
+    if (FAST_FILTER_MIN5)
+#endif
+    scanmin5c(nbtot,nbop,splitlevel==12,prevA,0);
+
+    if (vswitch)
+    {
+        fprintf(msgfile,"Rejected ");
+        PRINTBIG(msgfile,nout_int6);
+        fprintf(msgfile," with a non-trivial separating 5-cycle.\n");
+    }
+}
+
+/****************************************************************************/
+
 static void
 polytope_dispatch(void)
 
@@ -19724,10 +20669,15 @@ polytope_dispatch(void)
     {
         hint = (maxnv < 17 ? 15 : 16);
         initialize_splitting(startingsize,hint,maxnv-1);
-        if (splitlevel == 0 && res > 0) return;
+        if (splitlevel == 0 && res > 0 && !parentfilename) return;
         initialize_triang();
-        canon(degree,numbering,&nbtot,&nbop);
-        scansimple(nbtot,nbop);
+        if (parentfilename)
+            scan_parents();
+        else
+        {
+            canon(degree,numbering,&nbtot,&nbop);
+            scansimple(nbtot,nbop);
+        }
     }
     else
     {
@@ -20400,6 +21350,16 @@ main(int argc, char *argv[])
     PLUGIN_INIT;
 #endif
 
+    if (probing) probe_init();
+
+    if (parentfilename != NULL
+          && (bswitch || qswitch || Qswitch || minconnec >= 4 || minimumdeg >= 4))
+    {
+        fprintf(stderr,">E %s: -S is only available for triangulations "
+                "of minimum degree 3, -p and -P\n",cmdname);
+        exit(1);
+    }
+
     minpolydeg = -1;
     minpolyconnec = -1;
 
@@ -20410,6 +21370,7 @@ main(int argc, char *argv[])
     else if (bswitch)                           eulerian_dispatch();
     else if (qswitch)                           quadrangulation_dispatch();
     else if (Qswitch)                           multiquadrangulation_dispatch();
+    else if (minconnec == 6)                    int6_dispatch();
     else if (minconnec >= 5 || minimumdeg >= 5) min5_dispatch();
     else if (minconnec >= 4 || minimumdeg >= 4) min4_dispatch();
     else                                        simple_dispatch();
@@ -20418,6 +21379,17 @@ main(int argc, char *argv[])
     times(&timestruct1);
 #endif
 
+    if (probing)
+    {
+#if CPUTIME
+        probe_report((double)(timestruct1.tms_utime+timestruct1.tms_stime
+              -timestruct0.tms_utime-timestruct0.tms_stime) / (double)CLK_TCK);
+#else
+        probe_report(0.0);
+#endif
+        return 0;
+    }
+
     totalout = totalout_op = 0;
     for (i = 0; i < 6; ++i)
     {
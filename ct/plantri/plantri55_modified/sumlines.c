@@ -7,8 +7,14 @@
                   available with -lgmp if it is installed. */
 #endif
 
+#ifndef THREADS
+#define THREADS 1  /* Non-zero if -j# is allowed.  This needs POSIX
+                      threads (compile with -pthread) and mmap(). */
+#endif
+
 #define USAGE \
-"sumlines [-w|-W] [-v] [-d] [-n] [-f fmtfile]...  file file file ..."
+"sumlines [-w|-W] [-v] [-d] [-n] [-j#] [-s statefile] [-f fmtfile]...\n\
+         file file file ..."
 
 #define HELPTEXT \
 "   Sum lines matching specified formats.\n\
@@ -44,6 +50,13 @@
       matching final lines.\n\
    -W in addition, suppresses warning about missing cases.\n\
    -n don't write the number of matching lines for each format.\n\
+   -j# read and match the input files with # threads.  The output\n\
+      is the same as without -j.\n\
+   -s statefile  keep the totals and how far each file has been read\n\
+      in statefile, and next time read only new files and what has been\n\
+      appended to the others.  Messages about sequence numbers and\n\
+      multiple matches come only when the lines are read.  -j is\n\
+      ignored, and stdin can't be used.\n\
    -v produces a list of all the formats.\n"
 
 #define DEFAULT    0  /* No special flags */
@@ -64,6 +77,10 @@
    If the CONTINUE flag is present, the input line is also matched
    against further formats.
 
+   (To save time, only the formats whose literal text before the first
+   % item and after the last one agree with the line are tried, but the
+   result is the same.)
+
    Except in the case of formats with the COUNT flag, each format that
    matches any lines produces output giving the total value of each of the
    integers %d or real numbers %f in the lines which match.  If there are
@@ -147,11 +164,19 @@
 #include <glob.h>
 #include <limits.h>
 #include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #if GMP
 #include <gmp.h>
 #endif
 
+#if THREADS
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
 typedef long long integer;
 #define DOUT "%*lld"   
 #define FOUT "%*.2f"
@@ -212,8 +237,14 @@ static struct fmt_st
    int flags;
    char *fmt;
    char *before,*after;
+   char *lit;          /* Literal prefix followed by literal suffix */
+   size_t preflen;     /* Length of the prefix */
+   size_t suflen;      /* Length of the suffix */
 } format[MAXFORMATS];
 
+static int cand_start[257];  /* cand_list[cand_start[c]..cand_start[c+1]-1] */
+static int *cand_list;       /* are the formats for lines starting with c */
+
 typedef struct countrec
 {
     struct countrec *left,*right,*parent;
@@ -227,11 +258,15 @@ static unsigned long matching_lines[MAXFORMATS];
 static integer total_position[MAXFORMATS];
 static integer lastseq[MAXFORMATS];
 
+typedef struct
+{
 #if GMP
-static mpz_t mp_value[MAXVALUES];
+    mpz_t mp_value[MAXVALUES];
 #endif
+    integerlist il[MAXVALUES];
+} scanspace;     /* Static data for scanline(); one for each thread */
 
-static integerlist il[MAXVALUES];
+static scanspace mainspace;
 
 #define A 0
 #define L 1
@@ -782,7 +817,7 @@ add_one(countnode **to_root, char *fmt, integer pmod, int nval,
 
 static int
 scanline(char *s, char *f, number *val, int *valtype,
-         integer *seqno, char *outf)
+         integer *seqno, char *outf, scanspace *sp)
 /* Perform sscanf-like scan of line.
    The whole format must match.  outf is set to be an output format
    with unassigned values replaced by '*' and %s replaced by what
@@ -792,7 +827,7 @@ scanline(char *s, char *f, number *val, int *valtype,
    Integers matching %# are put into *seqno, with an error if there
    are more than one, and -1 if there are none.
    If the format doesn't match, -1 is returned.
-   WARNING: the gmp and ilist values are pointers to static data,
+   WARNING: the gmp and ilist values are pointers to the data in *sp,
    so they need to be copied if the values array is copied.
    See the comments at the start of the program for more information.
 */
@@ -996,7 +1031,7 @@ scanline(char *s, char *f, number *val, int *valtype,
                 if (doass)
                 {
                     valtype[n] = LD;
-                    val[n].l = &il[n];
+                    val[n].l = &sp->il[n];
                     val[n].l->nvals = nilist;
                     if (val[n].l->val) free(val[n].l->val);
                     val[n].l->val = ilist;
@@ -1029,8 +1064,8 @@ scanline(char *s, char *f, number *val, int *valtype,
                 if (doass)
                 {
                     valtype[n] = M;
-                    val[n].m = &mp_value[n];
-                    if (mpz_set_str(mp_value[n],mp_line,10) < 0)
+                    val[n].m = &sp->mp_value[n];
+                    if (mpz_set_str(sp->mp_value[n],mp_line,10) < 0)
                         badgmp = TRUE;
                     ++n;
                     *outf++ = '%';
@@ -1184,6 +1219,23 @@ scanline(char *s, char *f, number *val, int *valtype,
 
 /****************************************************************************/
 
+static void
+init_scanspace(scanspace *sp)
+{
+    int i;
+
+#if GMP
+    for (i = 0; i < MAXVALUES; ++i) mpz_init(sp->mp_value[i]);
+#endif
+    for (i = 0; i < MAXVALUES; ++i) 
+    {
+        sp->il[i].nvals = 0;
+        sp->il[i].val = NULL;
+    }
+}
+
+/****************************************************************************/
+
 void
 find_maxint(void)
 {
@@ -1485,11 +1537,147 @@ read_env_formats(int *numformatsp)
 
 /****************************************************************************/
 
+static void
+compile_format(int i)
+/* Find the literal prefix and suffix of format i.  A line can only match
+   if it starts with the prefix and ends with the suffix, which don't
+   overlap.  If the format has anything that scanline() could complain
+   about after the prefix, the suffix is left empty so that the format
+   is still tried and the complaint is the same. */
+{
+    char *f,*lit,*suf;
+    size_t len;
+    boolean inprefix,doass,nosuffix;
+    int nseq;
+
+    f = format[i].fmt;
+    len = strlen(f);
+    if ((lit = (char*)malloc(2*len+1)) == NULL)
+    {
+        fprintf(stderr,">E malloc() failed in compile_format()\n");
+        exit(1);
+    }
+
+    inprefix = TRUE;
+    nosuffix = FALSE;
+    nseq = 0;
+    format[i].preflen = 0;
+    suf = lit + len;
+    *suf = '\0';
+
+    while (*f != '\0')
+    {
+        if (*f != '%')
+        {
+            if (inprefix) lit[format[i].preflen++] = *f;
+            else          *suf++ = *f;
+            ++f;
+            continue;
+        }
+
+        ++f;
+        doass = (*f != '*');
+        if (!doass) ++f;
+        if (*f == '-' || isdigit(*f)) (void)readwidth(&f);
+
+        if (*f == '%' && doass)
+        {
+            if (inprefix) lit[format[i].preflen++] = '%';
+            else          *suf++ = '%';
+            ++f;
+            continue;
+        }
+
+        inprefix = FALSE;
+        suf = lit + len;
+        if (*f == '#') ++nseq;
+        if (*f == '\n' || (!doass && *f == '%')
+            || strchr("cslmdxnpfvXh# ",*f) == NULL || *f == '\0'
+#if !GMP
+            || *f == 'm'
+#endif
+            || nseq > 1)
+        {
+            nosuffix = TRUE;
+            break;
+        }
+        ++f;     /* For %s, the terminator that follows is literal */
+    }
+
+    if (inprefix)    /* No directives, only the prefix matters */
+        format[i].suflen = 0;
+    else if (nosuffix)
+        format[i].suflen = 0;
+    else
+        format[i].suflen = suf - (lit + len);
+
+    memmove(lit+format[i].preflen,lit+len,format[i].suflen);
+    lit[format[i].preflen+format[i].suflen] = '\0';
+    format[i].lit = lit;
+}
+
+/****************************************************************************/
+
+static void
+compile_formats(int numformats)
+/* Make the candidate lists for the first character of a line.  Each
+   list has the formats in their original order, so the first match and
+   CONTINUE work as if all formats were tried. */
+{
+    int c,i,n;
+
+    for (i = 0; i < numformats; ++i) compile_format(i);
+
+    n = 0;
+    for (c = 0; c < 256; ++c)
+    {
+        cand_start[c] = n;
+        for (i = 0; i < numformats; ++i)
+            if (format[i].preflen == 0
+                   || (unsigned char)format[i].lit[0] == c) ++n;
+    }
+    cand_start[256] = n;
+
+    if ((cand_list = (int*)malloc((n+1)*sizeof(int))) == NULL)
+    {
+        fprintf(stderr,">E malloc() failed in compile_formats()\n");
+        exit(1);
+    }
+
+    n = 0;
+    for (c = 0; c < 256; ++c)
+        for (i = 0; i < numformats; ++i)
+            if (format[i].preflen == 0
+                   || (unsigned char)format[i].lit[0] == c) cand_list[n++] = i;
+}
+
+/****************************************************************************/
+
 static boolean
+may_match(int i, char *line, size_t len)
+/* Check the literal prefix and suffix of format i against a line of
+   length len (up to the first NUL). */
+{
+    size_t pl,sl;
+
+    pl = format[i].preflen;
+    sl = format[i].suflen;
+
+    if (pl + sl > len) return FALSE;
+    if (pl > 1 && memcmp(line+1,format[i].lit+1,pl-1) != 0) return FALSE;
+    if (sl > 0 && memcmp(line+len-sl,format[i].lit+pl,sl) != 0) return FALSE;
+
+    return TRUE;
+}
+
+/****************************************************************************/
+
+static int
 readoneline(FILE *f, char *line, int size, int *nulls)
 /* Get a line.  Read at most size-1 chars until EOF or \n.
    If \n is read, it is stored.  Then \0 is appended.
-   *nulls is set to the number of NUL chars (which are also stored). */
+   *nulls is set to the number of NUL chars (which are also stored).
+   The number of chars read is returned (0 at EOF). */
 {
     int i,c;
 
@@ -1504,7 +1692,7 @@ readoneline(FILE *f, char *line, int size, int *nulls)
     }
     line[i] = '\0';
 
-    return i > 0;
+    return i;
 }
 
 /****************************************************************************/
@@ -1554,144 +1742,1292 @@ doglob(char *patt, glob_t *globlk)
 
 /****************************************************************************/
 
-int
-main(int argc, char *argv[])
+static void
+accept_match(int i, char *outf, int nvals, number *val, int *valtype,
+             integer seq, unsigned long line_number, boolean noWarn)
+/* Account for a line that matched format i, as given by scanline(). */
+{
+    ++matching_lines[i];
+    total_position[i] += line_number;
+    add_one(&count_root[i],outf,format[i].pmod,nvals,
+         val,valtype,i,HAS(i,NUMERIC));
+    if (!noWarn && matching_lines[i] > 1 && seq >= 0 
+                           && seq != lastseq[i]+1)
+    {
+        printf("WARNING: Sequence number");
+        if (seq == lastseq[i])
+        {   
+            printf(" ");
+            printf(dout,1,seq);
+            printf(" is repeated.\n");
+        }
+        else if (seq != lastseq[i]+2)
+        {
+            printf("s ");
+            printf(dout,1,lastseq[i]+1);
+            printf("-");
+            printf(dout,1,seq-1);
+            printf(" are missing.\n");
+        }
+        else
+        {
+            printf("  ");
+            printf(dout,1,seq-1);
+            printf(" is missing.\n");
+        }
+    }
+    lastseq[i] = seq;
+}
+
+/****************************************************************************/
+
+static boolean
+match_line(char *line, int numformats, unsigned long *line_number,
+           unsigned long *matched, unsigned long *finalmatched,
+           unsigned long *errorlines, boolean noWarn)
+/* Try the formats on one input line and account for the matches.
+   Return FALSE if the line counts as not matched (which it also does
+   if the last format matched and has CONTINUE). */
 {
-    int i,j,nvals,argnum;
+    int i,k,c,nvals;
+    size_t len;
+    integer seq;
     number val[MAXVALUES];
     int valtype[MAXVALUES];
-    char line[MAXLINELEN+2];
-    char outf[MAXLINELEN+MAXVALUES+6];
-    unsigned long matched,unmatched,finalmatched;
-    unsigned long errorlines,totalerrorlines;
-    unsigned long line_number,nullcount,numfiles,ifile;
-    char *filename;
-    FILE *infile;
-    int numformats,firstarg,nulls;
-    boolean havefinal,nowarn,noWarn,listformats,readfiles;
+    static char outf[MAXLINELEN+MAXVALUES+6];
+
+    len = strlen(line);
+    c = (unsigned char)line[0];
+    for (k = cand_start[c]; k < cand_start[c+1]; ++k)
+    {
+        i = cand_list[k];
+        if (!may_match(i,line,len)) continue;
+        nvals = scanline(line,format[i].fmt,val,valtype,
+                         &seq,outf,&mainspace);
+        if (nvals >= 0)
+        {
+            if (HAS(i,ENDFILE)) *line_number = 0;
+            ++*matched;
+            if (HAS(i,FINAL)) ++*finalmatched;
+            if (HAS(i,ERROR)) ++*errorlines;
+            accept_match(i,outf,nvals,val,valtype,
+                         seq,*line_number,noWarn);
+            if (!HAS(i,CONTINUE)) return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/****************************************************************************/
+
+static void
+file_warnings(char *filename, unsigned long matched,
+              unsigned long finalmatched, unsigned long errorlines,
+              unsigned long nullcount, boolean havefinal, boolean nowarn)
+/* The messages written at the end of each input file. */
+{
+    if (errorlines != 0)
+        printf("ERRORS: Error lines in file %s\n",filename);
+    else if (matched == 0 && !nowarn)
+        printf("WARNING: No matching lines in file %s\n",filename);
+    else if (finalmatched == 0 && havefinal && !nowarn)
+        printf("WARNING: No final lines in file %s\n",filename);
+    if (nullcount > 0)
+        printf("WARNING: %ld NULs found in file %s\n",nullcount,filename);
+}
+
+/****************************************************************************/
+
+#if THREADS
+
+/* With -j#, the files of each argument are read and matched by several
+   threads.  A thread takes the next file, maps it into memory, tries the
+   formats on its lines just as main() does, and keeps each match as a
+   record (format, line number, %# value, output format and values).
+   main() then takes the files in order and does for each record what it
+   does for a matching line itself, so the totals, the order of the
+   warnings and the rounding of real sums are the same as without -j. */
+
+typedef struct
+{
+    int fmt,nvals;
     integer seq;
-    int order[MAXFORMATS];
-    glob_t globlk,globlk_stdin,*pglob;
-    char *glob_stdin_v[2];
-    boolean printcounts;
+    unsigned long line_number;
+    size_t size;       /* Size of the whole record in bytes */
+} matchrec;
+/* Followed by int valtype[nvals], number val[nvals] and outf */
 
-    HELP;
+#define RECALIGN(x) (((x) + sizeof(number) - 1) & ~(sizeof(number) - 1))
+#define RECVALTYPE(r) ((int*)((char*)(r) + RECALIGN(sizeof(matchrec))))
+#define RECVAL(r) ((number*)((char*)(r) + RECALIGN(sizeof(matchrec)) \
+                             + RECALIGN((r)->nvals*sizeof(int))))
+#define RECOUTF(r) ((char*)(RECVAL(r) + (r)->nvals))
 
-    find_maxint();
+typedef struct
+{
+    char *name;
+    boolean done,openfailed;
+    char *rec;         /* The match records */
+    size_t reclen,recsize;
+    unsigned long unmatched,nullcount;
+} fileresult;
+
+static struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t filedone,roomfree;
+    fileresult *file;
+    unsigned long nfiles;
+    unsigned long nextfile;      /* The next file to be taken by a thread */
+    unsigned long firstpending;  /* The first file main() hasn't done */
+    unsigned long window;        /* How far threads can be ahead of main() */
+} par;
 
-    firstarg = 1;
-    numformats = 0;
-    nowarn = noWarn = FALSE;
-    listformats = FALSE;
-    readfiles = TRUE;
-    printcounts = TRUE;
+/****************************************************************************/
 
-    globlk_stdin.gl_pathc = 1;
-    globlk_stdin.gl_pathv = glob_stdin_v;
-    glob_stdin_v[0] = "-";
-    glob_stdin_v[1] = NULL;
+static void
+add_record(fileresult *fr, int fmt, int nvals, number *val, int *valtype,
+           integer seq, unsigned long line_number, char *outf)
+/* Append a match record to fr, copying the gmp and list values. */
+{
+    size_t size;
+    matchrec *r;
+    number *rval;
+    int i,j;
 
-    dout = DOUT;
-    fout = FOUT;
-    vout = VOUT;
-    Xout = FOUT;
-    hmsout1 = HMSOUT1;
-    hmsout2 = HMSOUT2;
+    size = RECALIGN(sizeof(matchrec)) + RECALIGN(nvals*sizeof(int))
+           + RECALIGN(nvals*sizeof(number) + strlen(outf) + 1);
 
-    for (; firstarg < argc; ++firstarg)
+    if (fr->reclen + size > fr->recsize)
     {
-        if (argv[firstarg][0] == '-' && argv[firstarg][1] == 'f')
+        fr->recsize = 2*fr->recsize + size + 4096;
+        if ((fr->rec = (char*)realloc(fr->rec,fr->recsize)) == NULL)
         {
-            if (argv[firstarg][2] != '\0')
-                read_formats(&argv[firstarg][2],&numformats,TRUE);
-            else if (firstarg == argc - 1)
+            fprintf(stderr,">E malloc failed in add_record()\n");
+            exit(1);
+        }
+    }
+
+    r = (matchrec*)(fr->rec + fr->reclen);
+    fr->reclen += size;
+    r->fmt = fmt;
+    r->nvals = nvals;
+    r->seq = seq;
+    r->line_number = line_number;
+    r->size = size;
+    rval = RECVAL(r);
+
+    for (i = 0; i < nvals; ++i)
+    {
+        RECVALTYPE(r)[i] = valtype[i];
+#if GMP
+        if (valtype[i] == M)
+        {
+            if ((rval[i].m = (mpz_t*)malloc(sizeof(mpz_t))) == NULL)
             {
-                fprintf(stderr,">E No argument for -f\n");
+                fprintf(stderr,">E malloc failed in add_record()\n");
                 exit(1);
             }
-            else
+            mpz_init_set(*(rval[i].m),*(val[i].m));
+        }
+        else
+#endif
+        if (valtype[i] == LD)
+        {
+            if ((rval[i].l = (integerlist*)malloc(sizeof(integerlist)))
+                        == NULL
+                || (rval[i].l->val = (integer*)malloc(sizeof(integer)
+                                  * (val[i].l->nvals+1))) == NULL)
             {
-                ++firstarg;
-                read_formats(argv[firstarg],&numformats,TRUE);
+                fprintf(stderr,">E malloc failed in add_record()\n");
+                exit(1);
             }
+            rval[i].l->nvals = val[i].l->nvals;
+            for (j = 0; j < val[i].l->nvals; ++j)
+                rval[i].l->val[j] = val[i].l->val[j];
         }
-        else if (strcmp(argv[firstarg],"-W") == 0)
-            noWarn = TRUE;
-        else if (strcmp(argv[firstarg],"-w") == 0)
-            nowarn = TRUE;
-        else if (strcmp(argv[firstarg],"-v") == 0)
-            listformats = TRUE;
-        else if (strcmp(argv[firstarg],"-d") == 0)
-            readfiles = FALSE;
-        else if (strcmp(argv[firstarg],"-n") == 0)
-            printcounts = FALSE;
-        else if (strcmp(argv[firstarg],"-V") == 0)
-            vout = argv[++firstarg];
-        else if (strcmp(argv[firstarg],"-F") == 0)
-            fout = argv[++firstarg];
-        else if (strcmp(argv[firstarg],"-D") == 0)
-            dout = argv[++firstarg];
         else
-            break;
+            rval[i] = val[i];
     }
 
-#if GMP
-    for (i = 0; i < MAXVALUES; ++i) mpz_init(mp_value[i]);
-#endif
-    for (i = 0; i < MAXVALUES; ++i) 
-    {
-        il[i].nvals = 0;
-        il[i].val = NULL;
-    }
+    strcpy(RECOUTF(r),outf);
+}
 
-    if (noWarn) nowarn = TRUE;
+/****************************************************************************/
 
-    if (readfiles) read_local_formats(&numformats);
-    if (readfiles) read_env_formats(&numformats);
-    if (readfiles) read_global_formats(&numformats);
+static void
+free_record(matchrec *r)
+{
+    int i;
+    number *rval;
 
-    if (listformats)
-    {
-        printf("%d formats:\n",numformats);
-        for (i = 0; i < numformats; ++i)
-            printf("%03x %s",format[i].flags,format[i].fmt);
-    }
+    rval = RECVAL(r);
+    for (i = 0; i < r->nvals; ++i)
+#if GMP
+        if (RECVALTYPE(r)[i] == M)
+        {
+            mpz_clear(*(rval[i].m));
+            free(rval[i].m);
+        }
+        else
+#endif
+        if (RECVALTYPE(r)[i] == LD)
+        {
+            free(rval[i].l->val);
+            free(rval[i].l);
+        }
+}
 
-    if (numformats == 0)
-    {
-        fprintf(stderr,">E No formats\n");
-        exit(1);
-    }
+/****************************************************************************/
 
-    havefinal = FALSE;
-    for (i = 0; i < numformats; ++i)
-    {
-        count_root[i] = NULL;
-        matching_lines[i] = 0;
-        total_position[i] = 0;
-        if (HAS(i,FINAL)) havefinal = TRUE;
-    }
+static char*
+map_file(char *filename, size_t *len, boolean *mapped)
+/* Return the contents of the file (mapped if possible, otherwise read),
+   or NULL if it can't be opened.  "-" means stdin. */
+{
+    int fd;
+    struct stat st;
+    char *buf;
+    size_t size;
+    ssize_t got;
 
-    unmatched = totalerrorlines = 0;
-    numfiles = 0;
+    if (strcmp(filename,"-") == 0)
+        fd = 0;
+    else if ((fd = open(filename,O_RDONLY)) < 0)
+        return NULL;
 
-    for (argnum = firstarg;
-         argnum < (argc == firstarg ? argc+1 : argc); ++argnum)
+    *len = 0;
+    *mapped = FALSE;
+    buf = NULL;
+
+    if (fstat(fd,&st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
     {
-        if (argnum >= argc || strcmp(argv[argnum],"-") == 0)
-            pglob = &globlk_stdin;
+        buf = (char*)mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+        if (buf == (char*)MAP_FAILED)
+            buf = NULL;
         else
         {
-            pglob = &globlk;
-            doglob(argv[argnum],pglob);
+#ifdef MADV_SEQUENTIAL
+            madvise(buf,st.st_size,MADV_SEQUENTIAL);
+#endif
+            *len = st.st_size;
+            *mapped = TRUE;
         }
+    }
 
-        for (ifile = 0; ifile < pglob->gl_pathc; ++ifile)
+    if (!*mapped)
+    {
+        size = 0;
+        for (;;)
         {
-            matched = finalmatched = errorlines = 0;
-            ++numfiles;
-
-            if (strcmp(pglob->gl_pathv[ifile],"-") == 0)
+            if (*len == size)
+            {
+                size = 2*size + 65536;
+                if ((buf = (char*)realloc(buf,size)) == NULL)
+                {
+                    fprintf(stderr,">E malloc failed in map_file()\n");
+                    exit(1);
+                }
+            }
+            got = read(fd,buf+*len,size-*len);
+            if (got <= 0) break;
+            *len += got;
+        }
+    }
+
+    if (fd != 0) close(fd);
+    return buf;
+}
+
+/****************************************************************************/
+
+static void
+match_file(fileresult *fr, char *line, char *outf,
+           number *val, int *valtype, scanspace *sp)
+/* Match the lines of one file like main() does, making records. */
+{
+    char *buf,*p,*end,*nl;
+    size_t len,k,j;
+    boolean mapped;
+    unsigned long line_number;
+    integer seq;
+    int i,nvals,c,m;
+    boolean done;
+
+    if ((buf = map_file(fr->name,&len,&mapped)) == NULL)
+    {
+        fr->openfailed = TRUE;
+        return;
+    }
+
+    line_number = 0;
+    for (p = buf, end = buf + len; p < end; p += k)
+    {
+     /* The same pieces as readoneline(): up to MAXLINELEN-1 characters,
+        ending after the first \n. */
+        k = end - p;
+        if (k > MAXLINELEN-1) k = MAXLINELEN-1;
+        if ((nl = (char*)memchr(p,'\n',k)) != NULL) k = nl - p + 1;
+        memcpy(line,p,k);
+        line[k] = '\0';
+        if (memchr(line,'\0',k) != NULL)
+            for (j = 0; j < k; ++j) if (line[j] == '\0') ++fr->nullcount;
+
+        line[MAXLINELEN] = '\n';
+        line[MAXLINELEN+1] = '\0';
+        if (line[0] == '\n') continue;
+        ++line_number;
+
+        done = FALSE;
+        c = (unsigned char)line[0];
+        for (m = cand_start[c]; m < cand_start[c+1] && !done; ++m)
+        {
+            i = cand_list[m];
+            if (!may_match(i,line,strlen(line))) continue;
+            nvals = scanline(line,format[i].fmt,val,valtype,&seq,outf,sp);
+            if (nvals >= 0)
+            {
+                if (HAS(i,ENDFILE)) line_number = 0;
+                add_record(fr,i,nvals,val,valtype,seq,line_number,outf);
+                done = !HAS(i,CONTINUE);
+            }
+        }
+
+        if (!done) ++fr->unmatched;
+    }
+
+    if (mapped) munmap(buf,len);
+    else        free(buf);
+}
+
+/****************************************************************************/
+
+static void*
+match_thread(void *arg)
+/* Take files and match them until there are none left. */
+{
+    char *line,*outf;
+    number val[MAXVALUES];
+    int valtype[MAXVALUES];
+    scanspace *sp;
+    unsigned long k;
+
+    if ((line = (char*)malloc(MAXLINELEN+2)) == NULL
+        || (outf = (char*)malloc(MAXLINELEN+MAXVALUES+6)) == NULL
+        || (sp = (scanspace*)malloc(sizeof(scanspace))) == NULL)
+    {
+        fprintf(stderr,">E malloc failed in match_thread()\n");
+        exit(1);
+    }
+    init_scanspace(sp);
+
+    for (;;)
+    {
+        pthread_mutex_lock(&par.lock);
+        while (par.nextfile < par.nfiles
+               && par.nextfile >= par.firstpending + par.window)
+            pthread_cond_wait(&par.roomfree,&par.lock);
+        k = par.nextfile;
+        if (k < par.nfiles) ++par.nextfile;
+        pthread_mutex_unlock(&par.lock);
+        if (k >= par.nfiles) break;
+
+        match_file(&par.file[k],line,outf,val,valtype,sp);
+
+        pthread_mutex_lock(&par.lock);
+        par.file[k].done = TRUE;
+        pthread_cond_broadcast(&par.filedone);
+        pthread_mutex_unlock(&par.lock);
+    }
+
+    free(line);
+    free(outf);
+    return NULL;
+}
+
+/****************************************************************************/
+
+static void
+parallel_files(glob_t *pglob, int nthreads,
+               boolean havefinal, boolean nowarn, boolean noWarn,
+               unsigned long *numfiles, unsigned long *unmatched,
+               unsigned long *totalerrorlines)
+/* Do all the files in pglob with nthreads threads (see above). */
+{
+    pthread_t *tid;
+    unsigned long k;
+    int t;
+    fileresult *fr;
+    char *p,*filename;
+    matchrec *r;
+    unsigned long matched,finalmatched,errorlines;
+
+    if (pglob->gl_pathc == 0) return;
+
+    par.nfiles = pglob->gl_pathc;
+    par.nextfile = par.firstpending = 0;
+    par.window = 8*nthreads;
+    if ((par.file = (fileresult*)calloc(par.nfiles,sizeof(fileresult)))
+                 == NULL
+        || (tid = (pthread_t*)malloc(nthreads*sizeof(pthread_t))) == NULL)
+    {
+        fprintf(stderr,">E malloc failed in parallel_files()\n");
+        exit(1);
+    }
+    for (k = 0; k < par.nfiles; ++k) par.file[k].name = pglob->gl_pathv[k];
+
+    pthread_mutex_init(&par.lock,NULL);
+    pthread_cond_init(&par.filedone,NULL);
+    pthread_cond_init(&par.roomfree,NULL);
+
+    for (t = 0; t < nthreads; ++t)
+        if (pthread_create(&tid[t],NULL,match_thread,NULL) != 0)
+        {
+            fprintf(stderr,">E pthread_create() failed\n");
+            exit(1);
+        }
+
+    for (k = 0; k < par.nfiles; ++k)
+    {
+        fr = &par.file[k];
+        pthread_mutex_lock(&par.lock);
+        while (!fr->done) pthread_cond_wait(&par.filedone,&par.lock);
+        pthread_mutex_unlock(&par.lock);
+
+        ++*numfiles;
+        if (strcmp(fr->name,"-") == 0)
+            filename = "stdin";
+        else
+            filename = fr->name;
+        if (fr->openfailed)
+        {
+            fprintf(stderr,">E Can't open %s\n",filename);
+            exit(1);
+        }
+
+        matched = finalmatched = errorlines = 0;
+        for (p = fr->rec; p < fr->rec + fr->reclen; p += r->size)
+        {
+            r = (matchrec*)p;
+            ++matched;
+            if (HAS(r->fmt,FINAL)) ++finalmatched;
+            if (HAS(r->fmt,ERROR)) ++errorlines;
+            accept_match(r->fmt,RECOUTF(r),r->nvals,RECVAL(r),RECVALTYPE(r),
+                         r->seq,r->line_number,noWarn);
+            free_record(r);
+        }
+        *unmatched += fr->unmatched;
+        file_warnings(filename,matched,finalmatched,errorlines,
+                      fr->nullcount,havefinal,nowarn);
+        *totalerrorlines += errorlines;
+        free(fr->rec);
+
+        pthread_mutex_lock(&par.lock);
+        par.firstpending = k+1;
+        pthread_cond_broadcast(&par.roomfree);
+        pthread_mutex_unlock(&par.lock);
+    }
+
+    for (t = 0; t < nthreads; ++t) pthread_join(tid[t],NULL);
+
+    pthread_mutex_destroy(&par.lock);
+    pthread_cond_destroy(&par.filedone);
+    pthread_cond_destroy(&par.roomfree);
+    free(par.file);
+    free(tid);
+}
+
+#endif
+
+/****************************************************************************/
+
+/* With -s statefile, everything needed for the output is saved in
+   statefile at the end: for each format the totals and the other
+   counters, and for each input file how much of it has been read (with
+   its inode, size and modification time).  The next run with the same
+   statefile starts from these and reads only the new files and what has
+   been appended to the others.  A last line without \n is used for the
+   output but not saved, so it is read again next time.  If a file has
+   been replaced or has become shorter (or the last bytes read from it
+   are different), a file of the last run is gone, or the formats are
+   different, everything is read again. */
+
+#define LASTBYTES 32   /* How many bytes before the offset are checked */
+
+typedef struct
+{
+    char *name;
+    boolean used;            /* Found again in this run */
+    long long ino,size,mtime,mtimensec;
+    long long offset;        /* Bytes read into the saved totals */
+    long long tail;          /* Start of a last line without \n, or -1 */
+    unsigned long line_number,matched,finalmatched,errorlines,
+                  nullcount,unmatched;
+    char last[2*LASTBYTES+1];  /* The bytes before offset, in hex */
+} filestate;
+
+static filestate *oldfiles;  /* The files in the state file */
+static unsigned long numoldfiles;
+
+/****************************************************************************/
+
+static int
+node_types(char *fmt, int *valtype)
+/* Find the types of the totals of a node from its output format, read
+   the same way as in writeline().  Only D, F, M and LD are used.
+   Return the number of totals. */
+{
+    int n;
+
+    n = 0;
+    for (; *fmt != '\0'; ++fmt)
+    {
+        if (*fmt != '%') continue;
+        ++fmt;
+        if (*fmt == '-' || isdigit(*fmt)) (void)readwidth(&fmt);
+        if (*fmt == '%' || *fmt == '#')
+            continue;
+        else if (*fmt == 'd' || *fmt == 'x' || *fmt == 'n' || *fmt == 'p')
+            valtype[n++] = D;
+        else if (*fmt == 'l')
+            valtype[n++] = LD;
+#if GMP
+        else if (*fmt == 'm')
+            valtype[n++] = M;
+#endif
+        else
+            valtype[n++] = F;
+    }
+
+    return n;
+}
+
+/****************************************************************************/
+
+static void
+write_string(FILE *f, char *s)
+{
+    fprintf(f,"%lu:",(unsigned long)strlen(s));
+    fputs(s,f);
+}
+
+/****************************************************************************/
+
+static char*
+read_string(FILE *f)
+/* Read a string written by write_string(), or return NULL. */
+{
+    unsigned long len;
+    char *s;
+
+    if (fscanf(f," %lu:",&len) != 1 || len > 100*MAXLINELEN) return NULL;
+    if ((s = (char*)malloc(len+1)) == NULL)
+    {
+        fprintf(stderr,">E malloc failed in read_string()\n");
+        exit(1);
+    }
+    if (fread(s,1,len,f) != len)
+    {
+        free(s);
+        return NULL;
+    }
+    s[len] = '\0';
+    return s;
+}
+
+/****************************************************************************/
+
+static void
+write_tree(FILE *f, countnode *root)
+/* Write the nodes of the tree in order (non-recursively, as in
+   print_counts()), one per line: count, output format and totals,
+   and then a line "0". */
+{
+    int code,i,j,nval;
+    int valtype[MAXVALUES];
+    countnode *p;
+
+    p = root;
+    code = A;
+
+    while (p)
+    {
+        switch (code)    /* deliberate flow-ons */
+        {
+         case A:
+            if (p->left)
+            {
+                p = p->left;
+                break;
+            }
+         case L:
+            fprintf(f,"%lu ",p->count);
+            write_string(f,p->fmt);
+            nval = node_types(p->fmt,valtype);
+            for (i = 0; i < nval; ++i)
+            {
+                if (valtype[i] == D)
+                    fprintf(f," %lld",p->total[i].d);
+                else if (valtype[i] == LD)
+                {
+                    fprintf(f," %d",p->total[i].l->nvals);
+                    for (j = 0; j < p->total[i].l->nvals; ++j)
+                        fprintf(f," %lld",p->total[i].l->val[j]);
+                }
+#if GMP
+                else if (valtype[i] == M)
+                {
+                    fprintf(f," ");
+                    mpz_out_str(f,10,*(p->total[i].m));
+                }
+#endif
+                else
+                    fprintf(f," %a",p->total[i].f);
+            }
+            fprintf(f,"\n");
+            if (p->right)
+            {
+                p = p->right;
+                code = A;
+                break;
+            }
+         case R:
+            if (p->parent && p->parent->left == p) code = L;
+            else                                   code = R;
+            p = p->parent;
+            break;
+        }
+    }
+    fprintf(f,"0\n");
+}
+
+/****************************************************************************/
+
+static void
+reset_totals(int numformats)
+/* Forget all totals (the trees are not freed). */
+{
+    int i;
+
+    for (i = 0; i < numformats; ++i)
+    {
+        count_root[i] = NULL;
+        matching_lines[i] = 0;
+        total_position[i] = 0;
+        lastseq[i] = 0;
+    }
+}
+
+/****************************************************************************/
+
+static boolean
+read_state(char *statename, int numformats)
+/* Read the state file into the totals and oldfiles[].  Return FALSE if
+   there is none or it doesn't fit (then nothing has been changed). */
+{
+    FILE *f;
+    int i,j,k,nf,flags,nval;
+    unsigned long count,ul;
+    integer pmod;
+    char *s;
+    number val[MAXVALUES];
+    int valtype[MAXVALUES];
+    integerlist lst[MAXVALUES];
+    filestate *fs;
+    boolean ok;
+    char word[8];
+
+    if ((f = fopen(statename,"r")) == NULL) return FALSE;
+
+    ok = fscanf(f,"sumlines state 1 formats %d",&nf) == 1
+         && nf == numformats;
+    for (i = 0; ok && i < numformats; ++i)
+    {
+        ok = fscanf(f," %d %lld",&flags,&pmod) == 2
+             && (s = read_string(f)) != NULL;
+        if (ok)
+        {
+            ok = flags == format[i].flags && pmod == format[i].pmod
+                 && strcmp(s,format[i].fmt) == 0;
+            free(s);
+        }
+    }
+
+    for (i = 0; i < MAXVALUES; ++i) lst[i].val = NULL;
+
+    for (i = 0; ok && i < numformats; ++i)
+    {
+        ok = fscanf(f," format %lu %lld %lld",&matching_lines[i],
+                    &total_position[i],&lastseq[i]) == 3;
+        while (ok)
+        {
+            ok = fscanf(f," %lu",&count) == 1;
+            if (!ok || count == 0) break;
+            if ((s = read_string(f)) == NULL)
+            {
+                ok = FALSE;
+                break;
+            }
+            nval = node_types(s,valtype);
+            for (j = 0; ok && j < nval; ++j)
+            {
+                if (valtype[j] == D)
+                    ok = fscanf(f," %lld",&val[j].d) == 1;
+                else if (valtype[j] == LD)
+                {
+                    val[j].l = &lst[j];
+                    ok = fscanf(f," %d",&lst[j].nvals) == 1
+                         && lst[j].nvals >= 0;
+                    if (!ok) break;
+                    if ((lst[j].val = (integer*)realloc(lst[j].val,
+                                 sizeof(integer)*(lst[j].nvals+1))) == NULL)
+                    {
+                        fprintf(stderr,">E malloc failed in read_state()\n");
+                        exit(1);
+                    }
+                    for (k = 0; ok && k < lst[j].nvals; ++k)
+                        ok = fscanf(f," %lld",&lst[j].val[k]) == 1;
+                }
+#if GMP
+                else if (valtype[j] == M)
+                {
+                    val[j].m = &mainspace.mp_value[j];
+                    ok = mpz_inp_str(mainspace.mp_value[j],f,10) > 0;
+                }
+#endif
+                else
+                    ok = fscanf(f," %lf",&val[j].f) == 1;
+            }
+            if (ok)
+            {
+                add_one(&count_root[i],s,format[i].pmod,nval,
+                        val,valtype,i,HAS(i,NUMERIC));
+                count_root[i]->count = count;
+            }
+            free(s);
+        }
+    }
+
+    for (i = 0; i < MAXVALUES; ++i) free(lst[i].val);
+
+    if (ok) ok = fscanf(f," files %lu",&numoldfiles) == 1;
+    if (ok && numoldfiles > 0)
+    {
+        if ((oldfiles = (filestate*)calloc(numoldfiles,sizeof(filestate)))
+                 == NULL)
+        {
+            fprintf(stderr,">E malloc failed in read_state()\n");
+            exit(1);
+        }
+    }
+    for (ul = 0; ok && ul < numoldfiles; ++ul)
+    {
+        fs = &oldfiles[ul];
+        ok = fscanf(f," %lld %lld %lld %lld %lld %lu %lu %lu %lu %lu %lu",
+                    &fs->ino,&fs->size,&fs->mtime,&fs->mtimensec,
+                    &fs->offset,&fs->line_number,&fs->matched,
+                    &fs->finalmatched,&fs->errorlines,&fs->nullcount,
+                    &fs->unmatched) == 11
+             && (s = read_string(f)) != NULL;
+        if (ok)
+        {
+            ok = strlen(s) <= 2*LASTBYTES;
+            if (ok) strcpy(fs->last,s);
+            free(s);
+            ok = ok && (fs->name = read_string(f)) != NULL;
+        }
+        fs->tail = -1;
+        fs->used = FALSE;
+    }
+
+    if (ok) ok = fscanf(f," %7s",word) == 1 && strcmp(word,"end") == 0;
+    fclose(f);
+
+    if (!ok)
+    {
+        fprintf(stderr,">W state file %s is not usable, reading everything\n",
+                statename);
+        reset_totals(numformats);
+        numoldfiles = 0;
+    }
+    return ok;
+}
+
+/****************************************************************************/
+
+static void
+write_state(char *statename, int numformats,
+            filestate *files, unsigned long nfiles)
+/* Write the state file (first to statename.tmp, then renamed). */
+{
+    FILE *f;
+    char *tmpname;
+    int i;
+    unsigned long k;
+    filestate *fs;
+
+    if ((tmpname = (char*)malloc(strlen(statename)+5)) == NULL)
+    {
+        fprintf(stderr,">E malloc failed in write_state()\n");
+        exit(1);
+    }
+    sprintf(tmpname,"%s.tmp",statename);
+
+    if ((f = fopen(tmpname,"w")) == NULL)
+    {
+        fprintf(stderr,">E Can't open %s for writing\n",tmpname);
+        exit(1);
+    }
+
+    fprintf(f,"sumlines state 1\nformats %d\n",numformats);
+    for (i = 0; i < numformats; ++i)
+    {
+        fprintf(f,"%d %lld ",format[i].flags,format[i].pmod);
+        write_string(f,format[i].fmt);
+        fprintf(f,"\n");
+    }
+
+    for (i = 0; i < numformats; ++i)
+    {
+        fprintf(f,"format %lu %lld %lld\n",
+                matching_lines[i],total_position[i],lastseq[i]);
+        write_tree(f,count_root[i]);
+    }
+
+    fprintf(f,"files %lu\n",nfiles);
+    for (k = 0; k < nfiles; ++k)
+    {
+        fs = &files[k];
+        fprintf(f,"%lld %lld %lld %lld %lld %lu %lu %lu %lu %lu %lu ",
+                fs->ino,fs->size,fs->mtime,fs->mtimensec,fs->offset,
+                fs->line_number,fs->matched,fs->finalmatched,
+                fs->errorlines,fs->nullcount,fs->unmatched);
+        write_string(f,fs->last);
+        fprintf(f," ");
+        write_string(f,fs->name);
+        fprintf(f,"\n");
+    }
+    fprintf(f,"end\n");
+
+    if (ferror(f) || fclose(f) != 0 || rename(tmpname,statename) != 0)
+    {
+        fprintf(stderr,">E Can't write state file %s\n",statename);
+        exit(1);
+    }
+    free(tmpname);
+}
+
+/****************************************************************************/
+
+static void
+last_bytes(FILE *infile, filestate *fs, char *hex)
+/* Put the bytes before fs->offset into hex. */
+{
+    unsigned char buf[LASTBYTES];
+    size_t n,i;
+
+    n = (fs->offset < LASTBYTES ? fs->offset : LASTBYTES);
+    if (fseeko(infile,(off_t)(fs->offset-n),SEEK_SET) != 0
+        || fread(buf,1,n,infile) != n)
+        n = 0;
+    for (i = 0; i < n; ++i) sprintf(hex+2*i,"%02x",buf[i]);
+    hex[2*n] = '\0';
+}
+
+/****************************************************************************/
+
+static boolean
+unchanged(filestate *fs)
+/* Check that the bytes before fs->offset are still the ones read. */
+{
+    FILE *infile;
+    char hex[2*LASTBYTES+1];
+
+    if (fs->offset == 0) return TRUE;
+    if ((infile = fopen(fs->name,"r")) == NULL) return FALSE;
+    last_bytes(infile,fs,hex);
+    fclose(infile);
+
+    return strcmp(hex,fs->last) == 0;
+}
+
+/****************************************************************************/
+
+static void
+read_from(filestate *fs, boolean savetail, int numformats, boolean noWarn)
+/* Read fs->name from fs->offset (or fs->tail if savetail is FALSE).
+   If savetail is TRUE, stop at a last line without \n and note where it
+   starts in fs->tail; the offset is moved past what was read. */
+{
+    FILE *infile;
+    char line[MAXLINELEN+2];
+    int len,nulls;
+
+    if ((infile = fopen(fs->name,"r")) == NULL
+        || fseeko(infile,(off_t)(savetail ? fs->offset : fs->tail),
+                  SEEK_SET) != 0)
+    {
+        fprintf(stderr,">E Can't open %s\n",fs->name);
+        exit(1);
+    }
+
+    while ((len = readoneline(infile,line,MAXLINELEN,&nulls)) > 0)
+    {
+        if (savetail && line[len-1] != '\n' && len < MAXLINELEN-1)
+        {
+            fs->tail = fs->offset;
+            break;
+        }
+        if (savetail) fs->offset += len;
+
+        fs->nullcount += nulls;
+        line[MAXLINELEN] = '\n';
+        line[MAXLINELEN+1] = '\0';
+        if (line[0] == '\n') continue;
+        ++fs->line_number;
+
+        if (!match_line(line,numformats,&fs->line_number,&fs->matched,
+                        &fs->finalmatched,&fs->errorlines,noWarn))
+            ++fs->unmatched;
+    }
+
+    if (savetail) last_bytes(infile,fs,fs->last);
+    fclose(infile);
+}
+
+/****************************************************************************/
+
+static void
+incremental_files(char *statename, int nargs, char **args, int numformats,
+                  boolean havefinal, boolean nowarn, boolean noWarn,
+                  unsigned long *numfiles, unsigned long *unmatched,
+                  unsigned long *totalerrorlines)
+/* Do the input files with the state file (see above). */
+{
+    glob_t globlk;
+    filestate *files,*fs;
+    unsigned long nfiles,filessize,k,hint,old,firsttail;
+    int argnum;
+    size_t ifile;
+    struct stat st;
+    boolean rescan;
+
+    rescan = !read_state(statename,numformats);
+    nfiles = filessize = hint = 0;
+    files = NULL;
+
+    for (argnum = 0; argnum < nargs; ++argnum)
+    {
+        if (strcmp(args[argnum],"-") == 0)
+        {
+            fprintf(stderr,">E -s can't be used with stdin\n");
+            exit(1);
+        }
+        doglob(args[argnum],&globlk);
+
+        for (ifile = 0; ifile < globlk.gl_pathc; ++ifile)
+        {
+            if (nfiles == filessize)
+            {
+                filessize = 2*filessize + 1024;
+                if ((files = (filestate*)realloc(files,
+                                     filessize*sizeof(filestate))) == NULL)
+                {
+                    fprintf(stderr,">E malloc failed in incremental_files()\n");
+                    exit(1);
+                }
+            }
+            fs = &files[nfiles++];
+
+         /* Usually the files come in the same order as last time. */
+            for (old = hint; old < numoldfiles; ++old)
+                if (!oldfiles[old].used
+                    && strcmp(oldfiles[old].name,globlk.gl_pathv[ifile]) == 0)
+                    break;
+            if (old == numoldfiles)
+            {
+                for (old = 0; old < hint; ++old)
+                    if (!oldfiles[old].used
+                        && strcmp(oldfiles[old].name,
+                                  globlk.gl_pathv[ifile]) == 0)
+                        break;
+                if (old == hint) old = numoldfiles;
+            }
+
+            if (stat(globlk.gl_pathv[ifile],&st) != 0)
+            {
+                fprintf(stderr,">E Can't open %s\n",globlk.gl_pathv[ifile]);
+                exit(1);
+            }
+
+            if (old < numoldfiles)
+            {
+                *fs = oldfiles[old];
+                oldfiles[old].used = TRUE;
+                hint = old + 1;
+                if (fs->ino != (long long)st.st_ino
+                    || fs->offset > (long long)st.st_size
+                    || (fs->size == (long long)st.st_size
+                        && (fs->mtime != (long long)st.st_mtim.tv_sec
+                          || fs->mtimensec != (long long)st.st_mtim.tv_nsec))
+                    || (fs->size != (long long)st.st_size && !rescan
+                        && !unchanged(fs)))
+                    rescan = TRUE;
+            }
+            else
+            {
+                memset(fs,0,sizeof(filestate));
+                if ((fs->name = strdup(globlk.gl_pathv[ifile])) == NULL)
+                {
+                    fprintf(stderr,">E malloc failed in incremental_files()\n");
+                    exit(1);
+                }
+            }
+            fs->ino = st.st_ino;
+            fs->size = st.st_size;
+            fs->mtime = st.st_mtim.tv_sec;
+            fs->mtimensec = st.st_mtim.tv_nsec;
+            fs->tail = -1;
+        }
+        globfree(&globlk);
+    }
+
+    for (old = 0; old < numoldfiles; ++old)
+        if (!oldfiles[old].used) rescan = TRUE;
+
+    if (rescan && numoldfiles > 0)
+    {
+        fprintf(stderr,">W files have changed since the state was saved,"
+                       " reading everything\n");
+        reset_totals(numformats);
+    }
+    if (rescan)
+        for (k = 0; k < nfiles; ++k)
+        {
+            fs = &files[k];
+            fs->offset = 0;
+            fs->line_number = fs->matched = fs->finalmatched = 0;
+            fs->errorlines = fs->nullcount = fs->unmatched = 0;
+        }
+
+   /* The messages for each file come right after it is read, as
+      without -s.  A last line without \n can only be read after the
+      state is written, so from the first file that has one on the
+      messages wait for that. */
+    firsttail = nfiles;
+    for (k = 0; k < nfiles; ++k)
+    {
+        fs = &files[k];
+        if (fs->offset < fs->size) read_from(fs,TRUE,numformats,noWarn);
+        if (fs->tail >= 0 && firsttail == nfiles) firsttail = k;
+        if (firsttail == nfiles)
+            file_warnings(fs->name,fs->matched,fs->finalmatched,
+                          fs->errorlines,fs->nullcount,havefinal,nowarn);
+    }
+
+    write_state(statename,numformats,files,nfiles);
+
+    for (k = firsttail; k < nfiles; ++k)
+    {
+        fs = &files[k];
+        if (fs->tail >= 0) read_from(fs,FALSE,numformats,noWarn);
+        file_warnings(fs->name,fs->matched,fs->finalmatched,fs->errorlines,
+                      fs->nullcount,havefinal,nowarn);
+    }
+
+    for (k = 0; k < nfiles; ++k)
+    {
+        ++*numfiles;
+        *unmatched += files[k].unmatched;
+        *totalerrorlines += files[k].errorlines;
+    }
+}
+
+/****************************************************************************/
+
+int
+main(int argc, char *argv[])
+{
+    int i,j,argnum;
+    char line[MAXLINELEN+2];
+    unsigned long matched,unmatched,finalmatched;
+    unsigned long errorlines,totalerrorlines;
+    unsigned long line_number,nullcount,numfiles,ifile;
+    char *filename;
+    FILE *infile;
+    int numformats,firstarg,nulls;
+    boolean havefinal,nowarn,noWarn,listformats,readfiles;
+    int order[MAXFORMATS];
+    glob_t globlk,globlk_stdin,*pglob;
+    char *glob_stdin_v[2];
+    boolean printcounts;
+    int nthreads;
+    char *statename;
+
+    HELP;
+
+    find_maxint();
+
+    firstarg = 1;
+    numformats = 0;
+    nowarn = noWarn = FALSE;
+    listformats = FALSE;
+    readfiles = TRUE;
+    printcounts = TRUE;
+    nthreads = 1;
+    statename = NULL;
+
+    globlk_stdin.gl_pathc = 1;
+    globlk_stdin.gl_pathv = glob_stdin_v;
+    glob_stdin_v[0] = "-";
+    glob_stdin_v[1] = NULL;
+
+    dout = DOUT;
+    fout = FOUT;
+    vout = VOUT;
+    Xout = FOUT;
+    hmsout1 = HMSOUT1;
+    hmsout2 = HMSOUT2;
+
+    for (; firstarg < argc; ++firstarg)
+    {
+        if (argv[firstarg][0] == '-' && argv[firstarg][1] == 'f')
+        {
+            if (argv[firstarg][2] != '\0')
+                read_formats(&argv[firstarg][2],&numformats,TRUE);
+            else if (firstarg == argc - 1)
+            {
+                fprintf(stderr,">E No argument for -f\n");
+                exit(1);
+            }
+            else
+            {
+                ++firstarg;
+                read_formats(argv[firstarg],&numformats,TRUE);
+            }
+        }
+        else if (strcmp(argv[firstarg],"-W") == 0)
+            noWarn = TRUE;
+        else if (strcmp(argv[firstarg],"-w") == 0)
+            nowarn = TRUE;
+        else if (strcmp(argv[firstarg],"-v") == 0)
+            listformats = TRUE;
+        else if (strcmp(argv[firstarg],"-d") == 0)
+            readfiles = FALSE;
+        else if (strcmp(argv[firstarg],"-n") == 0)
+            printcounts = FALSE;
+        else if (argv[firstarg][0] == '-' && argv[firstarg][1] == 'j')
+        {
+            nthreads = atoi(&argv[firstarg][2]);
+            if (nthreads < 1)
+            {
+                fprintf(stderr,">E Bad value for -j\n");
+                exit(1);
+            }
+#if !THREADS
+            if (nthreads > 1)
+            {
+                fprintf(stderr,">W not compiled with THREADS, ignoring -j\n");
+                nthreads = 1;
+            }
+#endif
+        }
+        else if (strcmp(argv[firstarg],"-s") == 0)
+        {
+            if (firstarg == argc - 1)
+            {
+                fprintf(stderr,">E No argument for -s\n");
+                exit(1);
+            }
+            statename = argv[++firstarg];
+        }
+        else if (strcmp(argv[firstarg],"-V") == 0)
+            vout = argv[++firstarg];
+        else if (strcmp(argv[firstarg],"-F") == 0)
+            fout = argv[++firstarg];
+        else if (strcmp(argv[firstarg],"-D") == 0)
+            dout = argv[++firstarg];
+        else
+            break;
+    }
+
+    init_scanspace(&mainspace);
+
+    if (noWarn) nowarn = TRUE;
+
+    if (readfiles) read_local_formats(&numformats);
+    if (readfiles) read_env_formats(&numformats);
+    if (readfiles) read_global_formats(&numformats);
+
+    if (listformats)
+    {
+        printf("%d formats:\n",numformats);
+        for (i = 0; i < numformats; ++i)
+            printf("%03x %s",format[i].flags,format[i].fmt);
+    }
+
+    if (numformats == 0)
+    {
+        fprintf(stderr,">E No formats\n");
+        exit(1);
+    }
+
+    compile_formats(numformats);
+
+    havefinal = FALSE;
+    for (i = 0; i < numformats; ++i)
+    {
+        count_root[i] = NULL;
+        matching_lines[i] = 0;
+        total_position[i] = 0;
+        if (HAS(i,FINAL)) havefinal = TRUE;
+    }
+
+    unmatched = totalerrorlines = 0;
+    numfiles = 0;
+
+    if (statename != NULL)
+    {
+        if (argc == firstarg)
+        {
+            fprintf(stderr,">E -s can't be used with stdin\n");
+            exit(1);
+        }
+        incremental_files(statename,argc-firstarg,argv+firstarg,numformats,
+                          havefinal,nowarn,noWarn,
+                          &numfiles,&unmatched,&totalerrorlines);
+        argnum = argc;   /* No more files */
+    }
+    else
+        argnum = firstarg;
+
+    for (; argnum < (argc == firstarg ? argc+1 : argc); ++argnum)
+    {
+        if (argnum >= argc || strcmp(argv[argnum],"-") == 0)
+            pglob = &globlk_stdin;
+        else
+        {
+            pglob = &globlk;
+            doglob(argv[argnum],pglob);
+        }
+
+#if THREADS
+        if (nthreads > 1)
+        {
+            parallel_files(pglob,nthreads,havefinal,nowarn,
+                           noWarn,&numfiles,&unmatched,&totalerrorlines);
+            if (pglob == &globlk) globfree(pglob);
+            continue;
+        }
+#endif
+
+        for (ifile = 0; ifile < pglob->gl_pathc; ++ifile)
+        {
+            matched = finalmatched = errorlines = 0;
+            ++numfiles;
+
+            if (strcmp(pglob->gl_pathv[ifile],"-") == 0)
             {
                 filename = "stdin";
                 infile = stdin;
@@ -1716,61 +3052,12 @@ main(int argc, char *argv[])
                 if (line[0] == '\n') continue;
                 ++line_number;
     
-                for (i = 0; i < numformats; ++i)
-                {
-                    nvals
-                      = scanline(line,format[i].fmt,val,valtype,&seq,outf);
-                    if (nvals >= 0)
-                    {
-                        if (HAS(i,ENDFILE)) line_number = 0;
-                        ++matched;
-                        if (HAS(i,FINAL)) ++finalmatched;
-                        if (HAS(i,ERROR)) ++errorlines;
-                        ++matching_lines[i];
-                        total_position[i] += line_number;
-                        add_one(&count_root[i],outf,format[i].pmod,nvals,
-                             val,valtype,i,HAS(i,NUMERIC));
-                        if (!noWarn && matching_lines[i] > 1 && seq >= 0 
-                                               && seq != lastseq[i]+1)
-                        {
-                            printf("WARNING: Sequence number");
-                            if (seq == lastseq[i])
-                            {   
-                                printf(" ");
-                                printf(dout,1,seq);
-                                printf(" is repeated.\n");
-                            }
-                            else if (seq != lastseq[i]+2)
-                            {
-                                printf("s ");
-                                printf(dout,1,lastseq[i]+1);
-                                printf("-");
-                                printf(dout,1,seq-1);
-                                printf(" are missing.\n");
-                            }
-                            else
-                            {
-                                printf("  ");
-                                printf(dout,1,seq-1);
-                                printf(" is missing.\n");
-                            }
-                        }
-                        lastseq[i] = seq;
-                        if (!HAS(i,CONTINUE)) break;
-                    }
-                }
-    
-                if (i == numformats) ++unmatched;
+                if (!match_line(line,numformats,&line_number,&matched,
+                                &finalmatched,&errorlines,noWarn))
+                    ++unmatched;
             }
-            if (errorlines != 0)
-                printf("ERRORS: Error lines in file %s\n",filename);
-            else if (matched == 0 && !nowarn)
-                printf("WARNING: No matching lines in file %s\n",filename);
-            else if (finalmatched == 0 && havefinal && !nowarn)
-                printf("WARNING: No final lines in file %s\n",filename);
-            if (nullcount > 0)
-                printf("WARNING: %ld NULs found in file %s\n",
-                                                        nullcount,filename);
+            file_warnings(filename,matched,finalmatched,errorlines,
+                          nullcount,havefinal,nowarn);
             if (infile != stdin) fclose(infile);
 
             totalerrorlines += errorlines;